@@ -1,4 +1,5 @@
-# File searches for test.sh script in each module subdirectory and runs it if present
+# File builds tests of the common library and searches for test.sh script in each module
+# subdirectory and runs it if present
 
 file(GLOB MODULE_DIRS RELATIVE ${CMAKE_SOURCE_DIR}/modules ${CMAKE_SOURCE_DIR}/modules/*)
 enable_testing()
@@ -8,6 +9,9 @@ add_custom_target(tests
 	VERBATIM
 )
 
+add_subdirectory(${CMAKE_SOURCE_DIR}/common/tests ${CMAKE_BINARY_DIR}/common/tests)
+add_dependencies(tests counterTest csvLineTest histogramTest)
+
 foreach(MODULE ${MODULE_DIRS})
 	if (NOT IS_DIRECTORY ${CMAKE_SOURCE_DIR}/modules/${MODULE})
 		continue()
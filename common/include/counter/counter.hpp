@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @brief Counters of module statistics read by the telemetry thread.
+ *
+ * Statistics are incremented by the thread processing records and read by the appFs thread, so
+ * plain integers are a data race. The counters use relaxed atomics: they order nothing, they
+ * only make every read see a value which was really written.
+ *
+ * Every statistic has a single writer. Modules matching records by several threads keep the
+ * statistics in per-thread contexts, e.g. the matching contexts of the list detector pipeline,
+ * and merge them on read, so no counter shared by several writing threads is needed.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Nm {
+
+/**
+ * @brief Counter incremented by one thread and read by any thread.
+ *
+ * The increment is a relaxed load and store of the owner, which compiles to a plain addition
+ * without the lock prefix. It is suitable for counters of per-thread structures, e.g. matching
+ * contexts merged on read, and for large arrays of counters, as it occupies only 8 bytes.
+ *
+ * Copies take a snapshot of the value, so the counter can be stored in a vector.
+ */
+class Counter {
+public:
+	Counter() noexcept = default;
+
+	Counter(const Counter& other) noexcept
+		: m_value(other.load())
+	{
+	}
+
+	Counter& operator=(const Counter& other) noexcept
+	{
+		m_value.store(other.load(), std::memory_order_relaxed);
+		return *this;
+	}
+
+	/**
+	 * @brief Adds the value to the counter. Must be called only by the owning thread.
+	 * @param value Value to add.
+	 */
+	void add(uint64_t value = 1) noexcept
+	{
+		m_value.store(m_value.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Sets the counter, e.g. to age it. Must be called only by the owning thread.
+	 * @param value New value of the counter.
+	 */
+	void store(uint64_t value) noexcept { m_value.store(value, std::memory_order_relaxed); }
+
+	/**
+	 * @brief Returns the current value of the counter.
+	 */
+	uint64_t load() const noexcept { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint64_t> m_value {0};
+};
+
+} // namespace Nm
@@ -0,0 +1,36 @@
+/**
+ * @file
+ * @brief Splitting of lines of the CSV configuration files of modules.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Nm {
+
+/**
+ * @brief Removes leading and trailing spaces and tabs of the cell.
+ * @param cell Cell of a CSV line.
+ * @return View of the cell without surrounding whitespace.
+ */
+std::string_view trimCell(std::string_view cell) noexcept;
+
+/**
+ * @brief Splits the line to trimmed cells separated by commas.
+ *
+ * A cell starting with a quote is quoted: commas inside it do not separate cells, surrounding
+ * quotes are removed and doubled quotes stand for one quote. Only a quote at the start of a cell
+ * begins a quoted cell, so cells like `R"(a,b)"` are split at their commas.
+ *
+ * @param line Line of a CSV file.
+ * @return Cells of the line.
+ * @throw std::runtime_error If a quoted cell is not terminated at the end of the line.
+ */
+std::vector<std::string> splitLine(std::string_view line);
+
+} // namespace Nm
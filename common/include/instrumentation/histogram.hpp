@@ -0,0 +1,104 @@
+/**
+ * @file
+ * @brief Declaration of the LogLinearHistogram class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "counter/counter.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Nm {
+
+/**
+ * @brief Histogram of values with a bounded relative error, e.g. of latencies.
+ *
+ * Values are counted in buckets of the HDR histogram layout: each power of two is divided into
+ * 2^`SUB_BUCKET_BITS` linear sub-buckets, so any 64-bit value is kept with the relative error
+ * below 1/16 in less than a thousand buckets. Recording a value is a bit scan and an increment
+ * of a `Counter`, so the histogram is written by one thread without locks and read by the
+ * telemetry thread at any time.
+ */
+class LogLinearHistogram {
+public:
+	/**
+	 * @brief Number of bits of the linear sub-buckets of each power of two.
+	 */
+	static inline const std::size_t SUB_BUCKET_BITS = 4;
+
+	/**
+	 * @brief Number of linear sub-buckets of each power of two.
+	 */
+	static inline const std::size_t SUB_BUCKETS_COUNT = std::size_t {1} << SUB_BUCKET_BITS;
+
+	/**
+	 * @brief Number of buckets covering all 64-bit values.
+	 */
+	static inline const std::size_t BUCKETS_COUNT
+		= (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS_COUNT;
+
+	/**
+	 * @brief Counts the value. Must be called only by the owning thread.
+	 * @param value Recorded value.
+	 */
+	void record(uint64_t value) noexcept
+	{
+		m_buckets[getBucketIndex(value)].add();
+		m_sum.add(value);
+	}
+
+	/**
+	 * @brief Returns the number of recorded values.
+	 */
+	uint64_t getCount() const noexcept;
+
+	/**
+	 * @brief Returns the sum of recorded values.
+	 */
+	uint64_t getSum() const noexcept;
+
+	/**
+	 * @brief Returns the value below or equal to which the fraction of recorded values is.
+	 *
+	 * The value is the upper bound of the bucket of the quantile, so it is at most 1/16 above
+	 * the exact quantile.
+	 *
+	 * @param quantile Fraction of values, e.g. 0.99.
+	 * @return Value of the quantile, 0 if no value was recorded.
+	 */
+	uint64_t getQuantile(double quantile) const noexcept;
+
+	/**
+	 * @brief Returns the index of the bucket of the value.
+	 * @param value Recorded value.
+	 */
+	static std::size_t getBucketIndex(uint64_t value) noexcept
+	{
+		if (value < SUB_BUCKETS_COUNT) {
+			return static_cast<std::size_t>(value);
+		}
+
+		// The leading bit selects the power of two, the following bits the linear sub-bucket
+		const auto exponent = static_cast<std::size_t>(63 - __builtin_clzll(value));
+		const std::size_t shift = exponent - SUB_BUCKET_BITS;
+		const auto subBucket = static_cast<std::size_t>(value >> shift) & (SUB_BUCKETS_COUNT - 1);
+		return (shift + 1) * SUB_BUCKETS_COUNT + subBucket;
+	}
+
+	/**
+	 * @brief Returns the highest value counted in the bucket.
+	 * @param bucketIndex Index of the bucket.
+	 */
+	static uint64_t getBucketUpperBound(std::size_t bucketIndex) noexcept;
+
+private:
+	std::array<Counter, BUCKETS_COUNT> m_buckets;
+	Counter m_sum;
+};
+
+} // namespace Nm
@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @brief Latency histograms of the phases of processing a record and their telemetry.
+ *
+ * Example output format, durations are in nanoseconds:
+ *
+ * @code
+ * receive.count = XXX
+ * receive.mean = XXX ns
+ * receive.p50 = XXX ns
+ * receive.p99 = XXX ns
+ * receive.p999 = XXX ns
+ * process.count = XXX
+ * ...
+ * @endcode
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "instrumentation/histogram.hpp"
+#include "instrumentation/timer.hpp"
+
+#include <memory>
+#include <telemetry.hpp>
+
+namespace Nm {
+
+/**
+ * @brief Latency histograms of the phases of processing a record, in ticks of the clock.
+ */
+struct ProcessingLatency {
+	LogLinearHistogram receive; ///< Receiving of a record from the input interface.
+	LogLinearHistogram process; ///< Processing of the record by the module.
+	LogLinearHistogram send; ///< Sending of the record to the output interface.
+};
+
+/**
+ * @brief Retrieves the count, mean and percentiles of each phase.
+ * @param latency Latency histograms of the module.
+ * @return telemetry::Content The telemetry data of the phases.
+ */
+telemetry::Content getProcessingLatencyTelemetry(const ProcessingLatency& latency);
+
+/**
+ * @brief Adds the `latency` file with the telemetry of the phases to the directory.
+ * @param directory Telemetry directory of the module.
+ * @param latency Latency histograms of the module, must outlive the file.
+ * @return The file, nullptr if the timers are not compiled in.
+ */
+std::shared_ptr<telemetry::File> addProcessingLatencyFile(
+	const std::shared_ptr<telemetry::Directory>& directory,
+	const ProcessingLatency& latency);
+
+} // namespace Nm
@@ -0,0 +1,141 @@
+/**
+ * @file
+ * @brief Timers recording durations of code sections to latency histograms.
+ *
+ * Timers are compiled only when the build defines `NM_NG_INSTRUMENTATION`, see the
+ * `NM_NG_ENABLE_INSTRUMENTATION` CMake option. Otherwise they are empty classes with empty
+ * inline methods, so they cost nothing in production builds.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "instrumentation/histogram.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+
+namespace Nm {
+
+/**
+ * @brief True if the timers are compiled in.
+ */
+#ifdef NM_NG_INSTRUMENTATION
+static constexpr bool g_IS_INSTRUMENTATION_ENABLED = true;
+#else
+static constexpr bool g_IS_INSTRUMENTATION_ENABLED = false;
+#endif
+
+/**
+ * @brief Clock of the timers.
+ *
+ * On x86-64 the clock reads the time stamp counter, which costs a few nanoseconds, and the
+ * ticks are converted to nanoseconds only when histograms are exported. Elsewhere it reads the
+ * monotonic clock in nanoseconds.
+ */
+class InstrumentationClock {
+public:
+	/**
+	 * @brief Returns the current time in ticks of the clock.
+	 */
+	static uint64_t now() noexcept
+	{
+#ifdef __x86_64__
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+										 std::chrono::steady_clock::now().time_since_epoch())
+										 .count());
+#endif
+	}
+
+	/**
+	 * @brief Returns the duration of a tick in nanoseconds.
+	 *
+	 * The time stamp counter is calibrated against the monotonic clock over the whole run of
+	 * the program, so the first call may wait up to 10 ms for the calibration.
+	 */
+	static double getNanosecondsPerTick();
+};
+
+#ifdef NM_NG_INSTRUMENTATION
+
+/**
+ * @brief Records durations of consecutive phases, e.g. receive, process and send of a record.
+ *
+ * Each lap records the time since the previous lap, or since the construction, so N phases
+ * cost N + 1 clock reads.
+ */
+class PhaseTimer {
+public:
+	PhaseTimer() noexcept
+		: m_start(InstrumentationClock::now())
+	{
+	}
+
+	/**
+	 * @brief Records the duration of the phase which has just ended and starts the next one.
+	 * @param histogram Histogram of the ended phase.
+	 */
+	void lap(LogLinearHistogram& histogram) noexcept
+	{
+		const uint64_t now = InstrumentationClock::now();
+		histogram.record(now - m_start);
+		m_start = now;
+	}
+
+private:
+	uint64_t m_start;
+};
+
+/**
+ * @brief Records the duration of the enclosing scope.
+ */
+class ScopedTimer {
+public:
+	/**
+	 * @brief Starts the timer.
+	 * @param histogram Histogram of the scope, recorded when the timer is destroyed.
+	 */
+	explicit ScopedTimer(LogLinearHistogram& histogram) noexcept
+		: m_histogram(histogram)
+		, m_start(InstrumentationClock::now())
+	{
+	}
+
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	~ScopedTimer() { m_histogram.record(InstrumentationClock::now() - m_start); }
+
+private:
+	LogLinearHistogram& m_histogram;
+	uint64_t m_start;
+};
+
+#else
+
+/**
+ * @brief Disabled timer of consecutive phases, which records nothing.
+ */
+class PhaseTimer {
+public:
+	void lap([[maybe_unused]] LogLinearHistogram& histogram) noexcept {}
+};
+
+/**
+ * @brief Disabled timer of the enclosing scope, which records nothing.
+ */
+class ScopedTimer {
+public:
+	explicit ScopedTimer([[maybe_unused]] LogLinearHistogram& histogram) noexcept {}
+};
+
+#endif
+
+} // namespace Nm
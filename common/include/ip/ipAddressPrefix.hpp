@@ -8,10 +8,12 @@
 
 #pragma once
 
+#include <cstddef>
 #include <unirec++/ipAddress.hpp>
+#include <utility>
 #include <vector>
 
-namespace ListDetector {
+namespace Nm {
 
 /**
  * @brief Represents an IP address with a specified prefix.
@@ -48,9 +50,28 @@ public:
 	 */
 	std::pair<std::vector<std::byte>, std::vector<std::byte>> getIpAndMask() const noexcept;
 
+	/**
+	 * @brief Returns network address of the prefix.
+	 * @return IP address with host bits cleared.
+	 */
+	const Nemea::IpAddress& getAddress() const noexcept;
+
+	/**
+	 * @brief Returns network mask of the prefix.
+	 * @return Mask as IP address.
+	 */
+	const Nemea::IpAddress& getMask() const noexcept;
+
+	/**
+	 * @brief Returns length of the prefix.
+	 * @return Number of network bits.
+	 */
+	size_t getLength() const noexcept;
+
 private:
 	Nemea::IpAddress m_address;
 	Nemea::IpAddress m_mask;
+	size_t m_length;
 };
 
-} // namespace ListDetector
+} // namespace Nm
@@ -18,7 +18,7 @@
 #include <cstdint>
 #include <functional>
 
-namespace Deduplicator {
+namespace Nm {
 /**
  * @brief Checks count of leading ones in given bitset.
  * @param bitset Bitset to check.
@@ -171,6 +171,26 @@ public:
 		return {emptyIndex, InsertResult::INSERTED};
 	}
 
+	/**
+	 * @brief Updates the time of a key which is in the bucket and has not timed out.
+	 *
+	 * Unlike `insert`, the key is not added to the bucket if it is not present.
+	 *
+	 * @param key The key to refresh.
+	 * @param currentTime The current time, used to manage key expiration.
+	 * @return True if the key was found and has not timed out, false otherwise.
+	 */
+	bool refresh(const uint64_t key, const TimeType& currentTime) noexcept
+	{
+		for (std::size_t index = 0; index < KEYS_PER_BUCKET; index++) {
+			if (isValid(index) && m_keys[index] == key && !isTimedOut(index, currentTime)) {
+				m_expirationTime[index] = currentTime;
+				return true;
+			}
+		}
+		return false;
+	}
+
 	/**
 	 * @brief Removes a key from the bucket.
 	 *
@@ -270,4 +290,4 @@ private:
 	std::array<TimeType, KEYS_PER_BUCKET> m_expirationTime; // 8 * 8B = 64B
 };
 
-} // namespace Deduplicator
+} // namespace Nm
@@ -12,14 +12,14 @@
 
 #pragma once
 
-#include "timeoutBucket.hpp"
+#include "timeoutHashMap/timeoutBucket.hpp"
 
 #include <cstdint>
 #include <functional>
 #include <stdexcept>
 #include <vector>
 
-namespace Deduplicator {
+namespace Nm {
 
 /**
  * @brief Manages keys associated with values with timeout-based expiration.
@@ -243,13 +243,10 @@ public:
 		: m_hasher(std::move(hasher))
 		, m_timeoutBucketCallables({std::move(timeLess), std::move(timeSum)})
 		, m_buckets(
-			  1UL << (parameters.bucketCountExponent - 3UL),
+			  getBucketsCount(parameters.bucketCountExponent),
 			  {parameters.timeout, m_timeoutBucketCallables, true})
-		, M_BUCKET_MASK((1UL << (parameters.bucketCountExponent - 3UL)) - 1UL)
+		, M_BUCKET_MASK(m_buckets.size() - 1UL)
 	{
-		if (parameters.bucketCountExponent < 3) {
-			throw std::invalid_argument("HashMap size can not be less than 8");
-		}
 	}
 
 	/**
@@ -274,6 +271,19 @@ public:
 		return {Iterator(*this, {bucketIndex, keyIndex}), insertResult};
 	}
 
+	/**
+	 * @brief Updates the time of given key if it is in the hash map and has not timed out.
+	 *
+	 * @param key A key to refresh.
+	 * @param currentTime Current time.
+	 * @return True if the key was found and has not timed out, false otherwise.
+	 */
+	bool refresh(const Key& key, const TimeType& currentTime) noexcept
+	{
+		const uint64_t keyHash = m_hasher(key);
+		return m_buckets[keyHash & M_BUCKET_MASK].refresh(keyHash, currentTime);
+	}
+
 	/**
 	 * @brief Removes given key from the hash map.
 	 *
@@ -302,10 +312,19 @@ public:
 	}
 
 private:
-	std::function<size_t(const FlowKey&)> m_hasher;
+	static std::size_t getBucketsCount(uint32_t bucketCountExponent)
+	{
+		// Checked before the buckets are allocated, the shift would be undefined otherwise
+		if (bucketCountExponent < 3) {
+			throw std::invalid_argument("HashMap size can not be less than 8");
+		}
+		return 1UL << (bucketCountExponent - 3UL);
+	}
+
+	Hasher m_hasher;
 	typename HashMapTimeoutBucket::TimeoutBucketCallables m_timeoutBucketCallables;
 	std::vector<HashMapTimeoutBucket> m_buckets;
 	const uint64_t M_BUCKET_MASK;
 };
 
-} // namespace Deduplicator
+} // namespace Nm
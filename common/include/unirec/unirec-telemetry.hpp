@@ -14,16 +14,195 @@
  * missed = XX %
  * @endcode
  *
+ * With an `InterfaceRatesSampler`, the input telemetry also contains exponentially weighted
+ * moving averages over 1, 10 and 60 seconds:
+ *
+ * @code
+ * receivedRecordsRate.1s = XXX records/s
+ * receivedBytesRate.1s = XXX B/s
+ * missed.1s = XX %
+ * ...
+ * @endcode
+ *
+ * and the send telemetry of a bidirectional interface is:
+ *
+ * @code
+ * sentRecords = XXX
+ * sendBlockingTime = XXX ms
+ * sentRecordsRate.1s = XXX records/s
+ * sendBlocked.1s = XX %
+ * ...
+ * @endcode
+ *
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
 #pragma once
 
+#include "counter/counter.hpp"
+#include "instrumentation/timer.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <telemetry.hpp>
+#include <thread>
 #include <unirec++/unirec.hpp>
 
 namespace Nm {
 
+/**
+ * @brief Counts records sent to an output interface and the time the sending was blocked.
+ *
+ * The blocking time is measured by the clock of the instrumentation timers, which is cheap
+ * enough to time every send. Sending is blocked when the receiver is slower than the module,
+ * so the blocking time reveals backpressure.
+ */
+class SendStats {
+public:
+	/**
+	 * @brief Sends the record and counts it.
+	 * @param interface Output or bidirectional interface.
+	 * @param record Unirec record or record view.
+	 */
+	template<typename Interface, typename Record>
+	void send(Interface& interface, Record& record)
+	{
+		const uint64_t start = InstrumentationClock::now();
+		interface.send(record);
+		m_sendBlockingTicks.add(InstrumentationClock::now() - start);
+		m_sentRecords.add();
+	}
+
+	/**
+	 * @brief Returns the number of sent records.
+	 */
+	uint64_t getSentRecords() const noexcept { return m_sentRecords.load(); }
+
+	/**
+	 * @brief Returns the total time of sending in ticks of the instrumentation clock.
+	 */
+	uint64_t getSendBlockingTicks() const noexcept { return m_sendBlockingTicks.load(); }
+
+private:
+	Counter m_sentRecords;
+	Counter m_sendBlockingTicks;
+};
+
+/**
+ * @brief Cumulative counters of an interface sampled by the `InterfaceRatesSampler`.
+ */
+struct InterfaceCounters {
+	uint64_t receivedRecords = 0; ///< Records received from the input.
+	uint64_t receivedBytes = 0; ///< Bytes received from the input.
+	uint64_t missedRecords = 0; ///< Records missed by the input.
+	uint64_t sentRecords = 0; ///< Records sent to the output.
+	double sendBlockingTime = 0; ///< Time of sending to the output in nanoseconds.
+};
+
+/**
+ * @brief Samples counters of an interface every second and averages their rates.
+ *
+ * A background thread reads the cumulative counters and updates the exponentially weighted
+ * moving average of each rate over each window of `WINDOWS`. The weight of a sample is
+ * 1 - exp(-dt / window), so the averages do not depend on the exact sampling period.
+ * Dashboards can read the rates directly instead of computing differences of counters.
+ */
+class InterfaceRatesSampler {
+public:
+	/**
+	 * @brief Period of reading the counters.
+	 */
+	static inline const std::chrono::milliseconds SAMPLING_PERIOD = std::chrono::seconds(1);
+
+	/**
+	 * @brief Number of windows of the moving averages.
+	 */
+	static inline const std::size_t WINDOWS_COUNT = 3;
+
+	/**
+	 * @brief Windows of the moving averages in seconds.
+	 */
+	static inline const std::array<uint64_t, WINDOWS_COUNT> WINDOWS = {1, 10, 60};
+
+	/**
+	 * @brief Callable reading the current counters of the interface.
+	 */
+	using CountersReader = std::function<InterfaceCounters()>;
+
+	/**
+	 * @brief Starts sampling of the counters of the input interface.
+	 * @param interface The input interface, must outlive the sampler.
+	 */
+	explicit InterfaceRatesSampler(const Nemea::UnirecInputInterface& interface);
+
+	/**
+	 * @brief Starts sampling of the counters of the bidirectional interface.
+	 * @param interface The bidirectional interface, must outlive the sampler.
+	 * @param sendStats Statistics of records sent by the interface, must outlive the sampler.
+	 */
+	InterfaceRatesSampler(
+		const Nemea::UnirecBidirectionalInterface& interface,
+		const SendStats& sendStats);
+
+	/**
+	 * @brief Starts sampling of the counters read by the callable.
+	 * @param countersReader Callable reading the counters from the sampling thread.
+	 */
+	explicit InterfaceRatesSampler(CountersReader countersReader);
+
+	InterfaceRatesSampler(const InterfaceRatesSampler&) = delete;
+	InterfaceRatesSampler& operator=(const InterfaceRatesSampler&) = delete;
+
+	/**
+	 * @brief Stops the sampling thread.
+	 */
+	~InterfaceRatesSampler();
+
+	/**
+	 * @brief Adds the received records and bytes rates and the missed percentage to the dict.
+	 * @param dict Telemetry dict of the input.
+	 */
+	void addInputRates(telemetry::Dict& dict) const;
+
+	/**
+	 * @brief Adds the sent records rate and the blocked percentage to the dict.
+	 * @param dict Telemetry dict of the output.
+	 */
+	void addSendRates(telemetry::Dict& dict) const;
+
+private:
+	/**
+	 * @brief Moving averages of one rate over all windows.
+	 */
+	using AverageRates = std::array<double, WINDOWS_COUNT>;
+
+	void runSampler();
+	void update(const InterfaceCounters& counters, std::chrono::steady_clock::time_point now);
+
+	CountersReader m_countersReader;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_stopCondition;
+	bool m_isStopRequested = false;
+
+	bool m_hasSample = false;
+	bool m_hasRates = false;
+	InterfaceCounters m_lastCounters;
+	std::chrono::steady_clock::time_point m_lastSampleTime;
+	AverageRates m_receivedRecordsRates {};
+	AverageRates m_receivedBytesRates {};
+	AverageRates m_missedRecordsRates {};
+	AverageRates m_sentRecordsRates {};
+	AverageRates m_sendBlockingRates {};
+
+	std::thread m_sampler;
+};
+
 /**
  * @brief Retrieves telemetry data for an input Unirec interface.
  *
@@ -44,4 +223,33 @@ telemetry::Content getInterfaceTelemetry(const Nemea::UnirecInputInterface& inte
  */
 telemetry::Content getInterfaceTelemetry(const Nemea::UnirecBidirectionalInterface& interface);
 
+/**
+ * @brief Retrieves telemetry data for an input Unirec interface with its rates.
+ * @param interface The input Unirec interface.
+ * @param ratesSampler Sampler of the interface counters.
+ * @return telemetry::Content The telemetry data of the interface.
+ */
+telemetry::Content getInterfaceTelemetry(
+	const Nemea::UnirecInputInterface& interface,
+	const InterfaceRatesSampler& ratesSampler);
+
+/**
+ * @brief Retrieves telemetry data for the input of a bidirectional interface with its rates.
+ * @param interface The bidirectional Unirec interface.
+ * @param ratesSampler Sampler of the interface counters.
+ * @return telemetry::Content The telemetry data of the interface.
+ */
+telemetry::Content getInterfaceTelemetry(
+	const Nemea::UnirecBidirectionalInterface& interface,
+	const InterfaceRatesSampler& ratesSampler);
+
+/**
+ * @brief Retrieves telemetry data for records sent to an interface with their rates.
+ * @param sendStats Statistics of the sent records.
+ * @param ratesSampler Sampler of the interface counters.
+ * @return telemetry::Content The telemetry data of the sent records.
+ */
+telemetry::Content
+getSendTelemetry(const SendStats& sendStats, const InterfaceRatesSampler& ratesSampler);
+
 } // namespace Nm
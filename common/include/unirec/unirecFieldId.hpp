@@ -0,0 +1,22 @@
+/**
+ * @file
+ * @brief Lookup of identifiers of Unirec fields by their names.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <unirec/unirec.h>
+
+namespace Nm {
+
+/**
+ * @brief Returns the identifier of the Unirec field.
+ * @param name Name of the field.
+ * @return Identifier of the field.
+ * @throw std::runtime_error If the field is not defined.
+ */
+ur_field_id_t getUnirecIdByName(const char* name);
+
+} // namespace Nm
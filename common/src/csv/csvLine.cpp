@@ -0,0 +1,64 @@
+/**
+ * @file
+ * @brief Splitting of lines of the CSV configuration files of modules.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "csv/csvLine.hpp"
+
+#include <stdexcept>
+
+namespace Nm {
+
+static const char g_SEPARATOR = ',';
+static const char g_QUOTE = '"';
+
+static std::string unquoteCell(std::string_view cell)
+{
+	if (cell.size() < 2 || cell.front() != g_QUOTE || cell.back() != g_QUOTE) {
+		return std::string(cell);
+	}
+
+	std::string unquoted;
+	for (size_t index = 1; index + 1 < cell.size(); index++) {
+		unquoted += cell[index];
+		if (cell[index] == g_QUOTE && cell[index + 1] == g_QUOTE) {
+			index++;
+		}
+	}
+	return unquoted;
+}
+
+std::string_view trimCell(std::string_view cell) noexcept
+{
+	const size_t first = cell.find_first_not_of(" \t");
+	if (first == std::string_view::npos) {
+		return {};
+	}
+	return cell.substr(first, cell.find_last_not_of(" \t") - first + 1);
+}
+
+std::vector<std::string> splitLine(std::string_view line)
+{
+	std::vector<std::string> cells;
+	size_t cellStart = 0;
+	bool quoted = false;
+	for (size_t index = 0; index < line.size(); index++) {
+		if (line[index] == g_QUOTE) {
+			if (index == cellStart || line[cellStart] == g_QUOTE) {
+				quoted = !quoted;
+			}
+		} else if (line[index] == g_SEPARATOR && !quoted) {
+			cells.emplace_back(unquoteCell(trimCell(line.substr(cellStart, index - cellStart))));
+			cellStart = index + 1;
+		}
+	}
+	if (quoted) {
+		throw std::runtime_error("Quoted cell is not terminated at the end of line");
+	}
+	cells.emplace_back(unquoteCell(trimCell(line.substr(cellStart))));
+	return cells;
+}
+
+} // namespace Nm
@@ -0,0 +1,66 @@
+/**
+ * @file
+ * @brief Implementation of the LogLinearHistogram class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "instrumentation/histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Nm {
+
+uint64_t LogLinearHistogram::getCount() const noexcept
+{
+	uint64_t count = 0;
+	for (const auto& bucket : m_buckets) {
+		count += bucket.load();
+	}
+	return count;
+}
+
+uint64_t LogLinearHistogram::getSum() const noexcept
+{
+	return m_sum.load();
+}
+
+uint64_t LogLinearHistogram::getBucketUpperBound(std::size_t bucketIndex) noexcept
+{
+	if (bucketIndex < SUB_BUCKETS_COUNT) {
+		return bucketIndex;
+	}
+
+	const std::size_t shift = bucketIndex / SUB_BUCKETS_COUNT - 1;
+	const uint64_t lowerBound = (SUB_BUCKETS_COUNT + bucketIndex % SUB_BUCKETS_COUNT) << shift;
+	return lowerBound + ((uint64_t {1} << shift) - 1);
+}
+
+uint64_t LogLinearHistogram::getQuantile(double quantile) const noexcept
+{
+	// Buckets are copied first, so the counts are consistent while the owner records values
+	std::array<uint64_t, BUCKETS_COUNT> counts;
+	uint64_t count = 0;
+	for (std::size_t bucketIndex = 0; bucketIndex < BUCKETS_COUNT; bucketIndex++) {
+		counts[bucketIndex] = m_buckets[bucketIndex].load();
+		count += counts[bucketIndex];
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	const auto rank = std::max(
+		uint64_t {1},
+		static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count))));
+	uint64_t cumulativeCount = 0;
+	for (std::size_t bucketIndex = 0; bucketIndex < BUCKETS_COUNT; bucketIndex++) {
+		cumulativeCount += counts[bucketIndex];
+		if (cumulativeCount >= rank) {
+			return getBucketUpperBound(bucketIndex);
+		}
+	}
+	return getBucketUpperBound(BUCKETS_COUNT - 1);
+}
+
+} // namespace Nm
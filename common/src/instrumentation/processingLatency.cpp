@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @brief Telemetry of latency histograms of the phases of processing a record.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "instrumentation/processingLatency.hpp"
+
+#include <string>
+
+namespace Nm {
+
+static void addHistogramTelemetry(
+	telemetry::Dict& dict,
+	const std::string& name,
+	const LogLinearHistogram& histogram,
+	double nanosecondsPerTick)
+{
+	const uint64_t count = histogram.getCount();
+	const double mean
+		= count == 0 ? 0.0 : static_cast<double>(histogram.getSum()) / static_cast<double>(count);
+
+	const auto toNanoseconds = [nanosecondsPerTick](double ticks) {
+		return telemetry::ScalarWithUnit(ticks * nanosecondsPerTick, "ns");
+	};
+
+	dict[name + ".count"] = count;
+	dict[name + ".mean"] = toNanoseconds(mean);
+	dict[name + ".p50"] = toNanoseconds(static_cast<double>(histogram.getQuantile(0.5)));
+	dict[name + ".p99"] = toNanoseconds(static_cast<double>(histogram.getQuantile(0.99)));
+	dict[name + ".p999"] = toNanoseconds(static_cast<double>(histogram.getQuantile(0.999)));
+}
+
+telemetry::Content getProcessingLatencyTelemetry(const ProcessingLatency& latency)
+{
+	const double nanosecondsPerTick = InstrumentationClock::getNanosecondsPerTick();
+
+	telemetry::Dict dict;
+	addHistogramTelemetry(dict, "receive", latency.receive, nanosecondsPerTick);
+	addHistogramTelemetry(dict, "process", latency.process, nanosecondsPerTick);
+	addHistogramTelemetry(dict, "send", latency.send, nanosecondsPerTick);
+	return dict;
+}
+
+std::shared_ptr<telemetry::File> addProcessingLatencyFile(
+	const std::shared_ptr<telemetry::Directory>& directory,
+	const ProcessingLatency& latency)
+{
+	if (!g_IS_INSTRUMENTATION_ENABLED) {
+		return nullptr;
+	}
+
+	const telemetry::FileOps fileOps
+		= {[&latency]() { return getProcessingLatencyTelemetry(latency); }, nullptr};
+	return directory->addFile("latency", fileOps);
+}
+
+} // namespace Nm
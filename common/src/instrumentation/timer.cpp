@@ -0,0 +1,51 @@
+/**
+ * @file
+ * @brief Calibration of the clock of timers.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "instrumentation/timer.hpp"
+
+#include <thread>
+
+namespace Nm {
+
+#ifdef __x86_64__
+
+/**
+ * @brief Times of both clocks when the program was started.
+ */
+struct ClockReference {
+	std::chrono::steady_clock::time_point time;
+	uint64_t ticks;
+};
+
+static const ClockReference g_clockReference
+	= {std::chrono::steady_clock::now(), InstrumentationClock::now()};
+
+double InstrumentationClock::getNanosecondsPerTick()
+{
+	static const std::chrono::milliseconds g_MIN_CALIBRATION_TIME(10);
+
+	const auto calibrationTime = std::chrono::steady_clock::now() - g_clockReference.time;
+	if (calibrationTime < g_MIN_CALIBRATION_TIME) {
+		std::this_thread::sleep_for(g_MIN_CALIBRATION_TIME - calibrationTime);
+	}
+
+	const uint64_t ticks = InstrumentationClock::now() - g_clockReference.ticks;
+	const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - g_clockReference.time);
+	return static_cast<double>(nanoseconds.count()) / static_cast<double>(ticks);
+}
+
+#else
+
+double InstrumentationClock::getNanosecondsPerTick()
+{
+	return 1.0;
+}
+
+#endif
+
+} // namespace Nm
@@ -6,14 +6,15 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
-#include "ipAddressPrefix.hpp"
+#include "ip/ipAddressPrefix.hpp"
 
 #include <array>
 #include <climits>
 #include <limits>
 #include <stdexcept>
 #include <string>
-namespace ListDetector {
+
+namespace Nm {
 
 static void validatePrefixLength(size_t prefix, size_t maxPrefix)
 {
@@ -25,6 +26,7 @@ static void validatePrefixLength(size_t prefix, size_t maxPrefix)
 }
 
 IpAddressPrefix::IpAddressPrefix(Nemea::IpAddress ipAddress, size_t prefix)
+	: m_length(prefix)
 {
 	if (ipAddress.isIpv4()) {
 		validatePrefixLength(prefix, IPV4_MAX_PREFIX);
@@ -80,4 +82,19 @@ IpAddressPrefix::getIpAndMask() const noexcept
 	return std::make_pair(ipAddress, mask);
 }
 
-} // namespace ListDetector
+const Nemea::IpAddress& IpAddressPrefix::getAddress() const noexcept
+{
+	return m_address;
+}
+
+const Nemea::IpAddress& IpAddressPrefix::getMask() const noexcept
+{
+	return m_mask;
+}
+
+size_t IpAddressPrefix::getLength() const noexcept
+{
+	return m_length;
+}
+
+} // namespace Nm
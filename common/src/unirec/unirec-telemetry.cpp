@@ -8,8 +8,16 @@
 
 #include "unirec/unirec-telemetry.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+
 namespace Nm {
 
+static const int g_FRACTION_TO_PERCENTAGE = 100;
+static const double g_NANOSECONDS_PER_SECOND = 1e9;
+
 static double getMissedPercentage(const Nemea::InputInteraceStats& stats)
 {
 	if (stats.receivedRecords == 0 && stats.missedRecords == 0) {
@@ -19,11 +27,10 @@ static double getMissedPercentage(const Nemea::InputInteraceStats& stats)
 	const double fraction = static_cast<double>(stats.missedRecords)
 		/ static_cast<double>(stats.receivedRecords + stats.missedRecords);
 
-	const int fractionToPercentage = 100;
-	return fraction * fractionToPercentage;
+	return fraction * g_FRACTION_TO_PERCENTAGE;
 }
 
-static telemetry::Content createInterfaceTelemetry(const Nemea::InputInteraceStats& stats)
+static telemetry::Dict createInterfaceTelemetry(const Nemea::InputInteraceStats& stats)
 {
 	telemetry::Dict dict;
 	dict["receivedBytes"] = stats.receivedBytes;
@@ -33,6 +40,161 @@ static telemetry::Content createInterfaceTelemetry(const Nemea::InputInteraceSta
 	return dict;
 }
 
+static InterfaceCounters getInputCounters(const Nemea::InputInteraceStats& stats)
+{
+	InterfaceCounters counters;
+	counters.receivedRecords = stats.receivedRecords;
+	counters.receivedBytes = stats.receivedBytes;
+	counters.missedRecords = stats.missedRecords;
+	return counters;
+}
+
+static uint64_t getIncrement(uint64_t current, uint64_t last)
+{
+	// Counters of the interface are reset e.g. when it is reconnected
+	return current >= last ? current - last : current;
+}
+
+static std::string getWindowSuffix(uint64_t window)
+{
+	return "." + std::to_string(window) + "s";
+}
+
+InterfaceRatesSampler::InterfaceRatesSampler(const Nemea::UnirecInputInterface& interface)
+	: InterfaceRatesSampler(
+		  [&interface]() { return getInputCounters(interface.getInputInterfaceStats()); })
+{
+}
+
+InterfaceRatesSampler::InterfaceRatesSampler(
+	const Nemea::UnirecBidirectionalInterface& interface,
+	const SendStats& sendStats)
+	: InterfaceRatesSampler([&interface, &sendStats]() {
+		InterfaceCounters counters = getInputCounters(interface.getInputInterfaceStats());
+		counters.sentRecords = sendStats.getSentRecords();
+		counters.sendBlockingTime = static_cast<double>(sendStats.getSendBlockingTicks())
+			* InstrumentationClock::getNanosecondsPerTick();
+		return counters;
+	})
+{
+}
+
+InterfaceRatesSampler::InterfaceRatesSampler(CountersReader countersReader)
+	: m_countersReader(std::move(countersReader))
+{
+	m_sampler = std::thread(&InterfaceRatesSampler::runSampler, this);
+}
+
+InterfaceRatesSampler::~InterfaceRatesSampler()
+{
+	{
+		const std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopRequested = true;
+	}
+	m_stopCondition.notify_one();
+	m_sampler.join();
+}
+
+void InterfaceRatesSampler::runSampler()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		// Counters are read without the lock, so telemetry reads are not delayed by the reader
+		lock.unlock();
+		const InterfaceCounters counters = m_countersReader();
+		const auto now = std::chrono::steady_clock::now();
+		lock.lock();
+
+		update(counters, now);
+		if (m_stopCondition.wait_for(lock, SAMPLING_PERIOD, [this]() {
+				return m_isStopRequested;
+			})) {
+			return;
+		}
+	}
+}
+
+void InterfaceRatesSampler::update(
+	const InterfaceCounters& counters,
+	std::chrono::steady_clock::time_point now)
+{
+	if (!m_hasSample) {
+		m_hasSample = true;
+		m_lastCounters = counters;
+		m_lastSampleTime = now;
+		return;
+	}
+
+	const double elapsedSeconds = std::chrono::duration<double>(now - m_lastSampleTime).count();
+	if (elapsedSeconds <= 0) {
+		return;
+	}
+
+	const auto updateRates = [&](AverageRates& rates, double increment) {
+		const double rate = increment / elapsedSeconds;
+		for (size_t windowIndex = 0; windowIndex < WINDOWS_COUNT; windowIndex++) {
+			// The first rate starts the averages, so they do not rise slowly from zero
+			const double weight = m_hasRates
+				? 1.0 - std::exp(-elapsedSeconds / static_cast<double>(WINDOWS[windowIndex]))
+				: 1.0;
+			rates[windowIndex] += weight * (rate - rates[windowIndex]);
+		}
+	};
+
+	const InterfaceCounters& last = m_lastCounters;
+	updateRates(
+		m_receivedRecordsRates,
+		static_cast<double>(getIncrement(counters.receivedRecords, last.receivedRecords)));
+	updateRates(
+		m_receivedBytesRates,
+		static_cast<double>(getIncrement(counters.receivedBytes, last.receivedBytes)));
+	updateRates(
+		m_missedRecordsRates,
+		static_cast<double>(getIncrement(counters.missedRecords, last.missedRecords)));
+	updateRates(
+		m_sentRecordsRates,
+		static_cast<double>(getIncrement(counters.sentRecords, last.sentRecords)));
+	updateRates(
+		m_sendBlockingRates,
+		std::max(0.0, counters.sendBlockingTime - last.sendBlockingTime));
+
+	m_hasRates = true;
+	m_lastCounters = counters;
+	m_lastSampleTime = now;
+}
+
+void InterfaceRatesSampler::addInputRates(telemetry::Dict& dict) const
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+	for (size_t windowIndex = 0; windowIndex < WINDOWS_COUNT; windowIndex++) {
+		const std::string suffix = getWindowSuffix(WINDOWS[windowIndex]);
+		const double receivedRate = m_receivedRecordsRates[windowIndex];
+		const double missedRate = m_missedRecordsRates[windowIndex];
+		const double missedPercentage = receivedRate + missedRate == 0
+			? 0.0
+			: missedRate / (receivedRate + missedRate) * g_FRACTION_TO_PERCENTAGE;
+
+		dict["receivedRecordsRate" + suffix] = telemetry::ScalarWithUnit(receivedRate, "records/s");
+		dict["receivedBytesRate" + suffix]
+			= telemetry::ScalarWithUnit(m_receivedBytesRates[windowIndex], "B/s");
+		dict["missed" + suffix] = telemetry::ScalarWithUnit(missedPercentage, "%");
+	}
+}
+
+void InterfaceRatesSampler::addSendRates(telemetry::Dict& dict) const
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+	for (size_t windowIndex = 0; windowIndex < WINDOWS_COUNT; windowIndex++) {
+		const std::string suffix = getWindowSuffix(WINDOWS[windowIndex]);
+		const double blockedPercentage = m_sendBlockingRates[windowIndex]
+			/ g_NANOSECONDS_PER_SECOND * g_FRACTION_TO_PERCENTAGE;
+
+		dict["sentRecordsRate" + suffix]
+			= telemetry::ScalarWithUnit(m_sentRecordsRates[windowIndex], "records/s");
+		dict["sendBlocked" + suffix] = telemetry::ScalarWithUnit(blockedPercentage, "%");
+	}
+}
+
 telemetry::Content getInterfaceTelemetry(const Nemea::UnirecBidirectionalInterface& interface)
 {
 	const auto stats = interface.getInputInterfaceStats();
@@ -45,4 +207,37 @@ telemetry::Content getInterfaceTelemetry(const Nemea::UnirecInputInterface& inte
 	return createInterfaceTelemetry(stats);
 }
 
+telemetry::Content getInterfaceTelemetry(
+	const Nemea::UnirecInputInterface& interface,
+	const InterfaceRatesSampler& ratesSampler)
+{
+	telemetry::Dict dict = createInterfaceTelemetry(interface.getInputInterfaceStats());
+	ratesSampler.addInputRates(dict);
+	return dict;
+}
+
+telemetry::Content getInterfaceTelemetry(
+	const Nemea::UnirecBidirectionalInterface& interface,
+	const InterfaceRatesSampler& ratesSampler)
+{
+	telemetry::Dict dict = createInterfaceTelemetry(interface.getInputInterfaceStats());
+	ratesSampler.addInputRates(dict);
+	return dict;
+}
+
+telemetry::Content
+getSendTelemetry(const SendStats& sendStats, const InterfaceRatesSampler& ratesSampler)
+{
+	const double sendBlockingTime = static_cast<double>(sendStats.getSendBlockingTicks())
+		* InstrumentationClock::getNanosecondsPerTick();
+	const double nanosecondsPerMillisecond = 1e6;
+
+	telemetry::Dict dict;
+	dict["sentRecords"] = sendStats.getSentRecords();
+	dict["sendBlockingTime"]
+		= telemetry::ScalarWithUnit(sendBlockingTime / nanosecondsPerMillisecond, "ms");
+	ratesSampler.addSendRates(dict);
+	return dict;
+}
+
 } // namespace Nm
@@ -0,0 +1,24 @@
+/**
+ * @file
+ * @brief Implementation of the lookup of identifiers of Unirec fields by their names.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "unirec/unirecFieldId.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace Nm {
+
+ur_field_id_t getUnirecIdByName(const char* name)
+{
+	const auto unirecId = ur_get_id_by_name(name);
+	if (unirecId == UR_E_INVALID_NAME) {
+		throw std::runtime_error(std::string("Invalid Unirec name:") + name);
+	}
+	return static_cast<ur_field_id_t>(unirecId);
+}
+
+} // namespace Nm
@@ -0,0 +1,83 @@
+/**
+ * @file
+ * @brief Tests of the counters of module statistics.
+ *
+ * Writers increment the counters while a reader loads them, as the telemetry thread does. Run
+ * the test under the thread sanitizer to check that the reads are free of data races.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "counter/counter.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static const uint64_t g_INCREMENTS_COUNT = 1000000;
+
+static bool check(bool condition, const std::string& message)
+{
+	if (!condition) {
+		std::cerr << "Failed: " << message << "\n";
+	}
+	return condition;
+}
+
+static bool testCounter()
+{
+	Nm::Counter counter;
+	bool passed = check(counter.load() == 0, "counter starts at zero");
+
+	counter.add();
+	counter.add(41);
+	passed &= check(counter.load() == 42, "counter adds values");
+
+	const Nm::Counter copy = counter;
+	counter.add();
+	passed &= check(copy.load() == 42, "copy of counter is a snapshot");
+
+	counter.store(counter.load() / 2);
+	passed &= check(counter.load() == 21, "counter stores value");
+	return passed;
+}
+
+static bool testCounterConcurrentRead()
+{
+	Nm::Counter counter;
+	std::atomic<bool> isWriterDone {false};
+	bool isMonotonic = true;
+
+	std::thread reader([&]() {
+		uint64_t lastValue = 0;
+		while (!isWriterDone.load()) {
+			const uint64_t value = counter.load();
+			isMonotonic &= value >= lastValue;
+			lastValue = value;
+		}
+	});
+	for (uint64_t increment = 0; increment < g_INCREMENTS_COUNT; increment++) {
+		counter.add();
+	}
+	isWriterDone.store(true);
+	reader.join();
+
+	bool passed = check(isMonotonic, "reader sees monotonic values of counter");
+	passed &= check(counter.load() == g_INCREMENTS_COUNT, "counter counts all increments");
+	return passed;
+}
+
+int main()
+{
+	bool passed = testCounter();
+	passed &= testCounterConcurrentRead();
+
+	if (!passed) {
+		return EXIT_FAILURE;
+	}
+	std::cout << "All tests passed\n";
+	return EXIT_SUCCESS;
+}
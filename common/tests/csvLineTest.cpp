@@ -0,0 +1,66 @@
+/**
+ * @file
+ * @brief Tests of splitting of lines of the CSV configuration files.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "csv/csvLine.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static bool check(bool condition, const std::string& message)
+{
+	if (!condition) {
+		std::cerr << "Failed: " << message << "\n";
+	}
+	return condition;
+}
+
+static bool testTrimCell()
+{
+	bool passed = check(Nm::trimCell(" \tvalue \t") == "value", "cell is trimmed");
+	passed &= check(Nm::trimCell("a b") == "a b", "inner spaces are kept");
+	passed &= check(Nm::trimCell(" \t ").empty(), "whitespace cell is empty");
+	return passed;
+}
+
+static bool testSplitLine()
+{
+	using Cells = std::vector<std::string>;
+
+	bool passed = check(Nm::splitLine("a, b ,c") == Cells {"a", "b", "c"}, "cells are trimmed");
+	passed &= check(Nm::splitLine("a,,") == Cells {"a", "", ""}, "empty cells are kept");
+	passed &= check(Nm::splitLine("") == Cells {""}, "empty line has one empty cell");
+	passed &= check(
+		Nm::splitLine(R"(1,"a,b", "say ""hi""")") == Cells {"1", "a,b", R"(say "hi")"},
+		"quoted cells keep commas and doubled quotes");
+	passed &= check(
+		Nm::splitLine(R"x(R"(a,b)",c)x") == Cells {R"(R"(a)", R"x(b)")x", "c"},
+		"quote inside a cell does not start a quoted cell");
+
+	bool thrown = false;
+	try {
+		Nm::splitLine(R"(a,"b)");
+	} catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	passed &= check(thrown, "unterminated quoted cell is rejected");
+	return passed;
+}
+
+int main()
+{
+	bool passed = testTrimCell();
+	passed &= testSplitLine();
+
+	if (!passed) {
+		return EXIT_FAILURE;
+	}
+	std::cout << "All tests passed\n";
+	return EXIT_SUCCESS;
+}
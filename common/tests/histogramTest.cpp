@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Tests of the log-linear latency histogram.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "instrumentation/histogram.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+
+using Nm::LogLinearHistogram;
+
+static bool check(bool condition, const std::string& message)
+{
+	if (!condition) {
+		std::cerr << "Failed: " << message << "\n";
+	}
+	return condition;
+}
+
+static bool testBucketEdges()
+{
+	const uint64_t maxValue = std::numeric_limits<uint64_t>::max();
+	const std::size_t lastBucket = LogLinearHistogram::BUCKETS_COUNT - 1;
+
+	bool passed = check(LogLinearHistogram::getBucketIndex(0) == 0, "0 is in bucket 0");
+	passed &= check(LogLinearHistogram::getBucketIndex(15) == 15, "15 is in bucket 15");
+	passed &= check(LogLinearHistogram::getBucketIndex(16) == 16, "16 is in bucket 16");
+	passed &= check(LogLinearHistogram::getBucketIndex(31) == 31, "31 is in bucket 31");
+	passed &= check(LogLinearHistogram::getBucketIndex(32) == 32, "32 is in bucket 32");
+	passed &= check(LogLinearHistogram::getBucketIndex(33) == 32, "33 shares bucket with 32");
+	passed &= check(LogLinearHistogram::getBucketIndex(34) == 33, "34 is in bucket 33");
+	passed &= check(
+		LogLinearHistogram::getBucketIndex(maxValue) == lastBucket,
+		"maximal value is in the last bucket");
+
+	passed &= check(LogLinearHistogram::getBucketUpperBound(15) == 15, "bucket 15 ends at 15");
+	passed &= check(LogLinearHistogram::getBucketUpperBound(16) == 16, "bucket 16 ends at 16");
+	passed &= check(LogLinearHistogram::getBucketUpperBound(31) == 31, "bucket 31 ends at 31");
+	passed &= check(LogLinearHistogram::getBucketUpperBound(32) == 33, "bucket 32 ends at 33");
+	passed &= check(
+		LogLinearHistogram::getBucketUpperBound(lastBucket) == maxValue,
+		"last bucket ends at the maximal value");
+	return passed;
+}
+
+static bool testBucketsAreContiguous()
+{
+	// The value above the upper bound of each bucket must start the next bucket
+	bool passed = true;
+	for (std::size_t bucketIndex = 0; bucketIndex < LogLinearHistogram::BUCKETS_COUNT;
+		 bucketIndex++) {
+		const uint64_t upperBound = LogLinearHistogram::getBucketUpperBound(bucketIndex);
+		passed &= check(
+			LogLinearHistogram::getBucketIndex(upperBound) == bucketIndex,
+			"upper bound of bucket " + std::to_string(bucketIndex) + " is in the bucket");
+		if (bucketIndex + 1 < LogLinearHistogram::BUCKETS_COUNT) {
+			passed &= check(
+				LogLinearHistogram::getBucketIndex(upperBound + 1) == bucketIndex + 1,
+				"value above bucket " + std::to_string(bucketIndex) + " is in the next bucket");
+		}
+	}
+	return passed;
+}
+
+// The quantile is the upper bound of the bucket of the exact quantile, at most 1/16 above it
+static bool isQuantileWithinError(uint64_t quantile, uint64_t exactQuantile)
+{
+	return quantile >= exactQuantile && quantile - exactQuantile <= exactQuantile / 16;
+}
+
+static bool testQuantiles()
+{
+	LogLinearHistogram empty;
+	bool passed = check(empty.getQuantile(0.5) == 0, "quantile of empty histogram is 0");
+
+	// Values below 16 have their own buckets, so their quantiles are exact
+	LogLinearHistogram small;
+	for (uint64_t value = 1; value <= 10; value++) {
+		small.record(value);
+	}
+	passed &= check(small.getQuantile(0.0) == 1, "quantile 0 is the minimum");
+	passed &= check(small.getQuantile(0.5) == 5, "median of 1 to 10 is 5");
+	passed &= check(small.getQuantile(1.0) == 10, "quantile 1 is the maximum");
+
+	LogLinearHistogram uniform;
+	const uint64_t valuesCount = 100000;
+	for (uint64_t value = 1; value <= valuesCount; value++) {
+		uniform.record(value);
+	}
+	passed &= check(uniform.getCount() == valuesCount, "histogram counts all values");
+	passed &= check(
+		uniform.getSum() == valuesCount * (valuesCount + 1) / 2,
+		"histogram sums all values");
+	for (const double quantile : {0.5, 0.9, 0.99, 0.999}) {
+		const auto exactQuantile
+			= static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(valuesCount)));
+		passed &= check(
+			isQuantileWithinError(uniform.getQuantile(quantile), exactQuantile),
+			"quantile " + std::to_string(quantile) + " of uniform values is within the error");
+	}
+
+	// 99 % of fast values and 1 % of slow values, as latencies with rare stalls
+	LogLinearHistogram bimodal;
+	for (uint64_t index = 0; index < 10000; index++) {
+		bimodal.record(index % 100 == 0 ? 1000000 : 200);
+	}
+	passed &= check(isQuantileWithinError(bimodal.getQuantile(0.5), 200), "median is fast");
+	passed &= check(isQuantileWithinError(bimodal.getQuantile(0.99), 200), "p99 is fast");
+	passed &= check(isQuantileWithinError(bimodal.getQuantile(0.999), 1000000), "p999 is slow");
+	return passed;
+}
+
+int main()
+{
+	bool passed = testBucketEdges();
+	passed &= testBucketsAreContiguous();
+	passed &= testQuantiles();
+
+	if (!passed) {
+		return EXIT_FAILURE;
+	}
+	std::cout << "All tests passed\n";
+	return EXIT_SUCCESS;
+}
@@ -7,6 +7,7 @@
  */
 
 #include "deduplicator.hpp"
+#include "unirec/unirecFieldId.hpp"
 
 #include <stdexcept>
 #include <type_traits>
@@ -27,15 +28,6 @@ static Deduplicator::Timestamp timeSum(const Deduplicator::Timestamp& value, uin
 	return value + std::chrono::milliseconds(timeout);
 }
 
-static ur_field_id_t getUnirecIdByName(const char* str)
-{
-	auto unirecId = ur_get_id_by_name(str);
-	if (unirecId == UR_E_INVALID_NAME) {
-		throw std::runtime_error(std::string("Invalid Unirec name:") + str);
-	}
-	return static_cast<ur_field_id_t>(unirecId);
-}
-
 Deduplicator::Deduplicator(const DeduplicatorHashMap::TimeoutHashMapParameters& parameters)
 	: m_hashMap(parameters, xxHasher<FlowKey>, std::less<>(), timeSum)
 {
@@ -47,13 +39,13 @@ Deduplicator::Deduplicator(const DeduplicatorHashMap::TimeoutHashMapParameters&
 
 void Deduplicator::updateUnirecIds()
 {
-	m_ids.srcIpId = getUnirecIdByName("SRC_IP");
-	m_ids.dstIpId = getUnirecIdByName("DST_IP");
-	m_ids.srcPortId = getUnirecIdByName("SRC_PORT");
-	m_ids.dstPortId = getUnirecIdByName("DST_PORT");
-	m_ids.protocolId = getUnirecIdByName("PROTOCOL");
-	m_ids.linkBitFieldId = getUnirecIdByName("LINK_BIT_FIELD");
-	m_ids.timeLastId = getUnirecIdByName("TIME_LAST");
+	m_ids.srcIpId = Nm::getUnirecIdByName("SRC_IP");
+	m_ids.dstIpId = Nm::getUnirecIdByName("DST_IP");
+	m_ids.srcPortId = Nm::getUnirecIdByName("SRC_PORT");
+	m_ids.dstPortId = Nm::getUnirecIdByName("DST_PORT");
+	m_ids.protocolId = Nm::getUnirecIdByName("PROTOCOL");
+	m_ids.linkBitFieldId = Nm::getUnirecIdByName("LINK_BIT_FIELD");
+	m_ids.timeLastId = Nm::getUnirecIdByName("TIME_LAST");
 }
 
 bool Deduplicator::isDuplicate(UnirecRecordView& view)
@@ -70,18 +62,18 @@ bool Deduplicator::isDuplicate(UnirecRecordView& view)
 		= m_hashMap.insert({flowKey, linkBitField}, std::chrono::steady_clock::now());
 
 	if (insertResult == DeduplicatorHashMap::HashMapTimeoutBucket::InsertResult::INSERTED) {
-		m_inserted++;
+		m_inserted.add();
 		return false;
 	}
 	if (insertResult == DeduplicatorHashMap::HashMapTimeoutBucket::InsertResult::REPLACED) {
-		m_replaced++;
+		m_replaced.add();
 		return false;
 	}
 	if (*it != linkBitField) {
-		m_deduplicated++;
+		m_deduplicated.add();
 		return true;
 	}
-	m_inserted++;
+	m_inserted.add();
 	return false;
 }
 
@@ -92,9 +84,9 @@ void Deduplicator::setTelemetryDirectory(const std::shared_ptr<telemetry::Direct
 	const telemetry::FileOps fileOps
 		= {[this]() {
 			   telemetry::Dict dict;
-			   dict["replacedCount"] = telemetry::Scalar((long unsigned int) m_replaced);
-			   dict["insertedCount"] = telemetry::Scalar((long unsigned int) m_inserted);
-			   dict["deduplicatedCount"] = telemetry::Scalar((long unsigned int) m_deduplicated);
+			   dict["replacedCount"] = telemetry::Scalar(m_replaced.load());
+			   dict["insertedCount"] = telemetry::Scalar(m_inserted.load());
+			   dict["deduplicatedCount"] = telemetry::Scalar(m_deduplicated.load());
 			   return dict;
 		   },
 		   nullptr};
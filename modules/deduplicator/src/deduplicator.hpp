@@ -8,8 +8,9 @@
 
 #pragma once
 
+#include "counter/counter.hpp"
 #include "flowKey.hpp"
-#include "timeoutHashMap.hpp"
+#include "timeoutHashMap/timeoutHashMap.hpp"
 #include "unirecidstorage.hpp"
 
 #include <atomic>
@@ -38,7 +39,7 @@ public:
 	/**
 	 * @brief Timeout hash mapp type used by deduplicator.
 	 */
-	using DeduplicatorHashMap = TimeoutHashMap<
+	using DeduplicatorHashMap = Nm::TimeoutHashMap<
 		FlowKey,
 		LinkBitField,
 		Timestamp,
@@ -76,9 +77,9 @@ public:
 private:
 	DeduplicatorHashMap m_hashMap; ///< Hash map to keep flows
 
-	uint32_t m_replaced {0}; ///< Count of replaced flows
-	uint32_t m_deduplicated {0}; ///< Count of deduplicated flows
-	uint32_t m_inserted {0}; ///< Count of inserted flows
+	Nm::Counter m_replaced; ///< Count of replaced flows
+	Nm::Counter m_deduplicated; ///< Count of deduplicated flows
+	Nm::Counter m_inserted; ///< Count of inserted flows
 
 	telemetry::Holder m_holder;
 
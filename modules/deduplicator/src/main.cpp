@@ -11,6 +11,7 @@
  */
 
 #include "deduplicator.hpp"
+#include "instrumentation/processingLatency.hpp"
 #include "logger/logger.hpp"
 #include "unirec/unirec-telemetry.hpp"
 
@@ -23,6 +24,9 @@
 
 using namespace Nemea;
 
+static Nm::ProcessingLatency g_processingLatency;
+static Nm::SendStats g_sendStats;
+
 /**
  * @brief Handle a format change exception by adjusting the template.
  *
@@ -53,13 +57,19 @@ static void processNextRecord(
 	UnirecBidirectionalInterface& biInterface,
 	Deduplicator::Deduplicator& deduplicator)
 {
+	Nm::PhaseTimer phaseTimer;
 	std::optional<UnirecRecordView> unirecRecord = biInterface.receive();
 	if (!unirecRecord) {
 		return;
 	}
+	phaseTimer.lap(g_processingLatency.receive);
+
+	const bool isDuplicate = deduplicator.isDuplicate(*unirecRecord);
+	phaseTimer.lap(g_processingLatency.process);
 
-	if (!deduplicator.isDuplicate(*unirecRecord)) {
-		biInterface.send(*unirecRecord);
+	if (!isDuplicate) {
+		g_sendStats.send(biInterface, *unirecRecord);
+		phaseTimer.lap(g_processingLatency.send);
 	}
 }
 
@@ -135,6 +145,8 @@ int main(int argc, char** argv)
 
 	std::shared_ptr<telemetry::Directory> telemetryRootDirectory;
 	telemetryRootDirectory = telemetry::Directory::create();
+	const auto latencyFile
+		= Nm::addProcessingLatencyFile(telemetryRootDirectory, g_processingLatency);
 
 	std::unique_ptr<telemetry::appFs::AppFsFuse> appFs;
 
@@ -170,10 +182,20 @@ int main(int argc, char** argv)
 		UnirecBidirectionalInterface biInterface = unirec.buildBidirectionalInterface();
 
 		auto telemetryInputDirectory = telemetryRootDirectory->addDir("input");
+		const Nm::InterfaceRatesSampler ratesSampler(biInterface, g_sendStats);
 		const telemetry::FileOps inputFileOps
-			= {[&biInterface]() { return Nm::getInterfaceTelemetry(biInterface); }, nullptr};
+			= {[&biInterface, &ratesSampler]() {
+				   return Nm::getInterfaceTelemetry(biInterface, ratesSampler);
+			   },
+			   nullptr};
 		const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
 
+		auto telemetryOutputDirectory = telemetryRootDirectory->addDir("output");
+		const telemetry::FileOps outputFileOps
+			= {[&ratesSampler]() { return Nm::getSendTelemetry(g_sendStats, ratesSampler); },
+			   nullptr};
+		const auto outputFile = telemetryOutputDirectory->addFile("stats", outputFileOps);
+
 		auto telemetryDeduplicatorDirectory = telemetryRootDirectory->addDir("deduplicator");
 
 		Deduplicator::Deduplicator::DeduplicatorHashMap::TimeoutHashMapParameters parameters;
@@ -0,0 +1,314 @@
+/**
+ * @file
+ * @brief ListDetector benchmark: measures matching throughput over generated rule sets.
+ *
+ * The benchmark generates a synthetic rule set, builds the ListDetector from it and drives
+ * `ListDetector::matches` over in-memory synthetic records, so the results do not depend on
+ * libtrap interfaces. It reports build time, memory used by the built rules, throughput and
+ * percentiles of the per-record matching time.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "listDetector.hpp"
+#include "logger/logger.hpp"
+#include "ruleSetGenerator.hpp"
+
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unirec++/unirec.hpp>
+#include <unistd.h>
+#include <vector>
+
+using namespace Nemea;
+
+/**
+ * @brief Maximal size of variable length fields of a generated record.
+ */
+static const size_t g_MAX_VARIABLE_FIELDS_SIZE = 256;
+
+/**
+ * @brief Records copied one after another to a single buffer, as the matching threads get them.
+ */
+struct RecordsArena {
+	std::vector<std::byte> data;
+	std::vector<size_t> offsets;
+};
+
+/**
+ * @brief Parses the prefix length distribution in format "length:weight,length:weight".
+ * @param specification Distribution specification.
+ * @return Prefix lengths with their weights.
+ */
+static std::vector<std::pair<uint8_t, unsigned>>
+parsePrefixLengths(const std::string& specification)
+{
+	std::vector<std::pair<uint8_t, unsigned>> prefixLengths;
+	size_t begin = 0;
+	while (begin < specification.size()) {
+		const size_t end = std::min(specification.find(',', begin), specification.size());
+		const std::string item = specification.substr(begin, end - begin);
+		const size_t separator = item.find(':');
+
+		const unsigned long length = std::stoul(item.substr(0, separator));
+		const unsigned long weight
+			= separator == std::string::npos ? 1 : std::stoul(item.substr(separator + 1));
+		if (length > UINT8_MAX) {
+			throw std::invalid_argument("Invalid prefix length " + item);
+		}
+		prefixLengths.emplace_back(static_cast<uint8_t>(length), static_cast<unsigned>(weight));
+		begin = end + 1;
+	}
+	return prefixLengths;
+}
+
+/**
+ * @brief Returns resident set size of the process in bytes.
+ */
+static size_t getResidentSetSize()
+{
+	std::ifstream statm("/proc/self/statm");
+	size_t totalPages = 0;
+	size_t residentPages = 0;
+	statm >> totalPages >> residentPages;
+	return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+static RecordsArena generateRecords(
+	ListDetector::RuleSetGenerator& generator,
+	ur_template_t* unirecTemplate,
+	size_t recordsCount,
+	double matchRatio,
+	uint64_t seed)
+{
+	std::mt19937_64 randomGenerator(seed);
+	std::bernoulli_distribution matchingDistribution(matchRatio);
+
+	RecordsArena arena;
+	UnirecRecord unirecRecord(unirecTemplate, g_MAX_VARIABLE_FIELDS_SIZE);
+	for (size_t recordIndex = 0; recordIndex < recordsCount; recordIndex++) {
+		generator.fillRecord(unirecRecord, matchingDistribution(randomGenerator));
+
+		const size_t recordSize = ur_rec_size(unirecTemplate, unirecRecord.data());
+		arena.offsets.emplace_back(arena.data.size());
+		arena.data.resize(arena.data.size() + recordSize);
+		std::memcpy(arena.data.data() + arena.offsets.back(), unirecRecord.data(), recordSize);
+	}
+	return arena;
+}
+
+static double getPercentile(const std::vector<uint64_t>& sortedValues, double percentile)
+{
+	const auto index = static_cast<size_t>(
+		percentile / 100.0 * static_cast<double>(sortedValues.size() - 1));
+	return static_cast<double>(sortedValues[index]);
+}
+
+static void runBenchmark(
+	ListDetector::ListDetector& listDetector,
+	const RecordsArena& arena,
+	ur_template_t* unirecTemplate,
+	size_t passesCount)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<UnirecRecordView> views;
+	views.reserve(arena.offsets.size());
+	for (const size_t offset : arena.offsets) {
+		views.emplace_back(arena.data.data() + offset, unirecTemplate);
+	}
+
+	// Warm up caches and the evaluation plan before anything is measured
+	size_t matchedCount = 0;
+	for (const auto& view : views) {
+		matchedCount += static_cast<size_t>(listDetector.matches(view));
+	}
+
+	matchedCount = 0;
+	const auto throughputStart = Clock::now();
+	for (size_t pass = 0; pass < passesCount; pass++) {
+		for (const auto& view : views) {
+			matchedCount += static_cast<size_t>(listDetector.matches(view));
+		}
+	}
+	const std::chrono::duration<double> throughputDuration = Clock::now() - throughputStart;
+	const double recordsCount = static_cast<double>(views.size() * passesCount);
+
+	// Latencies are measured in a separate pass as reading the clock distorts the throughput
+	std::vector<uint64_t> latencies;
+	latencies.reserve(views.size());
+	for (const auto& view : views) {
+		const auto start = Clock::now();
+		matchedCount += static_cast<size_t>(listDetector.matches(view));
+		const auto end = Clock::now();
+		latencies.emplace_back(static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	std::cout << "records/s: " << recordsCount / throughputDuration.count() << '\n';
+	std::cout << "ns/record mean: " << throughputDuration.count() * 1e9 / recordsCount << '\n';
+	std::cout << "ns/record p50: " << getPercentile(latencies, 50) << '\n';
+	std::cout << "ns/record p90: " << getPercentile(latencies, 90) << '\n';
+	std::cout << "ns/record p99: " << getPercentile(latencies, 99) << '\n';
+	std::cout << "ns/record p99.9: " << getPercentile(latencies, 99.9) << '\n';
+	std::cout << "ns/record max: " << latencies.back() << '\n';
+	std::cout << "forwarded records: " << matchedCount << '\n';
+}
+
+int main(int argc, char** argv)
+{
+	argparse::ArgumentParser program("listDetectorBenchmark");
+
+	Nm::loggerInit();
+	auto logger = Nm::loggerGet("main");
+
+	try {
+		program.add_argument("-n", "--rules-count")
+			.help("number of generated rules")
+			.default_value(10000)
+			.scan<'i', int>();
+
+		program.add_argument("-l", "--prefix-lengths")
+			.help("distribution of IP prefix lengths as length:weight pairs separated by comma")
+			.default_value(std::string("32:70,24:20,16:10"));
+
+		program.add_argument("-w", "--wildcard-masks")
+			.help("number of distinct combinations of wildcard fields (1-31)")
+			.default_value(1)
+			.scan<'i', int>();
+
+		program.add_argument("-x", "--regex-rules")
+			.help("number of rules matching the URL field by regex")
+			.default_value(0)
+			.scan<'i', int>();
+
+		program.add_argument("-R", "--records-count")
+			.help("number of generated records")
+			.default_value(100000)
+			.scan<'i', int>();
+
+		program.add_argument("-M", "--match-ratio")
+			.help("ratio of records generated to match some rule")
+			.default_value(0.01)
+			.scan<'g', double>();
+
+		program.add_argument("-P", "--passes")
+			.help("number of passes over the records in the throughput measurement")
+			.default_value(10)
+			.scan<'i', int>();
+
+		program.add_argument("-s", "--seed")
+			.help("seed of the generator")
+			.default_value(0)
+			.scan<'i', int>();
+
+		program.add_argument("-lm", "--listmode")
+			.help("list detector mode. Default is blacklist")
+			.default_value(std::string("blacklist"));
+
+		program.add_argument("-c", "--verdict-cache-size")
+			.help("number of cached verdicts. Default is 0 (cache disabled)")
+			.default_value(0)
+			.scan<'i', int>();
+
+		program.add_argument("-p", "--prefilter")
+			.help("reject records by the Bloom filter prefilter before full matching")
+			.default_value(false)
+			.implicit_value(true);
+
+		program.add_argument("-o", "--write-rules")
+			.help("write the generated rules to the CSV file")
+			.default_value(std::string(""));
+
+		program.parse_args(argc, argv);
+	} catch (const std::exception& ex) {
+		logger->error(ex.what());
+		std::cerr << program;
+		return EXIT_FAILURE;
+	}
+
+	try {
+		const int rulesCount = program.get<int>("--rules-count");
+		const int wildcardMasksCount = program.get<int>("--wildcard-masks");
+		const int regexRulesCount = program.get<int>("--regex-rules");
+		const int recordsCount = program.get<int>("--records-count");
+		const int passesCount = program.get<int>("--passes");
+		const int verdictCacheSize = program.get<int>("--verdict-cache-size");
+		const double matchRatio = program.get<double>("--match-ratio");
+		if (rulesCount <= 0 || wildcardMasksCount <= 0 || regexRulesCount < 0 || recordsCount <= 0
+			|| passesCount <= 0 || verdictCacheSize < 0 || matchRatio < 0 || matchRatio > 1) {
+			std::cerr << "Invalid benchmark parameters.\n";
+			return EXIT_FAILURE;
+		}
+
+		ListDetector::RuleSetParameters ruleSetParameters;
+		ruleSetParameters.rulesCount = static_cast<size_t>(rulesCount);
+		ruleSetParameters.prefixLengths
+			= parsePrefixLengths(program.get<std::string>("--prefix-lengths"));
+		ruleSetParameters.wildcardMasksCount = static_cast<size_t>(wildcardMasksCount);
+		ruleSetParameters.regexRulesCount = static_cast<size_t>(regexRulesCount);
+		ruleSetParameters.seed = static_cast<uint64_t>(program.get<int>("--seed"));
+
+		ListDetector::RuleSetGenerator generator(ruleSetParameters);
+		const auto rulesFilename = program.get<std::string>("--write-rules");
+		if (!rulesFilename.empty()) {
+			std::ofstream rulesFile(rulesFilename);
+			generator.writeCsv(rulesFile);
+		}
+
+		if (ur_define_set_of_fields(ListDetector::RuleSetGenerator::UNIREC_TEMPLATE.c_str())
+			!= UR_OK) {
+			throw std::runtime_error("Unable to define fields of the benchmark template");
+		}
+		ur_template_t* unirecTemplate = ur_create_template_from_ifc_spec(
+			ListDetector::RuleSetGenerator::UNIREC_TEMPLATE.c_str());
+		if (unirecTemplate == nullptr) {
+			throw std::runtime_error("Unable to create the benchmark template");
+		}
+
+		ListDetector::ListDetectorParameters parameters;
+		parameters.verdictCacheSize = static_cast<size_t>(verdictCacheSize);
+		parameters.usePrefilter = program.get<bool>("--prefilter");
+		const auto mode = ListDetector::ListDetector::convertStringToListDetectorMode(
+			program.get<std::string>("--listmode"));
+
+		const size_t residentSetSizeBeforeBuild = getResidentSetSize();
+		const auto buildStart = std::chrono::steady_clock::now();
+		ListDetector::ListDetector listDetector(&generator, mode, parameters);
+		const std::chrono::duration<double, std::milli> buildDuration
+			= std::chrono::steady_clock::now() - buildStart;
+		const size_t residentSetSizeAfterBuild
+			= std::max(getResidentSetSize(), residentSetSizeBeforeBuild);
+
+		std::cout << "rules: " << rulesCount << '\n';
+		std::cout << "build time ms: " << buildDuration.count() << '\n';
+		std::cout << "build memory KiB: "
+				  << (residentSetSizeAfterBuild - residentSetSizeBeforeBuild) / 1024 << '\n';
+
+		const RecordsArena arena = generateRecords(
+			generator,
+			unirecTemplate,
+			static_cast<size_t>(recordsCount),
+			matchRatio,
+			ruleSetParameters.seed + 1);
+		std::cout << "records: " << recordsCount << '\n';
+
+		runBenchmark(listDetector, arena, unirecTemplate, static_cast<size_t>(passesCount));
+		ur_free_template(unirecTemplate);
+	} catch (const std::exception& ex) {
+		logger->error(ex.what());
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file
+ * @brief Implementation of the RuleSetGenerator class generating synthetic rules and records for
+ * the ListDetector benchmark
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "ruleSetGenerator.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <unirec++/ipAddress.hpp>
+#include <unirec/unirec.h>
+
+namespace ListDetector {
+
+/**
+ * @brief Number of non-empty combinations of the fields a rule can match by.
+ */
+static const size_t g_FIELDS_MASKS_COUNT = 31;
+
+static const uint8_t g_IPV4_LENGTH = 32;
+
+static std::string formatAddress(uint32_t address)
+{
+	return std::to_string(address >> 24U) + "." + std::to_string((address >> 16U) & 0xFFU) + "."
+		+ std::to_string((address >> 8U) & 0xFFU) + "." + std::to_string(address & 0xFFU);
+}
+
+static ur_field_id_t getFieldId(const char* fieldName)
+{
+	const int fieldId = ur_get_id_by_name(fieldName);
+	if (fieldId == UR_E_INVALID_NAME) {
+		throw std::runtime_error(
+			std::string("RuleSetGenerator: field ") + fieldName + " is not defined");
+	}
+	return static_cast<ur_field_id_t>(fieldId);
+}
+
+RuleSetGenerator::RuleSetGenerator(const RuleSetParameters& parameters)
+	: m_generator(parameters.seed)
+{
+	if (parameters.prefixLengths.empty()) {
+		throw std::invalid_argument("RuleSetGenerator: no prefix length is given");
+	}
+	std::vector<unsigned> weights;
+	for (const auto& [length, weight] : parameters.prefixLengths) {
+		if (length == 0 || length > g_IPV4_LENGTH) {
+			throw std::invalid_argument(
+				"RuleSetGenerator: prefix length must be in range 1-32, got "
+				+ std::to_string(length));
+		}
+		m_prefixLengths.emplace_back(length);
+		weights.emplace_back(weight);
+	}
+	m_prefixLengthDistribution = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+
+	if (parameters.regexRulesCount > parameters.rulesCount) {
+		throw std::invalid_argument("RuleSetGenerator: more regex rules than rules");
+	}
+	generateWildcardMasks(parameters.wildcardMasksCount);
+
+	std::vector<UnirecTypeName> unirecTemplateDescription;
+	size_t begin = 0;
+	while (begin < UNIREC_TEMPLATE.size()) {
+		const size_t end = std::min(UNIREC_TEMPLATE.find(',', begin), UNIREC_TEMPLATE.size());
+		unirecTemplateDescription.emplace_back(UNIREC_TEMPLATE.substr(begin, end - begin));
+		begin = end + 1;
+	}
+	setUnirecTemplate(unirecTemplateDescription);
+
+	for (size_t ruleIndex = 0; ruleIndex < parameters.rulesCount; ruleIndex++) {
+		m_rules.emplace_back(generateRule(ruleIndex));
+		m_rules.back().hasRegex = ruleIndex < parameters.regexRulesCount;
+
+		const GeneratedRule& rule = m_rules.back();
+		addRule({
+			(rule.fieldsMask & SRC_IP_BIT) ? formatPrefix(rule.srcNetwork, rule.srcLength) : "",
+			(rule.fieldsMask & DST_IP_BIT) ? formatPrefix(rule.dstNetwork, rule.dstLength) : "",
+			(rule.fieldsMask & SRC_PORT_BIT) ? std::to_string(rule.srcPort) : "",
+			(rule.fieldsMask & DST_PORT_BIT) ? std::to_string(rule.dstPort) : "",
+			(rule.fieldsMask & PROTOCOL_BIT) ? std::to_string(rule.protocol) : "",
+			rule.hasRegex ? "R\"(.*" + formatRegexToken(ruleIndex) + ".*)\"" : "",
+		});
+	}
+	validate();
+}
+
+void RuleSetGenerator::generateWildcardMasks(size_t wildcardMasksCount)
+{
+	if (wildcardMasksCount == 0 || wildcardMasksCount > g_FIELDS_MASKS_COUNT) {
+		throw std::invalid_argument(
+			"RuleSetGenerator: number of wildcard masks must be in range 1-"
+			+ std::to_string(g_FIELDS_MASKS_COUNT));
+	}
+
+	std::vector<uint8_t> fieldsMasks(g_FIELDS_MASKS_COUNT);
+	std::iota(fieldsMasks.begin(), fieldsMasks.end(), 1);
+	fieldsMasks.erase(std::find(fieldsMasks.begin(), fieldsMasks.end(), DST_IP_BIT));
+	std::shuffle(fieldsMasks.begin(), fieldsMasks.end(), m_generator);
+
+	// Rules of real blocklists mostly match the destination address only
+	m_wildcardMasks.emplace_back(DST_IP_BIT);
+	m_wildcardMasks.insert(
+		m_wildcardMasks.end(),
+		fieldsMasks.begin(),
+		fieldsMasks.begin() + static_cast<std::ptrdiff_t>(wildcardMasksCount - 1));
+}
+
+RuleSetGenerator::GeneratedRule RuleSetGenerator::generateRule(size_t ruleIndex)
+{
+	GeneratedRule rule;
+	rule.fieldsMask = m_wildcardMasks[ruleIndex % m_wildcardMasks.size()];
+	rule.srcLength = m_prefixLengths[m_prefixLengthDistribution(m_generator)];
+	rule.srcNetwork = static_cast<uint32_t>(m_generator()) & getNetworkMask(rule.srcLength);
+	rule.dstLength = m_prefixLengths[m_prefixLengthDistribution(m_generator)];
+	rule.dstNetwork = static_cast<uint32_t>(m_generator()) & getNetworkMask(rule.dstLength);
+	rule.srcPort = static_cast<uint16_t>(m_generator());
+	rule.dstPort = static_cast<uint16_t>(m_generator());
+	rule.protocol = (m_generator() & 1U) != 0 ? 6 : 17;
+	rule.hasRegex = false;
+	return rule;
+}
+
+uint32_t RuleSetGenerator::generateAddressInNetwork(uint32_t network, uint8_t length)
+{
+	return network | (static_cast<uint32_t>(m_generator()) & ~getNetworkMask(length));
+}
+
+void RuleSetGenerator::fillRecord(Nemea::UnirecRecord& unirecRecord, bool matching)
+{
+	GeneratedRule rule = generateRule(0);
+	rule.fieldsMask = 0;
+	std::string url = "http://host" + std::to_string(m_generator() % 100000) + ".example/index";
+
+	if (matching && !m_rules.empty()) {
+		const size_t ruleIndex = m_generator() % m_rules.size();
+		const uint8_t fieldsMask = m_rules[ruleIndex].fieldsMask;
+		rule = m_rules[ruleIndex];
+		rule.srcNetwork = (fieldsMask & SRC_IP_BIT)
+			? generateAddressInNetwork(rule.srcNetwork, rule.srcLength)
+			: static_cast<uint32_t>(m_generator());
+		rule.dstNetwork = (fieldsMask & DST_IP_BIT)
+			? generateAddressInNetwork(rule.dstNetwork, rule.dstLength)
+			: static_cast<uint32_t>(m_generator());
+		if (rule.hasRegex) {
+			url += formatRegexToken(ruleIndex);
+		}
+	}
+
+	unirecRecord.setFieldFromType(
+		Nemea::IpAddress(formatAddress(rule.srcNetwork)),
+		getFieldId("SRC_IP"));
+	unirecRecord.setFieldFromType(
+		Nemea::IpAddress(formatAddress(rule.dstNetwork)),
+		getFieldId("DST_IP"));
+	unirecRecord.setFieldFromType(rule.srcPort, getFieldId("SRC_PORT"));
+	unirecRecord.setFieldFromType(rule.dstPort, getFieldId("DST_PORT"));
+	unirecRecord.setFieldFromType(rule.protocol, getFieldId("PROTOCOL"));
+	unirecRecord.setFieldFromType(url, getFieldId("URL"));
+}
+
+void RuleSetGenerator::writeCsv(std::ostream& stream) const
+{
+	stream << UNIREC_TEMPLATE << '\n';
+	for (const auto& ruleDescription : getRulesDescription()) {
+		for (size_t fieldIndex = 0; fieldIndex < ruleDescription.size(); fieldIndex++) {
+			stream << (fieldIndex != 0 ? "," : "") << ruleDescription[fieldIndex];
+		}
+		stream << '\n';
+	}
+}
+
+uint32_t RuleSetGenerator::getNetworkMask(uint8_t length) noexcept
+{
+	return length >= g_IPV4_LENGTH ? 0xFFFFFFFFU : ~(0xFFFFFFFFU >> length);
+}
+
+std::string RuleSetGenerator::formatPrefix(uint32_t network, uint8_t length)
+{
+	if (length == g_IPV4_LENGTH) {
+		return formatAddress(network);
+	}
+	return formatAddress(network) + "/" + std::to_string(length);
+}
+
+std::string RuleSetGenerator::formatRegexToken(size_t ruleIndex)
+{
+	return "token" + std::to_string(ruleIndex) + "x";
+}
+
+} // namespace ListDetector
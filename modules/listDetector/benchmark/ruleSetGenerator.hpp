@@ -0,0 +1,111 @@
+/**
+ * @file
+ * @brief Declaration of the RuleSetGenerator class generating synthetic rules and records for the
+ * ListDetector benchmark
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "configParser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <unirec++/unirecRecord.hpp>
+#include <utility>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Parameters of the generated rule set.
+ */
+struct RuleSetParameters {
+	size_t rulesCount = 10000; ///< Number of generated rules.
+	std::vector<std::pair<uint8_t, unsigned>> prefixLengths
+		= {{32, 1}}; ///< IPv4 prefix lengths with their relative weights.
+	size_t wildcardMasksCount = 1; ///< Number of distinct combinations of wildcard fields.
+	size_t regexRulesCount = 0; ///< Number of rules matching the URL field by regex.
+	uint64_t seed = 0; ///< Seed of the pseudo-random generator.
+};
+
+/**
+ * @brief Generates a synthetic rule set and records matching or missing its rules.
+ *
+ * Rules are generated over a fixed template of flow fields. Each rule uses one of the distinct
+ * wildcard masks, the first mask being the plain destination address blocklist, and IP prefixes of
+ * lengths drawn from the configured distribution. The generator is a ConfigParser, so the rules
+ * are passed to the ListDetector without a CSV file.
+ */
+class RuleSetGenerator : public ConfigParser {
+public:
+	/**
+	 * @brief Unirec template of the generated rules and records.
+	 */
+	static inline const std::string UNIREC_TEMPLATE
+		= "ipaddr SRC_IP,ipaddr DST_IP,uint16 SRC_PORT,uint16 DST_PORT,uint8 PROTOCOL,string URL";
+
+	/**
+	 * @brief Generates the rule set.
+	 * @param parameters Parameters of the rule set.
+	 * @throw std::invalid_argument If the parameters can not be satisfied.
+	 */
+	explicit RuleSetGenerator(const RuleSetParameters& parameters);
+
+	/**
+	 * @brief Fills the record by random values.
+	 *
+	 * Fields of the record template must be defined by `UNIREC_TEMPLATE` first.
+	 *
+	 * @param unirecRecord Record to fill.
+	 * @param matching If true, values are derived from a random rule, so the record matches it.
+	 */
+	void fillRecord(Nemea::UnirecRecord& unirecRecord, bool matching);
+
+	/**
+	 * @brief Writes the generated rules in the CSV rules format.
+	 * @param stream Output stream.
+	 */
+	void writeCsv(std::ostream& stream) const;
+
+private:
+	enum FieldBit : uint8_t {
+		SRC_IP_BIT = 1U << 0U,
+		DST_IP_BIT = 1U << 1U,
+		SRC_PORT_BIT = 1U << 2U,
+		DST_PORT_BIT = 1U << 3U,
+		PROTOCOL_BIT = 1U << 4U,
+	};
+
+	struct GeneratedRule {
+		uint8_t fieldsMask;
+		uint32_t srcNetwork;
+		uint8_t srcLength;
+		uint32_t dstNetwork;
+		uint8_t dstLength;
+		uint16_t srcPort;
+		uint16_t dstPort;
+		uint8_t protocol;
+		bool hasRegex;
+	};
+
+	void generateWildcardMasks(size_t wildcardMasksCount);
+	GeneratedRule generateRule(size_t ruleIndex);
+	uint32_t generateAddressInNetwork(uint32_t network, uint8_t length);
+
+	static uint32_t getNetworkMask(uint8_t length) noexcept;
+	static std::string formatPrefix(uint32_t network, uint8_t length);
+	static std::string formatRegexToken(size_t ruleIndex);
+
+	std::mt19937_64 m_generator;
+	std::discrete_distribution<size_t> m_prefixLengthDistribution;
+	std::vector<uint8_t> m_prefixLengths;
+	std::vector<uint8_t> m_wildcardMasks;
+	std::vector<GeneratedRule> m_rules;
+};
+
+} // namespace ListDetector
@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @brief Implementation of the BlockedBloomFilter class for approximate membership of hashed
+ * keys.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "blockedBloomFilter.hpp"
+
+#include <algorithm>
+
+namespace ListDetector {
+
+/**
+ * @brief Odd multipliers selecting the bit of each block word (see Parquet split block filter).
+ */
+static const std::array<uint32_t, 8> g_SALTS = {
+	0x47b6137bU,
+	0x44974d91U,
+	0x8824ad5bU,
+	0xa2b7289dU,
+	0x705495c7U,
+	0x2df1424bU,
+	0x9efc4947U,
+	0x5c6bfb31U,
+};
+
+BlockedBloomFilter::BlockedBloomFilter(size_t keysCount)
+{
+	const size_t bitsPerBlock = sizeof(Block) * 8;
+	const size_t blocksCount = (keysCount * BITS_PER_KEY + bitsPerBlock - 1) / bitsPerBlock;
+	m_blocks.resize(std::max<size_t>(blocksCount, 1));
+}
+
+size_t BlockedBloomFilter::getBlockIndex(uint64_t hash) const noexcept
+{
+	// Maps the upper half of the hash to the range of blocks without division
+	const uint64_t upperHalf = hash >> 32U;
+	return static_cast<size_t>((upperHalf * m_blocks.size()) >> 32U);
+}
+
+BlockedBloomFilter::Block BlockedBloomFilter::createKeyMask(uint64_t hash) noexcept
+{
+	const auto lowerHalf = static_cast<uint32_t>(hash);
+	const unsigned bitIndexShift = 27;
+
+	Block mask {};
+	for (size_t wordIndex = 0; wordIndex < WORDS_PER_BLOCK; wordIndex++) {
+		mask.words[wordIndex] = 1U << ((lowerHalf * g_SALTS[wordIndex]) >> bitIndexShift);
+	}
+	return mask;
+}
+
+void BlockedBloomFilter::insert(uint64_t hash) noexcept
+{
+	Block& block = m_blocks[getBlockIndex(hash)];
+	const Block mask = createKeyMask(hash);
+	for (size_t wordIndex = 0; wordIndex < WORDS_PER_BLOCK; wordIndex++) {
+		block.words[wordIndex] |= mask.words[wordIndex];
+	}
+}
+
+bool BlockedBloomFilter::mayContain(uint64_t hash) const noexcept
+{
+	const Block& block = m_blocks[getBlockIndex(hash)];
+	const Block mask = createKeyMask(hash);
+	for (size_t wordIndex = 0; wordIndex < WORDS_PER_BLOCK; wordIndex++) {
+		if ((block.words[wordIndex] & mask.words[wordIndex]) == 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace ListDetector
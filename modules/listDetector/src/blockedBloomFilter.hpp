@@ -0,0 +1,62 @@
+/**
+ * @file
+ * @brief Declaration of the BlockedBloomFilter class for approximate membership of hashed keys.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Split block Bloom filter of 64-bit key hashes.
+ *
+ * Each key sets one bit in each of the eight 32-bit words of a single 32-byte block, so a lookup
+ * touches only one cache line. The filter has no false negatives.
+ */
+class BlockedBloomFilter {
+public:
+	/**
+	 * @brief Number of filter bits reserved for one key.
+	 */
+	static inline const size_t BITS_PER_KEY = 16;
+
+	/**
+	 * @brief Constructs empty filter.
+	 * @param keysCount Expected number of inserted keys.
+	 */
+	explicit BlockedBloomFilter(size_t keysCount);
+
+	/**
+	 * @brief Inserts the key to the filter.
+	 * @param hash Hash of the key.
+	 */
+	void insert(uint64_t hash) noexcept;
+
+	/**
+	 * @brief Checks if the key may be present in the filter.
+	 * @param hash Hash of the key.
+	 * @return False if the key is certainly not present, true otherwise.
+	 */
+	bool mayContain(uint64_t hash) const noexcept;
+
+private:
+	static inline const size_t WORDS_PER_BLOCK = 8;
+
+	struct alignas(32) Block {
+		std::array<uint32_t, WORDS_PER_BLOCK> words;
+	};
+
+	size_t getBlockIndex(uint64_t hash) const noexcept;
+	static Block createKeyMask(uint64_t hash) noexcept;
+
+	std::vector<Block> m_blocks;
+};
+
+} // namespace ListDetector
@@ -8,6 +8,7 @@
  */
 
 #include "configParser.hpp"
+#include "ruleBuilder.hpp"
 
 #include <numeric>
 #include <regex>
@@ -52,6 +53,15 @@ void ConfigParser::addRule(const RuleDescription& ruleDescription)
 	m_rulesDescription.emplace_back(ruleDescription);
 }
 
+std::vector<Rule> ConfigParser::buildRules(RuleBuilder& ruleBuilder) const
+{
+	std::vector<Rule> rules;
+	for (const auto& ruleDescription : m_rulesDescription) {
+		rules.emplace_back(ruleBuilder.build(ruleDescription));
+	}
+	return rules;
+}
+
 void ConfigParser::validate() const
 {
 	validateUnirecTemplate();
@@ -16,6 +16,9 @@
 
 namespace ListDetector {
 
+class Rule;
+class RuleBuilder;
+
 /**
  * @brief Base class for parsing and processing list detector configuration data.
  *
@@ -51,6 +54,17 @@ public:
 	 */
 	std::vector<RuleDescription> getRulesDescription() const { return m_rulesDescription; }
 
+	/**
+	 * Build rules of the configuration.
+	 *
+	 * The default implementation builds the kept rules descriptions one by one. Parsers that do
+	 * not keep descriptions of all rules override it and read the rules from their source.
+	 *
+	 * @param ruleBuilder Builder of the rules for the Unirec template of the configuration.
+	 * @return Rules in the order of the configuration.
+	 */
+	virtual std::vector<Rule> buildRules(RuleBuilder& ruleBuilder) const;
+
 protected:
 	/**
 	 * Set the Unirec template.
@@ -8,34 +8,136 @@
  */
 
 #include "csvConfigParser.hpp"
+#include "csv/csvLine.hpp"
+#include "ruleBuilder.hpp"
 
-#include <cassert>
+#include <algorithm>
+#include <exception>
+#include <fcntl.h>
 #include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 
 namespace ListDetector {
 
-static rapidcsv::LineReaderParams buildLineReaderParams()
-{
-	const bool skipCommentLines = true;
-	const char commentPrefix = '#';
-	const bool skipEmptyLines = true;
+namespace {
+
+/**
+ * @brief Read only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& filename)
+	{
+		const int fileDescriptor = open(filename.c_str(), O_RDONLY);
+		if (fileDescriptor < 0) {
+			throw std::runtime_error("Unable to open file " + filename);
+		}
+
+		struct stat fileStat {};
+		if (fstat(fileDescriptor, &fileStat) != 0) {
+			close(fileDescriptor);
+			throw std::runtime_error("Unable to get size of file " + filename);
+		}
+
+		m_size = static_cast<size_t>(fileStat.st_size);
+		if (m_size != 0) {
+			m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		}
+		close(fileDescriptor);
+		if (m_data == MAP_FAILED) {
+			throw std::runtime_error("Unable to map file " + filename);
+		}
+		if (m_data != nullptr) {
+			madvise(m_data, m_size, MADV_SEQUENTIAL);
+		}
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile()
+	{
+		if (m_data != nullptr && m_data != MAP_FAILED) {
+			munmap(m_data, m_size);
+		}
+	}
 
-	return rapidcsv::LineReaderParams(skipCommentLines, commentPrefix, skipEmptyLines);
+	std::string_view getContent() const noexcept
+	{
+		return {static_cast<const char*>(m_data), m_size};
+	}
+
+	/**
+	 * @brief Drops pages of the already processed part of the file from the process memory.
+	 */
+	void release(size_t end) const noexcept
+	{
+		const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		const size_t releasedSize = end / pageSize * pageSize;
+		if (releasedSize != 0) {
+			madvise(m_data, releasedSize, MADV_DONTNEED);
+		}
+	}
+
+private:
+	void* m_data = nullptr;
+	size_t m_size = 0;
+};
+
+} // namespace
+
+static const char g_COMMENT_PREFIX = '#';
+
+/**
+ * @brief Returns position of the first line starting at the position or after it.
+ */
+static size_t findLineStart(std::string_view content, size_t position) noexcept
+{
+	if (position == 0 || position >= content.size()) {
+		return std::min(position, content.size());
+	}
+	const size_t lineEnd = content.find('\n', position - 1);
+	return lineEnd == std::string_view::npos ? content.size() : lineEnd + 1;
 }
 
-static rapidcsv::SeparatorParams buildSeparatorParams()
+/**
+ * @brief Reads the line without the line terminator, comment lines are returned empty.
+ * @param content Content of the file.
+ * @param lineStart Position of the line.
+ * @param nextLineStart Set to position of the next line.
+ */
+static std::string_view
+readLine(std::string_view content, size_t lineStart, size_t& nextLineStart) noexcept
 {
-	const char separator = ',';
-	const bool trim = true;
+	nextLineStart = findLineStart(content, lineStart + 1);
+	std::string_view line = content.substr(lineStart, nextLineStart - lineStart);
+	if (!line.empty() && line.back() == '\n') {
+		line.remove_suffix(1);
+	}
+	if (!line.empty() && line.back() == '\r') {
+		line.remove_suffix(1);
+	}
+	if (!line.empty() && line.front() == g_COMMENT_PREFIX) {
+		return {};
+	}
+	return line;
+}
 
-	return rapidcsv::SeparatorParams(separator, trim);
+static size_t getLineNumber(std::string_view content, size_t position)
+{
+	const std::string_view preceding = content.substr(0, position);
+	return static_cast<size_t>(std::count(preceding.begin(), preceding.end(), '\n')) + 1;
 }
 
 CsvConfigParser::CsvConfigParser(const std::string& configFilename)
+	: m_configFilename(configFilename)
 {
 	try {
-		loadFileAsDocument(configFilename);
-		parse();
+		const MappedFile file(configFilename);
+		parseHeader(file.getContent());
 		validate();
 	} catch (const std::exception& ex) {
 		m_logger->error(ex.what());
@@ -43,36 +145,108 @@ CsvConfigParser::CsvConfigParser(const std::string& configFilename)
 	}
 }
 
-void CsvConfigParser::loadFileAsDocument(const std::string& configFilename)
+void CsvConfigParser::parseHeader(std::string_view content)
 {
-	auto lineReaderParams = buildLineReaderParams();
-	auto separatorParams = buildSeparatorParams();
-
-	m_csvDocument.Load(
-		configFilename,
-		rapidcsv::LabelParams(),
-		separatorParams,
-		rapidcsv::ConverterParams(),
-		lineReaderParams);
+	size_t lineStart = 0;
+	while (lineStart < content.size()) {
+		const std::string_view line = readLine(content, lineStart, lineStart);
+		if (!line.empty()) {
+			setUnirecTemplate(Nm::splitLine(line));
+			m_rulesOffset = lineStart;
+			return;
+		}
+	}
+	throw std::runtime_error("File " + m_configFilename + " has no header");
 }
 
-void CsvConfigParser::parse()
+std::vector<Rule> CsvConfigParser::parseRules(
+	std::string_view content,
+	size_t begin,
+	size_t end,
+	const RuleBuilder& ruleBuilder) const
 {
-	parseHeader();
-	parseRows();
+	std::vector<Rule> rules;
+	size_t lineStart = begin;
+	try {
+		while (lineStart < end) {
+			size_t nextLineStart;
+			const std::string_view line = readLine(content, lineStart, nextLineStart);
+			if (!line.empty()) {
+				rules.emplace_back(ruleBuilder.parse(Nm::splitLine(line)));
+			}
+			lineStart = nextLineStart;
+		}
+	} catch (const std::exception& ex) {
+		m_logger->error(
+			"Invalid rule on line {} of {}: {}",
+			getLineNumber(content, lineStart),
+			m_configFilename,
+			ex.what());
+		throw std::runtime_error("CsvConfigParser::parseRules() has failed");
+	}
+	return rules;
 }
 
-void CsvConfigParser::parseHeader()
+std::vector<Rule> CsvConfigParser::buildRules(RuleBuilder& ruleBuilder) const
 {
-	setUnirecTemplate(m_csvDocument.GetColumnNames());
-}
+	const MappedFile file(m_configFilename);
+	const std::string_view content = file.getContent();
+	const size_t maxThreadsCount = std::max(1U, std::thread::hardware_concurrency());
 
-void CsvConfigParser::parseRows()
-{
-	for (size_t rowIndex = 0; rowIndex < m_csvDocument.GetRowCount(); rowIndex++) {
-		auto ruleDescription = m_csvDocument.GetRow<std::string>(rowIndex);
-		addRule(ruleDescription);
+	std::vector<Rule> rules;
+	size_t windowBegin = m_rulesOffset;
+	while (windowBegin < content.size()) {
+		const size_t windowEnd = findLineStart(content, windowBegin + WINDOW_SIZE);
+		const size_t windowSize = windowEnd - windowBegin;
+		const size_t threadsCount = std::min(maxThreadsCount, windowSize / MIN_PART_SIZE + 1);
+
+		std::vector<size_t> partsBounds = {windowBegin};
+		for (size_t partIndex = 1; partIndex < threadsCount; partIndex++) {
+			partsBounds.emplace_back(std::max(
+				partsBounds.back(),
+				findLineStart(content, windowBegin + windowSize * partIndex / threadsCount)));
+		}
+		partsBounds.emplace_back(windowEnd);
+
+		std::vector<std::vector<Rule>> partsRules(threadsCount);
+		std::vector<std::exception_ptr> partsErrors(threadsCount);
+		auto parsePart = [&](size_t partIndex) {
+			try {
+				partsRules[partIndex] = parseRules(
+					content,
+					partsBounds[partIndex],
+					partsBounds[partIndex + 1],
+					ruleBuilder);
+			} catch (...) {
+				partsErrors[partIndex] = std::current_exception();
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (size_t partIndex = 1; partIndex < threadsCount; partIndex++) {
+			threads.emplace_back(parsePart, partIndex);
+		}
+		parsePart(0);
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		// Rules are added to the field matchers in the order of the file
+		for (size_t partIndex = 0; partIndex < threadsCount; partIndex++) {
+			if (partsErrors[partIndex]) {
+				std::rethrow_exception(partsErrors[partIndex]);
+			}
+			for (auto& rule : partsRules[partIndex]) {
+				ruleBuilder.add(rule);
+				rules.emplace_back(std::move(rule));
+			}
+			partsRules[partIndex].clear();
+		}
+
+		file.release(windowEnd);
+		windowBegin = windowEnd;
 	}
+	return rules;
 }
 
 } // namespace ListDetector
@@ -10,34 +10,63 @@
 
 #include "configParser.hpp"
 #include "logger/logger.hpp"
+#include "rule.hpp"
 
+#include <cstddef>
 #include <memory>
-#include <rapidcsv.h>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace ListDetector {
 
 /**
  * @brief Class for parsing and processing CSV rules file
+ *
+ * Only the header is parsed when the parser is created. Rules are streamed from the memory
+ * mapped file when they are built: the file is processed in windows of `WINDOW_SIZE` bytes, each
+ * window is split at line boundaries and the parts are converted to rules by several threads.
+ * Text of the rules is never kept, so `getRulesDescription()` returns no rules.
  */
 class CsvConfigParser : public ConfigParser {
 public:
 	/**
-	 * @brief Open and parse a CSV configuration file
+	 * @brief Number of bytes of the file converted to rules at once.
+	 */
+	static inline const size_t WINDOW_SIZE = 64 * 1024 * 1024;
+
+	/**
+	 * @brief Minimal number of bytes converted by one thread.
+	 */
+	static inline const size_t MIN_PART_SIZE = 1024 * 1024;
+
+	/**
+	 * @brief Open a CSV configuration file and parse its header
 	 *
 	 * @param configFilename Path to configuration file
 	 * @throw std::runtime_error If an error occurs during parsing
 	 */
 	explicit CsvConfigParser(const std::string& configFilename);
 
-private:
-	void loadFileAsDocument(const std::string& configFilename);
+	/**
+	 * @brief Build rules from the rows of the CSV file
+	 *
+	 * @param ruleBuilder Builder of the rules for the Unirec template of the file
+	 * @return Rules in the order of the rows
+	 * @throw std::runtime_error If some row is not a valid rule
+	 */
+	std::vector<Rule> buildRules(RuleBuilder& ruleBuilder) const override;
 
-	void parse();
-	void parseHeader();
-	void parseRows();
+private:
+	void parseHeader(std::string_view content);
+	std::vector<Rule> parseRules(
+		std::string_view content,
+		size_t begin,
+		size_t end,
+		const RuleBuilder& ruleBuilder) const;
 
-	rapidcsv::Document m_csvDocument;
+	std::string m_configFilename;
+	size_t m_rulesOffset = 0;
 
 	std::shared_ptr<spdlog::logger> m_logger = Nm::loggerGet("CsvConfigParser");
 };
@@ -0,0 +1,191 @@
+/**
+ * @file
+ * @brief Implementation of the EvaluationPlanner class ordering matching stages by their
+ * selectivity.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "evaluationPlanner.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ListDetector {
+
+static double getRatio(const Nm::Counter& part, const Nm::Counter& total) noexcept
+{
+	if (total.load() == 0) {
+		return 0;
+	}
+	return static_cast<double>(part.load()) / static_cast<double>(total.load());
+}
+
+static double getPassRatio(const FilterStageStats& stats) noexcept
+{
+	if (stats.inputCandidatesCount.load() == 0) {
+		return 1;
+	}
+	return getRatio(stats.outputCandidatesCount, stats.inputCandidatesCount);
+}
+
+/**
+ * @brief Returns the mean measured time of the stage, at least one tick not to divide by zero.
+ */
+static double getMeanCost(const Nm::Counter& sampledTime, const Nm::Counter& sampledCount)
+{
+	return std::max(1.0, getRatio(sampledTime, sampledCount));
+}
+
+static void halve(Nm::Counter& counter) noexcept
+{
+	counter.store(counter.load() / 2);
+}
+
+EvaluationPlanner::EvaluationPlanner(size_t filterStagesCount, size_t maskGroupsCount)
+	: m_filterStagesOrder(filterStagesCount)
+	, m_maskGroupsOrder(maskGroupsCount)
+	, m_filterStagesStats(filterStagesCount)
+	, m_maskGroupsStats(maskGroupsCount)
+{
+	std::iota(m_filterStagesOrder.begin(), m_filterStagesOrder.end(), 0);
+	std::iota(m_maskGroupsOrder.begin(), m_maskGroupsOrder.end(), 0);
+	publishOrder();
+}
+
+bool EvaluationPlanner::nextRecord()
+{
+	m_recordsCount++;
+	if (m_recordsCount % REPLANNING_PERIOD == 0) {
+		replan();
+	}
+	m_isSampledRecord = m_recordsCount % SAMPLING_PERIOD == 0;
+	return m_isSampledRecord;
+}
+
+bool EvaluationPlanner::isSampledRecord() const noexcept
+{
+	return m_isSampledRecord;
+}
+
+void EvaluationPlanner::replan()
+{
+	// Rank of a stage is the fraction of eliminated candidates per unit of cost
+	std::vector<double> filterStagesRanks(m_filterStagesStats.size());
+	for (size_t stageIndex = 0; stageIndex < filterStagesRanks.size(); stageIndex++) {
+		const FilterStageStats& stats = m_filterStagesStats[stageIndex];
+		filterStagesRanks[stageIndex] = (1 - getPassRatio(stats))
+			/ getMeanCost(stats.sampledTime, stats.sampledCount);
+	}
+	std::stable_sort(
+		m_filterStagesOrder.begin(),
+		m_filterStagesOrder.end(),
+		[&filterStagesRanks](size_t left, size_t right) {
+			return filterStagesRanks[left] > filterStagesRanks[right];
+		});
+
+	// Rank of a group is the fraction of matches per unit of cost, groups of equal rank run
+	// from the lowest expected cost per record
+	std::vector<double> maskGroupsRanks(m_maskGroupsStats.size());
+	std::vector<double> maskGroupsExpectedCosts(m_maskGroupsStats.size());
+	for (size_t groupIndex = 0; groupIndex < maskGroupsRanks.size(); groupIndex++) {
+		const MaskGroupStats& stats = m_maskGroupsStats[groupIndex];
+		const double cost = getMeanCost(stats.sampledTime, stats.sampledCount);
+		const uint64_t recordsCount = stats.skippedCount.load() + stats.evaluatedCount.load();
+		const double evaluatedRatio = recordsCount == 0
+			? 1.0
+			: static_cast<double>(stats.evaluatedCount.load()) / static_cast<double>(recordsCount);
+		maskGroupsRanks[groupIndex] = getRatio(stats.matchedCount, stats.evaluatedCount) / cost;
+		maskGroupsExpectedCosts[groupIndex] = evaluatedRatio * cost;
+	}
+	std::stable_sort(
+		m_maskGroupsOrder.begin(),
+		m_maskGroupsOrder.end(),
+		[&maskGroupsRanks, &maskGroupsExpectedCosts](size_t left, size_t right) {
+			if (maskGroupsRanks[left] != maskGroupsRanks[right]) {
+				return maskGroupsRanks[left] > maskGroupsRanks[right];
+			}
+			return maskGroupsExpectedCosts[left] < maskGroupsExpectedCosts[right];
+		});
+
+	publishOrder();
+	ageStats();
+}
+
+void EvaluationPlanner::publishOrder()
+{
+	const std::lock_guard<std::mutex> lock(m_publishedOrder->mutex);
+	m_publishedOrder->filterStagesOrder = m_filterStagesOrder;
+	m_publishedOrder->maskGroupsOrder = m_maskGroupsOrder;
+}
+
+void EvaluationPlanner::ageStats() noexcept
+{
+	for (auto& stats : m_filterStagesStats) {
+		halve(stats.inputCandidatesCount);
+		halve(stats.outputCandidatesCount);
+		halve(stats.sampledCount);
+		halve(stats.sampledTime);
+	}
+	for (auto& stats : m_maskGroupsStats) {
+		halve(stats.skippedCount);
+		halve(stats.evaluatedCount);
+		halve(stats.matchedCount);
+		halve(stats.sampledCount);
+		halve(stats.sampledTime);
+	}
+}
+
+const std::vector<size_t>& EvaluationPlanner::getFilterStagesOrder() const noexcept
+{
+	return m_filterStagesOrder;
+}
+
+const std::vector<size_t>& EvaluationPlanner::getMaskGroupsOrder() const noexcept
+{
+	return m_maskGroupsOrder;
+}
+
+std::vector<size_t> EvaluationPlanner::getPublishedFilterStagesOrder() const
+{
+	const std::lock_guard<std::mutex> lock(m_publishedOrder->mutex);
+	return m_publishedOrder->filterStagesOrder;
+}
+
+std::vector<size_t> EvaluationPlanner::getPublishedMaskGroupsOrder() const
+{
+	const std::lock_guard<std::mutex> lock(m_publishedOrder->mutex);
+	return m_publishedOrder->maskGroupsOrder;
+}
+
+FilterStageStats& EvaluationPlanner::getFilterStageStats(size_t stageIndex) noexcept
+{
+	return m_filterStagesStats[stageIndex];
+}
+
+MaskGroupStats& EvaluationPlanner::getMaskGroupStats(size_t groupIndex) noexcept
+{
+	return m_maskGroupsStats[groupIndex];
+}
+
+void EvaluationPlanner::countEarlyExit() noexcept
+{
+	m_earlyExitsCount.add();
+}
+
+const std::vector<FilterStageStats>& EvaluationPlanner::getFilterStagesStats() const noexcept
+{
+	return m_filterStagesStats;
+}
+
+const std::vector<MaskGroupStats>& EvaluationPlanner::getMaskGroupsStats() const noexcept
+{
+	return m_maskGroupsStats;
+}
+
+uint64_t EvaluationPlanner::getEarlyExitsCount() const noexcept
+{
+	return m_earlyExitsCount.load();
+}
+
+} // namespace ListDetector
@@ -0,0 +1,175 @@
+/**
+ * @file
+ * @brief Declaration of the EvaluationPlanner class ordering matching stages by their selectivity.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "counter/counter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Statistics of a filter stage (IP or interval field matcher).
+ */
+struct FilterStageStats {
+	Nm::Counter inputCandidatesCount; ///< Candidate rules before the stage in sampled records.
+	Nm::Counter outputCandidatesCount; ///< Candidate rules after the stage in sampled records.
+	Nm::Counter sampledCount; ///< Evaluations of the stage in sampled records.
+	Nm::Counter sampledTime; ///< Time of the sampled evaluations in clock ticks.
+};
+
+/**
+ * @brief Statistics of a group of rules sharing the same set of static fields.
+ */
+struct MaskGroupStats {
+	Nm::Counter skippedCount; ///< Records where no rule of the group was a candidate.
+	Nm::Counter evaluatedCount; ///< Records where the static fields of the group were hashed.
+	Nm::Counter matchedCount; ///< Records where some rule of the group matched.
+	Nm::Counter sampledCount; ///< Evaluations of the group in sampled records.
+	Nm::Counter sampledTime; ///< Time of the sampled evaluations in clock ticks.
+};
+
+/**
+ * @brief Orders matching stages by runtime statistics of one matching context.
+ *
+ * Filter stages are ordered by the fraction of eliminated candidates per unit of their measured
+ * cost, so the most selective cheap stages run first and the matching can end as soon as no
+ * candidate rule is left. Mask groups are ordered by matches per unit of their measured cost, and
+ * groups without matches, e.g. of a blacklist, by their expected cost per record, which is the
+ * cost of an evaluation weighted by the fraction of records where the group is not skipped.
+ * Statistics are aged by halving on every replanning, so the plan follows changes of the traffic.
+ * Statistics and costs of stages are updated only for every `SAMPLING_PERIOD`-th record, because
+ * counting of candidates and reading of the clock are not free.
+ *
+ * The planner is owned by one matching thread. Statistics are counters and the order is
+ * published as a copy under a mutex on every replanning, so the telemetry can read them anytime.
+ */
+class EvaluationPlanner {
+public:
+	/**
+	 * @brief Every n-th record updates the statistics and the costs of stages.
+	 */
+	static inline const uint64_t SAMPLING_PERIOD = 64;
+
+	/**
+	 * @brief Number of records between two replannings.
+	 */
+	static inline const uint64_t REPLANNING_PERIOD = 65536;
+
+	EvaluationPlanner() = default;
+
+	/**
+	 * @brief Constructs the planner with the initial order of stages given by their indexes.
+	 * @param filterStagesCount Number of filter stages.
+	 * @param maskGroupsCount Number of mask groups.
+	 */
+	EvaluationPlanner(size_t filterStagesCount, size_t maskGroupsCount);
+
+	/**
+	 * @brief Advances to the next record and replans if the replanning period elapsed.
+	 * @return True if the statistics of stages should be updated for the record.
+	 */
+	bool nextRecord();
+
+	/**
+	 * @brief Checks if the statistics of stages are updated for the current record.
+	 * @return Value returned by the last call of `nextRecord()`.
+	 */
+	bool isSampledRecord() const noexcept;
+
+	/**
+	 * @brief Returns current order of the filter stages. Only for the owning thread.
+	 * @return Indexes of the filter stages in the order of evaluation.
+	 */
+	const std::vector<size_t>& getFilterStagesOrder() const noexcept;
+
+	/**
+	 * @brief Returns current order of the mask groups. Only for the owning thread.
+	 * @return Indexes of the mask groups in the order of evaluation.
+	 */
+	const std::vector<size_t>& getMaskGroupsOrder() const noexcept;
+
+	/**
+	 * @brief Returns the order of the filter stages published by the last replanning.
+	 * @return Copy of the indexes of the filter stages in the order of evaluation.
+	 */
+	std::vector<size_t> getPublishedFilterStagesOrder() const;
+
+	/**
+	 * @brief Returns the order of the mask groups published by the last replanning.
+	 * @return Copy of the indexes of the mask groups in the order of evaluation.
+	 */
+	std::vector<size_t> getPublishedMaskGroupsOrder() const;
+
+	/**
+	 * @brief Returns statistics of the filter stage.
+	 * @param stageIndex Index of the filter stage.
+	 * @return Reference to the statistics.
+	 */
+	FilterStageStats& getFilterStageStats(size_t stageIndex) noexcept;
+
+	/**
+	 * @brief Returns statistics of the mask group.
+	 * @param groupIndex Index of the mask group.
+	 * @return Reference to the statistics.
+	 */
+	MaskGroupStats& getMaskGroupStats(size_t groupIndex) noexcept;
+
+	/**
+	 * @brief Counts the record whose matching ended because no candidate rule was left.
+	 */
+	void countEarlyExit() noexcept;
+
+	/**
+	 * @brief Returns statistics of all filter stages.
+	 * @return Statistics indexed by the filter stage index.
+	 */
+	const std::vector<FilterStageStats>& getFilterStagesStats() const noexcept;
+
+	/**
+	 * @brief Returns statistics of all mask groups.
+	 * @return Statistics indexed by the mask group index.
+	 */
+	const std::vector<MaskGroupStats>& getMaskGroupsStats() const noexcept;
+
+	/**
+	 * @brief Returns total number of records whose matching ended early.
+	 * @return Number of early exits.
+	 */
+	uint64_t getEarlyExitsCount() const noexcept;
+
+private:
+	/**
+	 * @brief Order of stages read by the telemetry while the owning thread replans.
+	 */
+	struct PublishedOrder {
+		std::mutex mutex;
+		std::vector<size_t> filterStagesOrder;
+		std::vector<size_t> maskGroupsOrder;
+	};
+
+	void replan();
+	void publishOrder();
+	void ageStats() noexcept;
+
+	std::vector<size_t> m_filterStagesOrder;
+	std::vector<size_t> m_maskGroupsOrder;
+	std::vector<FilterStageStats> m_filterStagesStats;
+	std::vector<MaskGroupStats> m_maskGroupsStats;
+	std::unique_ptr<PublishedOrder> m_publishedOrder = std::make_unique<PublishedOrder>();
+
+	uint64_t m_recordsCount = 0;
+	bool m_isSampledRecord = false;
+	Nm::Counter m_earlyExitsCount;
+};
+
+} // namespace ListDetector
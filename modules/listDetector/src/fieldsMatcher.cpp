@@ -8,95 +8,105 @@
  */
 
 #include "fieldsMatcher.hpp"
+#include "instrumentation/timer.hpp"
 
 #include <algorithm>
 #include <cstring>
+#include <new>
 #include <stdexcept>
-#include <xxhash.h>
+#include <string>
 
 namespace ListDetector {
 
-static std::pair<const char*, size_t>
-getStaticFieldAsCharPtr(const Nemea::UnirecRecordView& unirecRecordView, ur_field_id_t fieldId)
-{
-	switch (ur_get_type(fieldId)) {
-	case UR_TYPE_CHAR:
-		return {unirecRecordView.getFieldAsType<const char*>(fieldId), sizeof(char)};
-	case UR_TYPE_UINT8:
-		return {
-			reinterpret_cast<const char*>(unirecRecordView.getFieldAsType<const uint8_t*>(fieldId)),
-			sizeof(uint8_t)};
-	case UR_TYPE_INT8:
-		return {
-			reinterpret_cast<const char*>(unirecRecordView.getFieldAsType<const int8_t*>(fieldId)),
-			sizeof(int8_t)};
-	case UR_TYPE_UINT16:
-		return {
-			reinterpret_cast<const char*>(
-				unirecRecordView.getFieldAsType<const uint16_t*>(fieldId)),
-			sizeof(uint16_t)};
-	case UR_TYPE_INT16:
-		return {
-			reinterpret_cast<const char*>(unirecRecordView.getFieldAsType<const int16_t*>(fieldId)),
-			sizeof(int16_t)};
-	case UR_TYPE_UINT32:
-		return {
-			reinterpret_cast<const char*>(
-				unirecRecordView.getFieldAsType<const uint32_t*>(fieldId)),
-			sizeof(uint32_t)};
-	case UR_TYPE_INT32:
-		return {
-			reinterpret_cast<const char*>(unirecRecordView.getFieldAsType<const int32_t*>(fieldId)),
-			sizeof(int32_t)};
-	case UR_TYPE_UINT64:
-		return {
-			reinterpret_cast<const char*>(
-				unirecRecordView.getFieldAsType<const uint64_t*>(fieldId)),
-			sizeof(uint64_t)};
-	case UR_TYPE_INT64:
-		return {
-			reinterpret_cast<const char*>(unirecRecordView.getFieldAsType<const int64_t*>(fieldId)),
-			sizeof(int64_t)};
-	case UR_TYPE_STRING: {
-		auto str = unirecRecordView.getFieldAsType<std::string_view>(fieldId);
-		return {str.data(), str.length()};
+std::vector<FieldsMatcher::KeyField> FieldsMatcher::compileKeyFields(
+	const std::vector<ur_field_id_t>& fieldIds,
+	const std::vector<bool>& presentedFieldsMask)
+{
+	std::vector<KeyField> keyFields;
+	for (size_t fieldIndex = 0; fieldIndex < fieldIds.size(); fieldIndex++) {
+		if (!presentedFieldsMask[fieldIndex]) {
+			continue;
+		}
+
+		const ur_field_id_t fieldId = fieldIds[fieldIndex];
+		if (ur_is_dynamic(fieldId) != 0) {
+			if (ur_get_type(fieldId) != UR_TYPE_STRING) {
+				throw std::invalid_argument(
+					std::string("Given field id ") + std::to_string(fieldId)
+					+ " is not a static field");
+			}
+			keyFields.push_back({fieldId, 0});
+		} else {
+			keyFields.push_back({fieldId, static_cast<uint16_t>(ur_get_size(fieldId))});
+		}
 	}
-	default:
-		throw std::invalid_argument(
-			std::string("Given field id ") + std::to_string(fieldId) + " is not a static field");
+	return keyFields;
+}
+
+HashState FieldsMatcher::createHashState()
+{
+	HashState hashState(XXH3_createState(), XXH3_freeState);
+	if (!hashState) {
+		throw std::bad_alloc();
 	}
-	return {nullptr, 0};
+	return hashState;
 }
 
-static void writeFieldToBuffer(
-	std::vector<std::byte>& buffer,
-	size_t& writePos,
+uint64_t FieldsMatcher::calculateStaticHash(
 	const Nemea::UnirecRecordView& unirecRecordView,
-	ur_field_id_t fieldId)
+	const std::vector<KeyField>& keyFields,
+	XXH3_state_t* hashState)
 {
-	auto [ptr, length] = getStaticFieldAsCharPtr(unirecRecordView, fieldId);
-	if (writePos + length >= buffer.capacity()) {
-		buffer.resize(writePos + (4 * length));
+	// Fields are hashed directly from the record, the result equals hash of their concatenation
+	XXH3_64bits_reset(hashState);
+	for (const auto& [fieldId, size] : keyFields) {
+		if (size == 0) {
+			const auto value = unirecRecordView.getFieldAsType<std::string_view>(fieldId);
+			XXH3_64bits_update(hashState, value.data(), value.length());
+		} else {
+			XXH3_64bits_update(
+				hashState,
+				unirecRecordView.getFieldAsType<const uint8_t*>(fieldId),
+				size);
+		}
 	}
-	std::memcpy(buffer.data() + writePos, ptr, length);
-	writePos += length;
+	return XXH3_64bits_digest(hashState);
 }
 
-uint64_t FieldsMatcher::calculateStaticHash(
+static void appendBytes(std::vector<std::byte>& buffer, const void* data, size_t size)
+{
+	const auto* bytes = static_cast<const std::byte*>(data);
+	buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+void FieldsMatcher::packRuleFields(
 	const Nemea::UnirecRecordView& unirecRecordView,
-	const std::vector<bool>& presentedStaticFieldsMask)
+	std::vector<std::byte>& key) const
 {
-	size_t writePos = 0;
-	for (auto fieldIndex = 0U; fieldIndex < m_fieldIds.size(); fieldIndex++) {
-		if (!presentedStaticFieldsMask[fieldIndex]) {
-			continue;
+	key.clear();
+	for (const auto& [fieldId, size] : m_ruleKeyFields) {
+		if (size == 0) {
+			// Length is packed too, so values of adjacent strings can not be interchanged
+			const auto value = unirecRecordView.getFieldAsType<std::string_view>(fieldId);
+			const auto length = static_cast<uint16_t>(value.length());
+			appendBytes(key, &length, sizeof(length));
+			appendBytes(key, value.data(), value.length());
+		} else {
+			appendBytes(key, unirecRecordView.getFieldAsType<const uint8_t*>(fieldId), size);
 		}
-		writeFieldToBuffer(m_buffer, writePos, unirecRecordView, m_fieldIds[fieldIndex]);
 	}
-	return XXH64(m_buffer.data(), writePos, 0);
 }
 
-FieldsMatcher::FieldsMatcher(std::vector<Rule>& rules)
+size_t FieldsMatcher::getPackedRuleFieldsSize(size_t stringLength) const noexcept
+{
+	size_t packedSize = 0;
+	for (const auto& [fieldId, size] : m_ruleKeyFields) {
+		packedSize += size == 0 ? sizeof(uint16_t) + stringLength : size;
+	}
+	return packedSize;
+}
+
+FieldsMatcher::FieldsMatcher(const std::vector<Rule>& rules)
 	: m_rules(rules)
 {
 	if (!rules.empty()) {
@@ -106,24 +116,78 @@ FieldsMatcher::FieldsMatcher(std::vector<Rule>& rules)
 			std::back_inserter(m_fieldIds),
 			[](const RuleField& ruleField) { return ruleField.first; });
 	}
+	m_ruleKeyFields = compileKeyFields(m_fieldIds, std::vector<bool>(m_fieldIds.size(), true));
+
+	std::unordered_map<std::vector<bool>, size_t> maskGroupIndexes;
+	std::vector<std::byte> hashBuffer;
+	for (uint32_t ruleIndex = 0; ruleIndex < rules.size(); ruleIndex++) {
+		const Rule& rule = rules[ruleIndex];
+		const auto [it, inserted] = maskGroupIndexes.emplace(
+			rule.getPresentedStaticFieldsMask(),
+			m_maskGroups.size());
+		if (inserted) {
+			m_maskGroups.push_back({compileKeyFields(m_fieldIds, it->first), {}});
+		}
 
-	for (const auto& rule : rules) {
-		resizeHashBuffer(rule);
-		m_rulesStaticHashIndexes.insert(std::make_pair(calculateStaticHash(rule), m_ruleIndex++));
-		m_presentedStaticFieldsMasks.emplace(rule.getPresentedStaticFieldsMask());
+		MaskGroup& maskGroup = m_maskGroups[it->second];
+		resizeHashBuffer(rule, hashBuffer);
+		const uint64_t staticHash = calculateStaticHash(rule, hashBuffer);
+		maskGroup.rulesStaticHashIndexes.emplace(staticHash, ruleIndex);
+		m_ruleMaskGroupIndexes.emplace_back(static_cast<uint32_t>(it->second));
+		m_ruleStaticHashes.emplace_back(staticHash);
 	}
 }
 
-void FieldsMatcher::resizeHashBuffer(const Rule& rule)
+size_t FieldsMatcher::getRuleMaskGroupIndex(size_t ruleIndex) const noexcept
+{
+	return m_ruleMaskGroupIndexes[ruleIndex];
+}
+
+uint64_t FieldsMatcher::getRuleStaticHash(size_t ruleIndex) const noexcept
+{
+	return m_ruleStaticHashes[ruleIndex];
+}
+
+bool FieldsMatcher::maskGroupHasStaticFields(size_t groupIndex) const noexcept
+{
+	return !m_maskGroups[groupIndex].keyFields.empty();
+}
+
+uint64_t FieldsMatcher::calculateMaskGroupHash(
+	const Nemea::UnirecRecordView& unirecRecordView,
+	size_t groupIndex,
+	XXH3_state_t* hashState) const
+{
+	return calculateStaticHash(unirecRecordView, m_maskGroups[groupIndex].keyFields, hashState);
+}
+
+void FieldsMatcher::countMaskGroupsCandidates(
+	const std::vector<bool>& candidateRulesMask,
+	std::vector<uint32_t>& candidatesCounts) const
+{
+	candidatesCounts.assign(m_maskGroups.size(), 0);
+	for (size_t ruleIndex = 0; ruleIndex < candidateRulesMask.size(); ruleIndex++) {
+		if (candidateRulesMask[ruleIndex]) {
+			candidatesCounts[m_ruleMaskGroupIndexes[ruleIndex]]++;
+		}
+	}
+}
+
+size_t FieldsMatcher::getMaskGroupsCount() const noexcept
+{
+	return m_maskGroups.size();
+}
+
+void FieldsMatcher::resizeHashBuffer(const Rule& rule, std::vector<std::byte>& hashBuffer)
 {
 	const size_t totalBufferLength = std::accumulate(
 		rule.getRuleFields().begin(),
 		rule.getRuleFields().end(),
 		0UL,
 		[](uint32_t length, const auto& ruleField) -> size_t {
-			// Wildcard and regex rule fields are not included in the hash value
+			// Wildcard, regex, IP and interval rule fields are not included in the hash value
 			if (Rule::isWildcardRuleField(ruleField) || Rule::isRegexRuleField(ruleField)
-				|| Rule::isIPRuleField(ruleField)) {
+				|| Rule::isIPRuleField(ruleField) || Rule::isIntervalRuleField(ruleField)) {
 				return length;
 			}
 			if (Rule::isStaticRuleField(ruleField)) {
@@ -134,29 +198,82 @@ void FieldsMatcher::resizeHashBuffer(const Rule& rule)
 			}
 			throw std::runtime_error("Unexpected rule field type");
 		});
-	m_buffer.resize(totalBufferLength);
+	hashBuffer.resize(totalBufferLength);
 }
 
-bool FieldsMatcher::anyOfRulesMatch(
+std::optional<size_t> FieldsMatcher::getMatchingRuleIndex(
 	const Nemea::UnirecRecordView& unirecRecordView,
-	const std::vector<bool>& previouslyMatchedRulesMask)
+	const std::vector<bool>& previouslyMatchedRulesMask,
+	const std::vector<uint32_t>& maskGroupsCandidatesCounts,
+	EvaluationPlanner& planner,
+	XXH3_state_t* hashState,
+	RulesProfiler* profiler) const
 {
-	bool match = false;
+	const bool isSampled = profiler != nullptr && profiler->nextRecord();
+	const bool isPlannerSampled = planner.isSampledRecord();
+
+	for (const size_t groupIndex : planner.getMaskGroupsOrder()) {
+		const MaskGroup& maskGroup = m_maskGroups[groupIndex];
+		MaskGroupStats& maskGroupStats = planner.getMaskGroupStats(groupIndex);
+
+		if (maskGroupsCandidatesCounts[groupIndex] == 0) {
+			maskGroupStats.skippedCount.add();
+			continue;
+		}
+
+		maskGroupStats.evaluatedCount.add();
+		const uint64_t groupStart = isPlannerSampled ? Nm::InstrumentationClock::now() : 0;
+		const uint64_t lookupStart = isSampled ? RulesProfiler::now() : 0;
+		const uint64_t hashValue
+			= calculateStaticHash(unirecRecordView, maskGroup.keyFields, hashState);
+		auto [it, rangeEnd] = maskGroup.rulesStaticHashIndexes.equal_range(hashValue);
+		if (isSampled) {
+			profiler->addLookupSample(groupIndex, RulesProfiler::now() - lookupStart);
+		}
 
-	for (const auto& presentedStaticFieldsMask : m_presentedStaticFieldsMasks) {
-		const size_t hashValue = calculateStaticHash(unirecRecordView, presentedStaticFieldsMask);
+		std::optional<size_t> matchedRuleIndex;
+		for (; it != rangeEnd; it++) {
+			if (!previouslyMatchedRulesMask[it->second]) {
+				continue;
+			}
+			if (evaluateCandidate(it->second, groupIndex, unirecRecordView, profiler, isSampled)) {
+				maskGroupStats.matchedCount.add();
+				matchedRuleIndex = it->second;
+				break;
+			}
+		}
 
-		for (auto [it, rangeEnd] = m_rulesStaticHashIndexes.equal_range(hashValue);
-			 !match && it != rangeEnd;
-			 it++) {
-			match = previouslyMatchedRulesMask[it->second]
-				&& m_rules[it->second].dynamicFieldsMatch(unirecRecordView);
+		if (isPlannerSampled) {
+			maskGroupStats.sampledTime.add(Nm::InstrumentationClock::now() - groupStart);
+			maskGroupStats.sampledCount.add();
 		}
-		if (match) {
-			break;
+		if (matchedRuleIndex.has_value()) {
+			return matchedRuleIndex;
 		}
 	}
-	return match;
+	return std::nullopt;
+}
+
+bool FieldsMatcher::evaluateCandidate(
+	uint32_t ruleIndex,
+	size_t groupIndex,
+	const Nemea::UnirecRecordView& unirecRecordView,
+	RulesProfiler* profiler,
+	bool isSampled) const
+{
+	if (profiler == nullptr) {
+		return m_rules[ruleIndex].dynamicFieldsMatch(unirecRecordView);
+	}
+
+	profiler->countEvaluation(ruleIndex);
+	if (!isSampled) {
+		return m_rules[ruleIndex].dynamicFieldsMatch(unirecRecordView);
+	}
+
+	const uint64_t evaluationStart = RulesProfiler::now();
+	const bool matched = m_rules[ruleIndex].dynamicFieldsMatch(unirecRecordView);
+	profiler->addEvaluationSample(ruleIndex, groupIndex, RulesProfiler::now() - evaluationStart);
+	return matched;
 }
 
 struct StaticFieldsHashVisitor {
@@ -183,20 +300,20 @@ private:
 	size_t& m_writePos;
 };
 
-uint64_t FieldsMatcher::calculateStaticHash(const Rule& rule)
+uint64_t FieldsMatcher::calculateStaticHash(const Rule& rule, std::vector<std::byte>& hashBuffer)
 {
 	size_t writePos = 0;
 	for (const auto& ruleField : rule.getRuleFields()) {
 		if (Rule::isWildcardRuleField(ruleField) || Rule::isRegexRuleField(ruleField)
-			|| Rule::isIPRuleField(ruleField)) {
+			|| Rule::isIPRuleField(ruleField) || Rule::isIntervalRuleField(ruleField)) {
 			continue;
 		}
 		if (const std::optional<RuleFieldValue>& ruleFieldOpt = ruleField.second;
 			ruleFieldOpt.has_value()) {
-			std::visit(StaticFieldsHashVisitor {m_buffer.data(), writePos}, *ruleFieldOpt);
+			std::visit(StaticFieldsHashVisitor {hashBuffer.data(), writePos}, *ruleFieldOpt);
 		}
 	}
-	return XXH64(m_buffer.data(), writePos, 0);
+	return XXH3_64bits(hashBuffer.data(), writePos);
 }
 
 } // namespace ListDetector
@@ -9,17 +9,26 @@
 
 #pragma once
 
+#include "evaluationPlanner.hpp"
 #include "rule.hpp"
+#include "rulesProfiler.hpp"
 
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <unirec++/ipAddress.hpp>
 #include <unirec++/unirec.hpp>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
+#include <xxhash.h>
 
 namespace ListDetector {
 
+/**
+ * @brief Owning pointer to the state of the streaming hash of record fields.
+ */
+using HashState = std::unique_ptr<XXH3_state_t, XXH_errorcode (*)(XXH3_state_t*)>;
+
 /**
  * @brief Matches fields of Unirec records against UnirecordViews by hash value.
  */
@@ -29,33 +38,139 @@ public:
 	 * @brief Constructor for a StaticFieldsHasher.
 	 * @param rules reference to a vector of rule fields id.
 	 */
-	explicit FieldsMatcher(std::vector<Rule>& rules);
+	explicit FieldsMatcher(const std::vector<Rule>& rules);
 
 	/**
-	 * @brief Checks if some rule matches given Unirec view.
+	 * @brief Finds some rule that matches given Unirec view.
+	 *
+	 * Mask groups are evaluated in the order given by the planner. Groups without any candidate
+	 * rule are skipped without hashing.
+	 *
 	 * @param unirecRecordView The Unirec record view to find matching rules.
 	 * @param previouslyMatchedRulesMask Bitset of previously matched rules.
-	 * @return True if some rule matched, false otherwise.
+	 * @param maskGroupsCandidatesCounts Numbers of previously matched rules of each mask group.
+	 * @param planner Planner providing the order of mask groups and collecting their statistics.
+	 * @param hashState State of the streaming hash used for the static fields of the record.
+	 * @param profiler Profiler collecting the cost of rules and groups, nullptr if disabled.
+	 * @return Index of the matched rule, std::nullopt if no rule matched.
 	 */
-	bool anyOfRulesMatch(
+	std::optional<size_t> getMatchingRuleIndex(
 		const Nemea::UnirecRecordView& unirecRecordView,
-		const std::vector<bool>& previouslyMatchedRulesMask);
+		const std::vector<bool>& previouslyMatchedRulesMask,
+		const std::vector<uint32_t>& maskGroupsCandidatesCounts,
+		EvaluationPlanner& planner,
+		XXH3_state_t* hashState,
+		RulesProfiler* profiler = nullptr) const;
 
-private:
-	void resizeHashBuffer(const Rule& rule);
-	uint64_t calculateStaticHash(
+	/**
+	 * @brief Counts candidate rules of each mask group in one pass over the rules.
+	 * @param candidateRulesMask Bitset of rules which may match the record.
+	 * @param candidatesCounts Replaced by numbers of candidate rules, indexed by mask group.
+	 */
+	void countMaskGroupsCandidates(
+		const std::vector<bool>& candidateRulesMask,
+		std::vector<uint32_t>& candidatesCounts) const;
+
+	/**
+	 * @brief Returns number of groups of rules sharing the same set of static fields.
+	 * @return Number of mask groups.
+	 */
+	size_t getMaskGroupsCount() const noexcept;
+
+	/**
+	 * @brief Packs all fields of the Unirec view that are used by the rules.
+	 *
+	 * Strings are prefixed by their length, so equal keys mean equal values of all rule fields.
+	 *
+	 * @param unirecRecordView The Unirec record view to pack.
+	 * @param key Buffer replaced by the packed fields, reused to avoid allocations.
+	 */
+	void packRuleFields(
 		const Nemea::UnirecRecordView& unirecRecordView,
-		const std::vector<bool>& presentedStaticFieldsMask);
-	uint64_t calculateStaticHash(const Rule& rule);
+		std::vector<std::byte>& key) const;
 
-	std::vector<Rule>& m_rules;
-	std::unordered_multimap<size_t, uint16_t> m_rulesStaticHashIndexes;
-	std::vector<ur_field_id_t> m_fieldIds;
-	std::unordered_set<std::vector<bool>> m_presentedStaticFieldsMasks;
+	/**
+	 * @brief Returns size of the packed rule fields whose strings have the given length.
+	 * @param stringLength Length of each string field.
+	 * @return Size of the packed rule fields in bytes.
+	 */
+	size_t getPackedRuleFieldsSize(size_t stringLength) const noexcept;
 
-	std::vector<std::byte> m_buffer;
+	/**
+	 * @brief Returns index of the mask group the rule belongs to.
+	 * @param ruleIndex Index of the rule.
+	 * @return Index of the mask group.
+	 */
+	size_t getRuleMaskGroupIndex(size_t ruleIndex) const noexcept;
+
+	/**
+	 * @brief Returns hash of the static fields of the rule.
+	 * @param ruleIndex Index of the rule.
+	 * @return Hash value equal to the hash of matching records in the rule mask group.
+	 */
+	uint64_t getRuleStaticHash(size_t ruleIndex) const noexcept;
 
-	uint16_t m_ruleIndex = 0;
+	/**
+	 * @brief Checks if rules of the mask group have some static field.
+	 * @param groupIndex Index of the mask group.
+	 * @return True if the group hashes some field, false otherwise.
+	 */
+	bool maskGroupHasStaticFields(size_t groupIndex) const noexcept;
+
+	/**
+	 * @brief Calculates hash of the static fields of the mask group of the Unirec view.
+	 * @param unirecRecordView The Unirec record view to hash.
+	 * @param groupIndex Index of the mask group.
+	 * @param hashState State of the streaming hash used for the fields of the record.
+	 * @return Hash value of the static fields.
+	 */
+	uint64_t calculateMaskGroupHash(
+		const Nemea::UnirecRecordView& unirecRecordView,
+		size_t groupIndex,
+		XXH3_state_t* hashState) const;
+
+	/**
+	 * @brief Creates the state of the streaming hash for a matching thread.
+	 * @return Owning pointer to the hash state.
+	 */
+	static HashState createHashState();
+
+private:
+	/**
+	 * @brief Field of the hashed key with the size resolved when the matcher is built.
+	 */
+	struct KeyField {
+		ur_field_id_t fieldId; ///< Id of the field.
+		uint16_t size; ///< Size of the field in the record, 0 for variable length fields.
+	};
+
+	static void resizeHashBuffer(const Rule& rule, std::vector<std::byte>& hashBuffer);
+	static std::vector<KeyField> compileKeyFields(
+		const std::vector<ur_field_id_t>& fieldIds,
+		const std::vector<bool>& presentedFieldsMask);
+	static uint64_t calculateStaticHash(
+		const Nemea::UnirecRecordView& unirecRecordView,
+		const std::vector<KeyField>& keyFields,
+		XXH3_state_t* hashState);
+	static uint64_t calculateStaticHash(const Rule& rule, std::vector<std::byte>& hashBuffer);
+	bool evaluateCandidate(
+		uint32_t ruleIndex,
+		size_t groupIndex,
+		const Nemea::UnirecRecordView& unirecRecordView,
+		RulesProfiler* profiler,
+		bool isSampled) const;
+
+	struct MaskGroup {
+		std::vector<KeyField> keyFields;
+		std::unordered_multimap<uint64_t, uint32_t> rulesStaticHashIndexes;
+	};
+
+	const std::vector<Rule>& m_rules;
+	std::vector<ur_field_id_t> m_fieldIds;
+	std::vector<KeyField> m_ruleKeyFields;
+	std::vector<MaskGroup> m_maskGroups;
+	std::vector<uint32_t> m_ruleMaskGroupIndexes;
+	std::vector<uint64_t> m_ruleStaticHashes;
 };
 
 } // namespace ListDetector
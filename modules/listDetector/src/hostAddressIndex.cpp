@@ -0,0 +1,79 @@
+/**
+ * @file
+ * @brief Implementation of the HostAddressIndex class for matching IP addresses against host
+ * prefixes
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "hostAddressIndex.hpp"
+
+#include <cstring>
+#include <utility>
+#include <xxhash.h>
+
+namespace ListDetector {
+
+static bool isSameAddress(const ip_addr_t& left, const ip_addr_t& right) noexcept
+{
+	return std::memcmp(&left, &right, sizeof(ip_addr_t)) == 0;
+}
+
+size_t HostAddressIndex::findSlot(const ip_addr_t& address) const noexcept
+{
+	// Capacity is a power of two, empty slot always exists as the load factor is at most 1/2
+	const size_t slotMask = m_slots.size() - 1;
+	size_t slotIndex = static_cast<size_t>(XXH3_64bits(&address, sizeof(address))) & slotMask;
+	while (m_slots[slotIndex].firstEntry != NO_ENTRY
+		   && !isSameAddress(m_slots[slotIndex].address, address)) {
+		slotIndex = (slotIndex + 1) & slotMask;
+	}
+	return slotIndex;
+}
+
+void HostAddressIndex::grow()
+{
+	std::vector<Slot> slots = std::move(m_slots);
+	m_slots.assign(slots.empty() ? INITIAL_CAPACITY : slots.size() * 2, Slot {});
+	for (const auto& slot : slots) {
+		if (slot.firstEntry != NO_ENTRY) {
+			m_slots[findSlot(slot.address)] = slot;
+		}
+	}
+}
+
+void HostAddressIndex::insert(const Nemea::IpAddress& address, uint16_t ruleIndex)
+{
+	if ((m_addressesCount + 1) * 2 > m_slots.size()) {
+		grow();
+	}
+
+	Slot& slot = m_slots[findSlot(address.ip)];
+	if (slot.firstEntry == NO_ENTRY) {
+		slot.address = address.ip;
+		m_addressesCount++;
+	}
+
+	m_entries.push_back({ruleIndex, slot.firstEntry});
+	slot.firstEntry = static_cast<uint32_t>(m_entries.size() - 1);
+}
+
+void HostAddressIndex::markMatchingRules(
+	const Nemea::IpAddress& address,
+	const std::vector<bool>& previouslyMatchedRulesMask,
+	std::vector<bool>& matchingRulesMask) const
+{
+	if (m_addressesCount == 0) {
+		return;
+	}
+
+	for (auto entryIndex = m_slots[findSlot(address.ip)].firstEntry; entryIndex != NO_ENTRY;
+		 entryIndex = m_entries[entryIndex].nextEntry) {
+		const uint16_t ruleIndex = m_entries[entryIndex].ruleIndex;
+		if (previouslyMatchedRulesMask[ruleIndex]) {
+			matchingRulesMask[ruleIndex] = true;
+		}
+	}
+}
+
+} // namespace ListDetector
@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @brief Declaration of the HostAddressIndex class for matching IP addresses against host
+ * prefixes
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unirec++/ipAddress.hpp>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Flat open addressing hash index of host addresses (/32 and /128 prefixes).
+ *
+ * Each slot keeps one address and the first entry of the list of rules with that address, so an
+ * address is matched by a single probe in most cases instead of a walk through the prefix tree.
+ */
+class HostAddressIndex {
+public:
+	/**
+	 * @brief Adds the host address of the rule to the index.
+	 * @param address Host address.
+	 * @param ruleIndex Index of the rule.
+	 */
+	void insert(const Nemea::IpAddress& address, uint16_t ruleIndex);
+
+	/**
+	 * @brief Marks rules with the given address in the matching rules mask.
+	 * @param address The IP address to find.
+	 * @param previouslyMatchedRulesMask Bitset of previously matched rules.
+	 * @param matchingRulesMask Bitset where matching rules are set to true.
+	 */
+	void markMatchingRules(
+		const Nemea::IpAddress& address,
+		const std::vector<bool>& previouslyMatchedRulesMask,
+		std::vector<bool>& matchingRulesMask) const;
+
+private:
+	static inline const uint32_t NO_ENTRY = std::numeric_limits<uint32_t>::max();
+	static inline const size_t INITIAL_CAPACITY = 16;
+
+	struct Slot {
+		ip_addr_t address;
+		uint32_t firstEntry = NO_ENTRY;
+	};
+
+	struct Entry {
+		uint16_t ruleIndex;
+		uint32_t nextEntry;
+	};
+
+	size_t findSlot(const ip_addr_t& address) const noexcept;
+	void grow();
+
+	std::vector<Slot> m_slots;
+	std::vector<Entry> m_entries;
+	size_t m_addressesCount = 0;
+};
+
+} // namespace ListDetector
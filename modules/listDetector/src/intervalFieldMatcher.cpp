@@ -0,0 +1,140 @@
+/**
+ * @file
+ * @brief Implementation of the IntervalFieldMatcher class for keeping and matching ranges and sets
+ * of integer values against integer fields
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "intervalFieldMatcher.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace ListDetector {
+
+static const uint64_t g_MAX_KEY = std::numeric_limits<uint64_t>::max();
+
+/**
+ * @brief Calls the callback for the nodes of the segment tree that cover given leaves.
+ * @param first Index of the first covered leaf.
+ * @param last Index after the last covered leaf.
+ * @param leavesCount Number of leaves of the tree.
+ * @param callback Callback called with the index of each covering node.
+ */
+template <typename Callback>
+static void
+forEachCoveringNode(size_t first, size_t last, size_t leavesCount, const Callback& callback)
+{
+	for (first += leavesCount, last += leavesCount; first < last; first /= 2, last /= 2) {
+		if (first % 2 == 1) {
+			callback(first++);
+		}
+		if (last % 2 == 1) {
+			callback(--last);
+		}
+	}
+}
+
+void IntervalFieldMatcher::addIntervals(uint32_t ruleIndex, const NumericIntervals& intervals)
+{
+	for (const auto& interval : intervals) {
+		if (interval.low > interval.high) {
+			throw std::invalid_argument("Interval lower bound is greater than its upper bound");
+		}
+		m_ruleIntervals.push_back({interval, ruleIndex});
+	}
+}
+
+void IntervalFieldMatcher::build(size_t rulesCount)
+{
+	m_unrestrictedRulesMask.assign(rulesCount, true);
+
+	m_segmentStarts = {0};
+	for (const auto& [interval, ruleIndex] : m_ruleIntervals) {
+		m_unrestrictedRulesMask.at(ruleIndex) = false;
+		m_segmentStarts.push_back(interval.low);
+		if (interval.high != g_MAX_KEY) {
+			m_segmentStarts.push_back(interval.high + 1);
+		}
+	}
+	std::sort(m_segmentStarts.begin(), m_segmentStarts.end());
+	m_segmentStarts.erase(
+		std::unique(m_segmentStarts.begin(), m_segmentStarts.end()),
+		m_segmentStarts.end());
+
+	auto getSegmentsRange = [this](const NumericInterval& interval) {
+		const auto first = std::lower_bound(
+			m_segmentStarts.begin(),
+			m_segmentStarts.end(),
+			interval.low);
+		const auto last = interval.high == g_MAX_KEY
+			? m_segmentStarts.end()
+			: std::lower_bound(first, m_segmentStarts.end(), interval.high + 1);
+		return std::make_pair(
+			static_cast<size_t>(std::distance(m_segmentStarts.begin(), first)),
+			static_cast<size_t>(std::distance(m_segmentStarts.begin(), last)));
+	};
+
+	// Nodes of the tree are numbered from 1 at the root, children of node n are 2n and 2n + 1
+	// and the leaves start at `m_leavesCount`, which is a power of two
+	m_leavesCount = 1;
+	while (m_leavesCount < m_segmentStarts.size()) {
+		m_leavesCount *= 2;
+	}
+
+	// Offsets of the rules of each node, the last item is the end of the last node
+	m_nodeRulesOffsets.assign(2 * m_leavesCount + 1, 0);
+	for (const auto& ruleInterval : m_ruleIntervals) {
+		const auto [first, last] = getSegmentsRange(ruleInterval.interval);
+		forEachCoveringNode(first, last, m_leavesCount, [this](size_t node) {
+			m_nodeRulesOffsets[node + 1]++;
+		});
+	}
+	for (size_t node = 1; node < m_nodeRulesOffsets.size(); node++) {
+		m_nodeRulesOffsets[node] += m_nodeRulesOffsets[node - 1];
+	}
+
+	m_nodeRules.resize(m_nodeRulesOffsets.back());
+	std::vector<uint32_t> writePositions(
+		m_nodeRulesOffsets.begin(),
+		std::prev(m_nodeRulesOffsets.end()));
+	for (const auto& [interval, ruleIndex] : m_ruleIntervals) {
+		const auto [first, last] = getSegmentsRange(interval);
+		forEachCoveringNode(first, last, m_leavesCount, [&, ruleIndex = ruleIndex](size_t node) {
+			m_nodeRules[writePositions[node]++] = ruleIndex;
+		});
+	}
+
+	m_ruleIntervals.clear();
+	m_ruleIntervals.shrink_to_fit();
+}
+
+std::vector<bool> IntervalFieldMatcher::getMatchingRulesMask(
+	uint64_t key,
+	const std::vector<bool>& previouslyMatchedRulesMask) const
+{
+	std::vector<bool> matchingRulesMask(previouslyMatchedRulesMask.size());
+	for (size_t ruleIndex = 0; ruleIndex < matchingRulesMask.size(); ruleIndex++) {
+		matchingRulesMask[ruleIndex]
+			= previouslyMatchedRulesMask[ruleIndex] && m_unrestrictedRulesMask[ruleIndex];
+	}
+
+	const auto segmentIt = std::prev(
+		std::upper_bound(m_segmentStarts.begin(), m_segmentStarts.end(), key));
+	const auto segment = static_cast<size_t>(std::distance(m_segmentStarts.begin(), segmentIt));
+
+	for (auto node = segment + m_leavesCount; node != 0; node /= 2) {
+		for (auto ruleOffset = m_nodeRulesOffsets[node]; ruleOffset < m_nodeRulesOffsets[node + 1];
+			 ruleOffset++) {
+			const auto ruleIndex = m_nodeRules[ruleOffset];
+			matchingRulesMask[ruleIndex] = previouslyMatchedRulesMask[ruleIndex];
+		}
+	}
+
+	return matchingRulesMask;
+}
+
+} // namespace ListDetector
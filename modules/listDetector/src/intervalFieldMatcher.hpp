@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @brief Declaration of the IntervalFieldMatcher class for keeping and matching ranges and sets
+ * of integer values against integer fields
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "numericInterval.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Keeps intervals of integer values of one field and match values against them.
+ *
+ * Boundaries of all intervals split the value space into elementary segments, which are leaves
+ * of a segment tree. Each interval is kept in at most two nodes per level of the tree whose
+ * segments it covers, so the index takes O(n log n) memory for n intervals. A value is matched by
+ * a binary search of its segment and by collecting the rules on the path from its leaf to the
+ * root.
+ */
+class IntervalFieldMatcher {
+public:
+	/**
+	 * @brief Adds intervals of the given rule to the matcher.
+	 *
+	 * Rules without added intervals are not restricted by this matcher.
+	 *
+	 * @param ruleIndex Index of the rule.
+	 * @param intervals Intervals of the rule field.
+	 */
+	void addIntervals(uint32_t ruleIndex, const NumericIntervals& intervals);
+
+	/**
+	 * @brief Builds the segments index. Must be called after all intervals were added.
+	 * @param rulesCount Total count of rules.
+	 */
+	void build(size_t rulesCount);
+
+	/**
+	 * @brief Finds rules matching given value ignoring rules that can not match.
+	 * @param key Key of the value (see `toIntervalKey()`).
+	 * @param previouslyMatchedRulesMask Bitset of previously matched rules.
+	 * @return Bitset where matching rules indexes are set to true.
+	 */
+	std::vector<bool> getMatchingRulesMask(
+		uint64_t key,
+		const std::vector<bool>& previouslyMatchedRulesMask) const;
+
+private:
+	struct RuleInterval {
+		NumericInterval interval;
+		uint32_t ruleIndex;
+	};
+
+	std::vector<RuleInterval> m_ruleIntervals;
+
+	std::vector<bool> m_unrestrictedRulesMask;
+	std::vector<uint64_t> m_segmentStarts;
+	size_t m_leavesCount = 0;
+	std::vector<uint32_t> m_nodeRulesOffsets;
+	std::vector<uint32_t> m_nodeRules;
+};
+
+} // namespace ListDetector
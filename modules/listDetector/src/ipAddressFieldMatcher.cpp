@@ -8,6 +8,7 @@
  */
 
 #include "ipAddressFieldMatcher.hpp"
+#include <cstring>
 #include <limits>
 
 namespace ListDetector {
@@ -18,18 +19,49 @@ static bool isNetworkMaskOctet(std::byte byte) noexcept
 	return byte == std::byte(networkMaskOctet);
 }
 
-void IpAddressFieldMatcher::addPrefix(const IpAddressPrefix& prefix) noexcept
+static_assert(sizeof(ip_addr_t) == 2 * sizeof(uint64_t), "ip_addr_t must have 128 bits");
+
+static std::array<uint64_t, 2> splitAddress(const Nemea::IpAddress& address) noexcept
+{
+	std::array<uint64_t, 2> words;
+	std::memcpy(words.data(), &address.ip, sizeof(address.ip));
+	return words;
+}
+
+static bool isHostPrefix(const Nm::IpAddressPrefix& prefix) noexcept
 {
+	return prefix.getLength()
+		== (prefix.getAddress().isIpv4() ? Nm::IpAddressPrefix::IPV4_MAX_PREFIX
+										 : Nm::IpAddressPrefix::IPV6_MAX_PREFIX);
+}
+
+void IpAddressFieldMatcher::addPrefix(const Nm::IpAddressPrefix& prefix) noexcept
+{
+	if (m_lastInsertIndex < LINEAR_SCAN_MAX_PREFIXES) {
+		addLinearScanPrefix(prefix);
+	} else if (m_useLinearScan) {
+		m_useLinearScan = false;
+		m_linearScanPrefixes = {};
+	}
+
+	if (isHostPrefix(prefix)) {
+		m_hostAddressIndex.insert(prefix.getAddress(), m_lastInsertIndex++);
+		return;
+	}
+
+	OctetTree& octets = prefix.getAddress().isIpv4() ? m_ipv4Octets : m_ipv6Octets;
 	auto [ip, mask] = prefix.getIpAndMask();
 	uint16_t previousOctetPos = std::numeric_limits<uint16_t>::max();
 
 	for (auto octetIndex = 0U; octetIndex < ip.size(); octetIndex++) {
 		if (isNetworkMaskOctet(mask[octetIndex]) && octetIndex != ip.size() - 1) {
 			previousOctetPos = insertNode(
+				octets,
 				OctetNode {ip[octetIndex], mask[octetIndex], false, {OctetNode::NO_INDEX}},
 				NodePos {(uint8_t) octetIndex, previousOctetPos});
 		} else {
 			insertNode(
+				octets,
 				OctetNode {ip[octetIndex], mask[octetIndex], true, {m_lastInsertIndex++}},
 				NodePos {(uint8_t) octetIndex, previousOctetPos});
 			return;
@@ -37,26 +69,47 @@ void IpAddressFieldMatcher::addPrefix(const IpAddressPrefix& prefix) noexcept
 	}
 }
 
-uint16_t IpAddressFieldMatcher::insertNode(const OctetNode& node, NodePos pos) noexcept
+void IpAddressFieldMatcher::addLinearScanPrefix(const Nm::IpAddressPrefix& prefix)
+{
+	const auto network = splitAddress(prefix.getAddress());
+	auto mask = splitAddress(prefix.getMask());
+	if (prefix.getAddress().isIpv4()) {
+		// IPv4 addresses have the upper half zero, so IPv6 addresses never match IPv4 prefixes
+		mask[0] = std::numeric_limits<uint64_t>::max();
+	}
+	m_linearScanPrefixes.networksHigh.emplace_back(network[0]);
+	m_linearScanPrefixes.networksLow.emplace_back(network[1]);
+	m_linearScanPrefixes.masksHigh.emplace_back(mask[0]);
+	m_linearScanPrefixes.masksLow.emplace_back(mask[1]);
+}
+
+uint16_t
+IpAddressFieldMatcher::insertNode(OctetTree& octets, const OctetNode& node, NodePos pos) noexcept
 {
 	const auto& [octetIndex, previousOctetPos] = pos;
 
 	const uint16_t startIndex
-		= octetIndex == 0 ? 0 : m_octets[octetIndex - 1UL][previousOctetPos].index.nextNode;
-	const uint16_t endIndex = getNotLastNodeNextNode(NodePos {octetIndex, previousOctetPos});
+		= octetIndex == 0 ? 0 : octets[octetIndex - 1UL][previousOctetPos].index.nextNode;
+	const uint16_t endIndex
+		= getNotLastNodeNextNode(octets, NodePos {octetIndex, previousOctetPos});
 
 	for (auto index = startIndex; index < endIndex; index++) {
-		if (m_octets[octetIndex][index] == node) {
+		if (octets[octetIndex][index] == node) {
 			return index;
 		}
 	}
 
-	m_octets[octetIndex].insert(m_octets[octetIndex].begin() + startIndex, node);
+	octets[octetIndex].insert(octets[octetIndex].begin() + startIndex, node);
+	if (!node.isLast) {
+		// Children of the new node go before children of the following nodes of the level
+		octets[octetIndex][startIndex].index.nextNode
+			= getNotLastNodeNextNode(octets, NodePos {(uint8_t) (octetIndex + 1), startIndex});
+	}
 
-	for (auto i = previousOctetPos + 1U; octetIndex != 0 && i < m_octets[octetIndex - 1UL].size();
+	for (auto i = previousOctetPos + 1U; octetIndex != 0 && i < octets[octetIndex - 1UL].size();
 		 i++) {
-		if (!m_octets[octetIndex - 1UL][i].isLast) {
-			m_octets[octetIndex - 1UL][i].index.nextNode++;
+		if (!octets[octetIndex - 1UL][i].isLast) {
+			octets[octetIndex - 1UL][i].index.nextNode++;
 		}
 	}
 
@@ -68,74 +121,131 @@ std::vector<bool> IpAddressFieldMatcher::getMatchingIpRulesMask(
 	const std::vector<bool>& previouslyMatchedRulesMask) const
 {
 	std::vector<bool> matchingRulesMask(m_lastInsertIndex);
-	checkOctet(address, 0, {0, m_octets[0].size()}, matchingRulesMask, previouslyMatchedRulesMask);
+	if (m_useLinearScan) {
+		markLinearScanMatches(address, previouslyMatchedRulesMask, matchingRulesMask);
+		return matchingRulesMask;
+	}
+
+	if (address.isIpv4()) {
+		checkOctet(
+			m_ipv4Octets,
+			reinterpret_cast<const uint8_t*>(ip_get_v4_as_bytes(&address.ip)),
+			0,
+			{0, m_ipv4Octets[0].size()},
+			matchingRulesMask,
+			previouslyMatchedRulesMask);
+	}
+	checkOctet(
+		m_ipv6Octets,
+		address.ip.bytes,
+		0,
+		{0, m_ipv6Octets[0].size()},
+		matchingRulesMask,
+		previouslyMatchedRulesMask);
+	m_hostAddressIndex.markMatchingRules(address, previouslyMatchedRulesMask, matchingRulesMask);
 	return matchingRulesMask;
 }
 
-uint16_t IpAddressFieldMatcher::getNotLastNodeNextNode(NodePos pos) const noexcept
+void IpAddressFieldMatcher::markLinearScanMatches(
+	const Nemea::IpAddress& address,
+	const std::vector<bool>& previouslyMatchedRulesMask,
+	std::vector<bool>& matchingRulesMask) const noexcept
+{
+	const auto [addressHigh, addressLow] = splitAddress(address);
+	const uint64_t* networksHigh = m_linearScanPrefixes.networksHigh.data();
+	const uint64_t* networksLow = m_linearScanPrefixes.networksLow.data();
+	const uint64_t* masksHigh = m_linearScanPrefixes.masksHigh.data();
+	const uint64_t* masksLow = m_linearScanPrefixes.masksLow.data();
+	const size_t prefixesCount = m_linearScanPrefixes.networksHigh.size();
+
+	// Only bitwise operations and 64-bit subtraction are used, so the loop is vectorized even by
+	// SSE2, which cannot compare 64-bit integers. Zero difference of the masked address and the
+	// network is a match. The highest bit of `x | -x` is set just for non-zero `x`, so it stays
+	// set in the conjunction if no prefix matches, which is the common case.
+	std::array<uint64_t, LINEAR_SCAN_MAX_PREFIXES> differences;
+	uint64_t nonZeroDifferences = std::numeric_limits<uint64_t>::max();
+	for (size_t prefixIndex = 0; prefixIndex < prefixesCount; prefixIndex++) {
+		const uint64_t difference
+			= ((addressHigh & masksHigh[prefixIndex]) ^ networksHigh[prefixIndex])
+			| ((addressLow & masksLow[prefixIndex]) ^ networksLow[prefixIndex]);
+		differences[prefixIndex] = difference;
+		nonZeroDifferences &= difference | (0 - difference);
+	}
+	if ((nonZeroDifferences >> 63U) != 0) {
+		return;
+	}
+
+	// Prefixes are kept in insertion order, so the prefix index is the rule index
+	for (size_t prefixIndex = 0; prefixIndex < prefixesCount; prefixIndex++) {
+		if (differences[prefixIndex] == 0 && previouslyMatchedRulesMask[prefixIndex]) {
+			matchingRulesMask[prefixIndex] = true;
+		}
+	}
+}
+
+uint16_t
+IpAddressFieldMatcher::getNotLastNodeNextNode(const OctetTree& octets, NodePos pos) noexcept
 {
 	const auto& [octetIndex, startIndex] = pos;
 
 	if (octetIndex == 0) {
-		return (uint16_t) m_octets[octetIndex].size();
+		return (uint16_t) octets[octetIndex].size();
 	}
 	auto index = startIndex + 1U;
-	for (; index < m_octets[octetIndex - 1UL].size() && m_octets[octetIndex - 1UL][index].isLast;
+	for (; index < octets[octetIndex - 1UL].size() && octets[octetIndex - 1UL][index].isLast;
 		 index++) {}
-	if (index == m_octets[octetIndex - 1UL].size()) {
-		return (uint16_t) m_octets[octetIndex].size();
+	if (index == octets[octetIndex - 1UL].size()) {
+		return (uint16_t) octets[octetIndex].size();
 	}
-	return m_octets[octetIndex - 1UL][index].index.nextNode;
+	return octets[octetIndex - 1UL][index].index.nextNode;
 }
 
 void IpAddressFieldMatcher::checkOctet(
-	const Nemea::IpAddress& address,
+	const OctetTree& octets,
+	const uint8_t* addressOctets,
 	uint8_t octetIndex,
 	const std::pair<uint16_t, uint16_t>& searchRange,
 	std::vector<bool>& matchingBitset,
-	const std::vector<bool>& previouslyMatchedBitset) const noexcept
+	const std::vector<bool>& previouslyMatchedBitset) noexcept
 {
 	auto [startIndex, endIndex] = searchRange;
 
 	for (auto i = startIndex; i < endIndex; i++) {
-		const bool currentOctetIsLast = m_octets[octetIndex][i].isLast;
-		const bool octetMatches = ipMatchesNetworkOctet(address, NodePos {octetIndex, i});
+		const bool currentOctetIsLast = octets[octetIndex][i].isLast;
+		const bool octetMatches
+			= ipMatchesNetworkOctet(octets, addressOctets, NodePos {octetIndex, i});
 
 		if (octetMatches && currentOctetIsLast
-			&& previouslyMatchedBitset[m_octets[octetIndex][i].index.rule]) {
-			matchingBitset[m_octets[octetIndex][i].index.rule] = true;
+			&& previouslyMatchedBitset[octets[octetIndex][i].index.rule]) {
+			matchingBitset[octets[octetIndex][i].index.rule] = true;
 		} else if (octetMatches) {
 			auto nextOctetSearchEndIndex
-				= getNotLastNodeNextNode(NodePos {(uint8_t) (octetIndex + 1), i});
+				= getNotLastNodeNextNode(octets, NodePos {(uint8_t) (octetIndex + 1), i});
 			checkOctet(
-				address,
+				octets,
+				addressOctets,
 				static_cast<uint8_t>(octetIndex + 1UL),
-				{m_octets[octetIndex][i].index.nextNode, nextOctetSearchEndIndex},
+				{octets[octetIndex][i].index.nextNode, nextOctetSearchEndIndex},
 				matchingBitset,
 				previouslyMatchedBitset);
 		}
 	}
 }
 
-bool IpAddressFieldMatcher::ipMatchesNetworkOctet(const Nemea::IpAddress& address, NodePos pos)
-	const noexcept
+bool IpAddressFieldMatcher::ipMatchesNetworkOctet(
+	const OctetTree& octets,
+	const uint8_t* addressOctets,
+	NodePos pos) noexcept
 {
 	const auto& [octetIndex, nodeIndex] = pos;
 
-	if (address.isIpv4()) {
-		return m_octets[octetIndex][nodeIndex].value
-			== (std::byte)(
-				   ip_get_v4_as_bytes(&address.ip)[octetIndex]
-				   & (uint8_t) m_octets[octetIndex][nodeIndex].mask);
-	}
-	return m_octets[octetIndex][nodeIndex].value
-		== (std::byte)(
-			   address.ip.bytes[octetIndex] & (uint8_t) m_octets[octetIndex][nodeIndex].mask);
+	return octets[octetIndex][nodeIndex].value
+		== (std::byte)(addressOctets[octetIndex] & (uint8_t) octets[octetIndex][nodeIndex].mask);
 }
 
 void IpAddressFieldMatcher::addEmptyPrefix() noexcept
 {
-	addPrefix(IpAddressPrefix(Nemea::IpAddress {}, 0));
+	addPrefix(Nm::IpAddressPrefix(Nemea::IpAddress {}, 0));
 }
 
 } // namespace ListDetector
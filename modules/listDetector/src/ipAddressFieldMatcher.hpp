@@ -9,7 +9,8 @@
 
 #pragma once
 
-#include "ipAddressPrefix.hpp"
+#include "hostAddressIndex.hpp"
+#include "ip/ipAddressPrefix.hpp"
 #include "octetNode.hpp"
 
 #include <array>
@@ -21,14 +22,32 @@ namespace ListDetector {
 
 /**
  * @brief Keeps IP address prefixes and match IP addresses against them.
+ *
+ * Host prefixes (/32 and /128) are kept in the hash index, other prefixes in the octet tree of
+ * their address family. While there are at most `LINEAR_SCAN_MAX_PREFIXES` prefixes, all of them
+ * are also kept as arrays of network addresses and masks, and addresses are matched by a linear
+ * scan of the arrays instead, which is faster than walking the trees for small sets.
+ *
+ * Both ways give the same results. IPv4 prefixes match only IPv4 addresses. IPv6 prefixes are
+ * compared with all 128 bits of the address, so e.g. the empty prefix matches IPv4 addresses too.
  */
 class IpAddressFieldMatcher {
 public:
+	/**
+	 * @brief Maximal number of prefixes matched by the linear scan.
+	 *
+	 * Measured crossover of the linear scan and the octet trees with -O3 on x86-64. The scan was
+	 * faster up to about 200 IPv4 prefixes, but only up to about 50 prefixes of both families,
+	 * because the IPv6 tree splits them early. It can be checked by `listDetectorBenchmark` with
+	 * a single IP field rule set (`--wildcard-masks 1`) of growing size.
+	 */
+	inline static const size_t LINEAR_SCAN_MAX_PREFIXES = 64;
+
 	/**
 	 * @brief Adds given IP prefix to the address matcher.
 	 * @param prefix The IP prefix to add.
 	 */
-	void addPrefix(const IpAddressPrefix& prefix) noexcept;
+	void addPrefix(const Nm::IpAddressPrefix& prefix) noexcept;
 
 	/**
 	 * @brief Adds empty prefix to the address matcher to match all adresses.
@@ -53,18 +72,48 @@ private:
 		uint16_t nodeIndex; ///< Index of the node on the level octetIndex in the tree.
 	};
 
-	uint16_t getNotLastNodeNextNode(NodePos pos) const noexcept;
-	uint16_t insertNode(const OctetNode& node, NodePos pos) noexcept;
-	void checkOctet(
+	/**
+	 * @brief Prefixes as struct of arrays of 64-bit halves of network addresses and masks.
+	 */
+	struct LinearScanPrefixes {
+		std::vector<uint64_t> networksHigh;
+		std::vector<uint64_t> networksLow;
+		std::vector<uint64_t> masksHigh;
+		std::vector<uint64_t> masksLow;
+	};
+
+	void addLinearScanPrefix(const Nm::IpAddressPrefix& prefix);
+	void markLinearScanMatches(
 		const Nemea::IpAddress& address,
+		const std::vector<bool>& previouslyMatchedRulesMask,
+		std::vector<bool>& matchingRulesMask) const noexcept;
+
+	inline static const int OCTET_MAX_COUNT = 16;
+
+	/**
+	 * @brief Octet tree as nodes of each level of the tree.
+	 */
+	using OctetTree = std::array<std::vector<OctetNode>, OCTET_MAX_COUNT>;
+
+	static uint16_t getNotLastNodeNextNode(const OctetTree& octets, NodePos pos) noexcept;
+	static uint16_t insertNode(OctetTree& octets, const OctetNode& node, NodePos pos) noexcept;
+	static void checkOctet(
+		const OctetTree& octets,
+		const uint8_t* addressOctets,
 		uint8_t octetIndex,
 		const std::pair<uint16_t, uint16_t>& searchRange,
 		std::vector<bool>& matchingBitset,
-		const std::vector<bool>& previouslyMatchedBitset) const noexcept;
-	bool ipMatchesNetworkOctet(const Nemea::IpAddress& address, NodePos pos) const noexcept;
+		const std::vector<bool>& previouslyMatchedBitset) noexcept;
+	static bool ipMatchesNetworkOctet(
+		const OctetTree& octets,
+		const uint8_t* addressOctets,
+		NodePos pos) noexcept;
 
-	inline static const int OCTET_MAX_COUNT = 16;
-	std::array<std::vector<OctetNode>, OCTET_MAX_COUNT> m_octets;
+	OctetTree m_ipv4Octets;
+	OctetTree m_ipv6Octets;
+	HostAddressIndex m_hostAddressIndex;
+	LinearScanPrefixes m_linearScanPrefixes;
+	bool m_useLinearScan = true;
 
 	uint16_t m_lastInsertIndex = 0;
 };
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Implementation of the IpTupleSpaceClassifier class for matching rules with several IP
+ * fields
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "ipTupleSpaceClassifier.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <variant>
+#include <xxhash.h>
+
+namespace ListDetector {
+
+static bool isSameMask(const Nemea::IpAddress& left, const Nemea::IpAddress& right) noexcept
+{
+	return std::memcmp(&left.ip, &right.ip, sizeof(left.ip)) == 0;
+}
+
+static Nemea::IpAddress createZeroAddress() noexcept
+{
+	Nemea::IpAddress address;
+	std::memset(&address.ip, 0, sizeof(address.ip));
+	return address;
+}
+
+IpTupleSpaceClassifier::IpTupleSpaceClassifier(
+	const std::vector<ur_field_id_t>& fieldIds,
+	const std::vector<Rule>& rules)
+	: m_fieldIds(fieldIds)
+{
+	for (uint32_t ruleIndex = 0; ruleIndex < rules.size(); ruleIndex++) {
+		// Wildcard fields have empty mask and network, so they match any address
+		std::vector<Nemea::IpAddress> masks(m_fieldIds.size(), createZeroAddress());
+		std::vector<Nemea::IpAddress> networks(m_fieldIds.size(), createZeroAddress());
+
+		for (size_t fieldIndex = 0; fieldIndex < m_fieldIds.size(); fieldIndex++) {
+			const auto& ruleFields = rules[ruleIndex].getRuleFields();
+			const auto ruleFieldIt = std::find_if(
+				ruleFields.begin(),
+				ruleFields.end(),
+				[fieldId = m_fieldIds[fieldIndex]](const RuleField& ruleField) {
+					return ruleField.first == fieldId;
+				});
+
+			if (ruleFieldIt == ruleFields.end() || Rule::isWildcardRuleField(*ruleFieldIt)) {
+				m_rulesPrefixes.emplace_back(std::nullopt);
+				continue;
+			}
+			const auto& prefix = std::get<Nm::IpAddressPrefix>(*ruleFieldIt->second);
+			masks[fieldIndex] = prefix.getMask();
+			networks[fieldIndex] = prefix.getAddress();
+			m_rulesPrefixes.emplace_back(prefix);
+		}
+
+		auto tupleIt = std::find_if(m_tuples.begin(), m_tuples.end(), [&masks](const Tuple& tuple) {
+			return std::equal(
+				tuple.masks.begin(),
+				tuple.masks.end(),
+				masks.begin(),
+				isSameMask);
+		});
+		if (tupleIt == m_tuples.end()) {
+			m_tuples.push_back({masks, {}});
+			tupleIt = std::prev(m_tuples.end());
+		}
+		tupleIt->rulesIndexes.emplace(calculateKey(networks), ruleIndex);
+	}
+}
+
+uint64_t IpTupleSpaceClassifier::calculateKey(const std::vector<Nemea::IpAddress>& networks)
+{
+	XXH64_hash_t hash = 0;
+	for (const auto& network : networks) {
+		hash = XXH3_64bits_withSeed(&network.ip, sizeof(network.ip), hash);
+	}
+	return hash;
+}
+
+bool IpTupleSpaceClassifier::ruleMatches(
+	uint32_t ruleIndex,
+	const std::vector<Nemea::IpAddress>& addresses) const
+{
+	for (size_t fieldIndex = 0; fieldIndex < m_fieldIds.size(); fieldIndex++) {
+		const auto& prefix = m_rulesPrefixes[ruleIndex * m_fieldIds.size() + fieldIndex];
+		if (prefix.has_value() && !prefix->isBelong(addresses[fieldIndex])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<bool> IpTupleSpaceClassifier::getMatchingRulesMask(
+	const Nemea::UnirecRecordView& unirecRecordView,
+	const std::vector<bool>& previouslyMatchedRulesMask) const
+{
+	std::vector<Nemea::IpAddress> addresses;
+	addresses.reserve(m_fieldIds.size());
+	for (const auto fieldId : m_fieldIds) {
+		addresses.emplace_back(unirecRecordView.getFieldAsType<Nemea::IpAddress>(fieldId));
+	}
+
+	std::vector<bool> matchingRulesMask(previouslyMatchedRulesMask.size());
+	std::vector<Nemea::IpAddress> networks(m_fieldIds.size());
+	for (const auto& tuple : m_tuples) {
+		for (size_t fieldIndex = 0; fieldIndex < m_fieldIds.size(); fieldIndex++) {
+			networks[fieldIndex] = addresses[fieldIndex] & tuple.masks[fieldIndex];
+		}
+
+		// Hash of the networks may collide, so candidates are verified by their prefixes
+		for (auto [it, rangeEnd] = tuple.rulesIndexes.equal_range(calculateKey(networks));
+			 it != rangeEnd;
+			 it++) {
+			if (previouslyMatchedRulesMask[it->second] && ruleMatches(it->second, addresses)) {
+				matchingRulesMask[it->second] = true;
+			}
+		}
+	}
+	return matchingRulesMask;
+}
+
+const std::vector<ur_field_id_t>& IpTupleSpaceClassifier::getFieldIds() const noexcept
+{
+	return m_fieldIds;
+}
+
+} // namespace ListDetector
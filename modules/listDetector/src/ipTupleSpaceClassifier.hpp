@@ -0,0 +1,72 @@
+/**
+ * @file
+ * @brief Declaration of the IpTupleSpaceClassifier class for matching rules with several IP
+ * fields
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "ip/ipAddressPrefix.hpp"
+#include "rule.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unirec++/ipAddress.hpp>
+#include <unirec++/unirec.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Matches all IP fields of a record at once by tuple space search.
+ *
+ * Rules are grouped into tuples by the masks of their prefixes over all IP fields, a wildcard
+ * field having an empty mask. Each tuple keeps a hash index of the network addresses of its
+ * rules, so a record is matched by one probe per tuple regardless of the number of rules. Number
+ * of tuples is bounded by the combinations of prefix lengths used by the rules.
+ */
+class IpTupleSpaceClassifier {
+public:
+	/**
+	 * @brief Builds the classifier.
+	 * @param fieldIds Ids of the IP fields to classify by.
+	 * @param rules Rules to classify.
+	 */
+	IpTupleSpaceClassifier(
+		const std::vector<ur_field_id_t>& fieldIds,
+		const std::vector<Rule>& rules);
+
+	/**
+	 * @brief Finds rules whose IP prefixes of all fields match the record.
+	 * @param unirecRecordView The Unirec record view to match.
+	 * @param previouslyMatchedRulesMask Bitset of previously matched rules.
+	 * @return Bitset where matching rules indexes are set to true.
+	 */
+	std::vector<bool> getMatchingRulesMask(
+		const Nemea::UnirecRecordView& unirecRecordView,
+		const std::vector<bool>& previouslyMatchedRulesMask) const;
+
+	/**
+	 * @brief Returns ids of the classified IP fields.
+	 * @return Ids of the IP fields.
+	 */
+	const std::vector<ur_field_id_t>& getFieldIds() const noexcept;
+
+private:
+	struct Tuple {
+		std::vector<Nemea::IpAddress> masks;
+		std::unordered_multimap<uint64_t, uint32_t> rulesIndexes;
+	};
+
+	static uint64_t calculateKey(const std::vector<Nemea::IpAddress>& networks);
+	bool ruleMatches(uint32_t ruleIndex, const std::vector<Nemea::IpAddress>& addresses) const;
+
+	std::vector<ur_field_id_t> m_fieldIds;
+	std::vector<Tuple> m_tuples;
+	std::vector<std::optional<Nm::IpAddressPrefix>> m_rulesPrefixes;
+};
+
+} // namespace ListDetector
@@ -8,8 +8,10 @@
  */
 
 #include "listDetector.hpp"
+#include "instrumentation/timer.hpp"
 
 #include <algorithm>
+#include <functional>
 #include <optional>
 #include <regex>
 #include <stdexcept>
@@ -20,11 +22,250 @@
 
 namespace ListDetector {
 
-static telemetry::Content createRuleTelemetryContent(const Rule& rule)
+/**
+ * @brief Number of the most expensive rules listed in the rules profile.
+ */
+static const size_t g_PROFILED_TOP_RULES_COUNT = 10;
+
+static RuleProfile
+sumRuleProfiles(size_t ruleIndex, const std::vector<MatchingContext>& matchingContexts)
+{
+	RuleProfile profile;
+	for (const auto& context : matchingContexts) {
+		const RuleProfile& contextProfile = context.rulesProfiler->getRulesProfiles()[ruleIndex];
+		profile.evaluatedCount.add(contextProfile.evaluatedCount.load());
+		profile.sampledCount.add(contextProfile.sampledCount.load());
+		profile.sampledTime.add(contextProfile.sampledTime.load());
+	}
+	return profile;
+}
+
+static double getMeanTime(uint64_t time, uint64_t count)
+{
+	return count == 0 ? 0.0 : static_cast<double>(time) / static_cast<double>(count);
+}
+
+static uint64_t estimateTotalTime(const RuleProfile& profile)
+{
+	return static_cast<uint64_t>(
+		getMeanTime(profile.sampledTime.load(), profile.sampledCount.load())
+		* static_cast<double>(profile.evaluatedCount.load()));
+}
+
+static telemetry::Content createRuleTelemetryContent(
+	size_t ruleIndex,
+	const std::vector<MatchingContext>& matchingContexts)
+{
+	uint64_t matchedCount = 0;
+	for (const auto& context : matchingContexts) {
+		matchedCount += context.rulesStats[ruleIndex].matchedCount.load();
+	}
+
+	telemetry::Dict dict;
+	dict["matchedCount"] = telemetry::Scalar(matchedCount);
+	if (matchingContexts.front().rulesProfiler) {
+		const RuleProfile profile = sumRuleProfiles(ruleIndex, matchingContexts);
+		dict["evaluatedCount"] = telemetry::Scalar(profile.evaluatedCount.load());
+		dict["meanEvaluationTime"] = telemetry::ScalarWithUnit(
+			getMeanTime(profile.sampledTime.load(), profile.sampledCount.load()),
+			"ns");
+		dict["estimatedTimeNs"] = telemetry::Scalar(estimateTotalTime(profile));
+	}
+	return dict;
+}
+
+static telemetry::Content
+createRulesProfileTelemetryContent(const std::vector<MatchingContext>& matchingContexts)
+{
+	const size_t rulesCount = matchingContexts.front().rulesProfiler->getRulesProfiles().size();
+	std::vector<std::pair<uint64_t, size_t>> rulesTimes;
+	for (size_t ruleIndex = 0; ruleIndex < rulesCount; ruleIndex++) {
+		rulesTimes.emplace_back(
+			estimateTotalTime(sumRuleProfiles(ruleIndex, matchingContexts)),
+			ruleIndex);
+	}
+	const size_t topRulesCount = std::min(g_PROFILED_TOP_RULES_COUNT, rulesTimes.size());
+	std::partial_sort(
+		rulesTimes.begin(),
+		rulesTimes.begin() + static_cast<std::ptrdiff_t>(topRulesCount),
+		rulesTimes.end(),
+		std::greater<>());
+
+	telemetry::Array topRules;
+	telemetry::Array topRulesTimes;
+	for (size_t topIndex = 0; topIndex < topRulesCount; topIndex++) {
+		topRules.emplace_back(static_cast<uint64_t>(rulesTimes[topIndex].second));
+		topRulesTimes.emplace_back(rulesTimes[topIndex].first);
+	}
+
+	telemetry::Dict dict;
+	dict["topRules"] = topRules;
+	dict["topRulesEstimatedTimeNs"] = topRulesTimes;
+
+	const size_t maskGroupsCount
+		= matchingContexts.front().rulesProfiler->getMaskGroupsProfiles().size();
+	for (size_t groupIndex = 0; groupIndex < maskGroupsCount; groupIndex++) {
+		MaskGroupProfile profile;
+		for (const auto& context : matchingContexts) {
+			const MaskGroupProfile& contextProfile
+				= context.rulesProfiler->getMaskGroupsProfiles()[groupIndex];
+			profile.sampledCount.add(contextProfile.sampledCount.load());
+			profile.sampledLookupTime.add(contextProfile.sampledLookupTime.load());
+			profile.sampledMatchTime.add(contextProfile.sampledMatchTime.load());
+		}
+
+		const std::string prefix = "maskGroup" + std::to_string(groupIndex);
+		dict[prefix + ".meanLookupTime"] = telemetry::ScalarWithUnit(
+			getMeanTime(profile.sampledLookupTime.load(), profile.sampledCount.load()),
+			"ns");
+		dict[prefix + ".meanMatchTime"] = telemetry::ScalarWithUnit(
+			getMeanTime(profile.sampledMatchTime.load(), profile.sampledCount.load()),
+			"ns");
+	}
+	return dict;
+}
+
+static telemetry::Content
+createVerdictCacheTelemetryContent(const std::vector<MatchingContext>& matchingContexts)
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+	for (const auto& context : matchingContexts) {
+		const VerdictCacheStats& contextStats = context.verdictCache->getStats();
+		hits += contextStats.hits.load();
+		misses += contextStats.misses.load();
+		evictions += contextStats.evictions.load();
+	}
+
+	double hitRatio = 0;
+	if (hits + misses != 0) {
+		const int fractionToPercentage = 100;
+		hitRatio = static_cast<double>(hits) / static_cast<double>(hits + misses)
+			* fractionToPercentage;
+	}
+
+	telemetry::Dict dict;
+	dict["hits"] = telemetry::Scalar(hits);
+	dict["misses"] = telemetry::Scalar(misses);
+	dict["evictions"] = telemetry::Scalar(evictions);
+	dict["hitRatio"] = telemetry::ScalarWithUnit(hitRatio, "%");
+	return dict;
+}
+
+static telemetry::Content createEvaluationPlanTelemetryContent(
+	const std::vector<std::string>& filterStagesNames,
+	const std::vector<MatchingContext>& matchingContexts)
 {
-	const RuleStats& ruleStats = rule.getStats();
+	const int fractionToPercentage = 100;
+	auto toPercentage = [](uint64_t part, uint64_t total) {
+		return total == 0 ? 0.0
+						  : static_cast<double>(part) / static_cast<double>(total)
+				* fractionToPercentage;
+	};
+	const double nanosecondsPerTick = Nm::InstrumentationClock::getNanosecondsPerTick();
+	auto toMeanTime = [nanosecondsPerTick](const Nm::Counter& time, const Nm::Counter& count) {
+		return getMeanTime(time.load(), count.load()) * nanosecondsPerTick;
+	};
+
+	// Statistics are summed over all contexts, the plan is shown for the first one
+	const EvaluationPlanner& firstPlanner = matchingContexts.front().evaluationPlanner;
+	std::vector<FilterStageStats> filterStagesStats(firstPlanner.getFilterStagesStats().size());
+	std::vector<MaskGroupStats> maskGroupsStats(firstPlanner.getMaskGroupsStats().size());
+	uint64_t earlyExitsCount = 0;
+
+	for (const auto& context : matchingContexts) {
+		const EvaluationPlanner& planner = context.evaluationPlanner;
+		for (size_t stageIndex = 0; stageIndex < filterStagesStats.size(); stageIndex++) {
+			const FilterStageStats& stats = planner.getFilterStagesStats()[stageIndex];
+			FilterStageStats& sum = filterStagesStats[stageIndex];
+			sum.inputCandidatesCount.add(stats.inputCandidatesCount.load());
+			sum.outputCandidatesCount.add(stats.outputCandidatesCount.load());
+			sum.sampledCount.add(stats.sampledCount.load());
+			sum.sampledTime.add(stats.sampledTime.load());
+		}
+		for (size_t groupIndex = 0; groupIndex < maskGroupsStats.size(); groupIndex++) {
+			const MaskGroupStats& stats = planner.getMaskGroupsStats()[groupIndex];
+			MaskGroupStats& sum = maskGroupsStats[groupIndex];
+			sum.skippedCount.add(stats.skippedCount.load());
+			sum.evaluatedCount.add(stats.evaluatedCount.load());
+			sum.matchedCount.add(stats.matchedCount.load());
+			sum.sampledCount.add(stats.sampledCount.load());
+			sum.sampledTime.add(stats.sampledTime.load());
+		}
+		earlyExitsCount += planner.getEarlyExitsCount();
+	}
+
+	telemetry::Dict dict;
+	telemetry::Array filterStagesOrder;
+	for (const size_t stageIndex : firstPlanner.getPublishedFilterStagesOrder()) {
+		filterStagesOrder.emplace_back(filterStagesNames[stageIndex]);
+	}
+	telemetry::Array maskGroupsOrder;
+	for (const size_t groupIndex : firstPlanner.getPublishedMaskGroupsOrder()) {
+		maskGroupsOrder.emplace_back(static_cast<uint64_t>(groupIndex));
+	}
+	dict["filterStagesOrder"] = filterStagesOrder;
+	dict["maskGroupsOrder"] = maskGroupsOrder;
+	dict["earlyExits"] = telemetry::Scalar(earlyExitsCount);
+
+	for (size_t stageIndex = 0; stageIndex < filterStagesStats.size(); stageIndex++) {
+		const FilterStageStats& stats = filterStagesStats[stageIndex];
+		const std::string& prefix = filterStagesNames[stageIndex];
+		dict[prefix + ".passRatio"] = telemetry::ScalarWithUnit(
+			toPercentage(stats.outputCandidatesCount.load(), stats.inputCandidatesCount.load()),
+			"%");
+		dict[prefix + ".meanTime"]
+			= telemetry::ScalarWithUnit(toMeanTime(stats.sampledTime, stats.sampledCount), "ns");
+	}
+	for (size_t groupIndex = 0; groupIndex < maskGroupsStats.size(); groupIndex++) {
+		const MaskGroupStats& stats = maskGroupsStats[groupIndex];
+		const uint64_t skippedCount = stats.skippedCount.load();
+		const uint64_t evaluatedCount = stats.evaluatedCount.load();
+		const std::string prefix = "maskGroup" + std::to_string(groupIndex);
+		dict[prefix + ".skipRatio"] = telemetry::ScalarWithUnit(
+			toPercentage(skippedCount, skippedCount + evaluatedCount),
+			"%");
+		dict[prefix + ".matchRatio"] = telemetry::ScalarWithUnit(
+			toPercentage(stats.matchedCount.load(), evaluatedCount),
+			"%");
+		dict[prefix + ".meanTime"]
+			= telemetry::ScalarWithUnit(toMeanTime(stats.sampledTime, stats.sampledCount), "ns");
+	}
+	return dict;
+}
+
+static telemetry::Content createPrefilterTelemetryContent(
+	bool isUsed,
+	const std::vector<MatchingContext>& matchingContexts)
+{
+	uint64_t rejectedCount = 0;
+	uint64_t passedCount = 0;
+	uint64_t falsePositiveCount = 0;
+	for (const auto& context : matchingContexts) {
+		rejectedCount += context.prefilterStats.rejectedCount.load();
+		passedCount += context.prefilterStats.passedCount.load();
+		falsePositiveCount += context.prefilterStats.falsePositiveCount.load();
+	}
+
+	const int fractionToPercentage = 100;
+	auto toPercentage = [](uint64_t part, uint64_t total) {
+		return total == 0 ? 0.0
+						  : static_cast<double>(part) / static_cast<double>(total)
+				* fractionToPercentage;
+	};
+
 	telemetry::Dict dict;
-	dict["matchedCount"] = telemetry::Scalar(ruleStats.matchedCount);
+	dict["used"] = telemetry::Scalar(isUsed);
+	dict["rejected"] = telemetry::Scalar(rejectedCount);
+	dict["passed"] = telemetry::Scalar(passedCount);
+	dict["falsePositives"] = telemetry::Scalar(falsePositiveCount);
+	dict["bypassRatio"] = telemetry::ScalarWithUnit(
+		toPercentage(rejectedCount, rejectedCount + passedCount),
+		"%");
+	dict["falsePositiveRate"] = telemetry::ScalarWithUnit(
+		toPercentage(falsePositiveCount, falsePositiveCount + rejectedCount),
+		"%");
 	return dict;
 }
 
@@ -41,15 +282,36 @@ ListDetectorMode ListDetector::convertStringToListDetectorMode(const std::string
 	return ListDetectorMode::WHITELIST;
 }
 
-ListDetector::ListDetector(const ConfigParser* configParser, ListDetectorMode mode)
+ListDetector::ListDetector(
+	const ConfigParser* configParser,
+	ListDetectorMode mode,
+	const ListDetectorParameters& parameters)
 	: m_mode(mode)
-	, m_rulesMatcher(configParser)
+	, m_rulesMatcher(configParser, parameters.usePrefilter)
+	, M_PARAMETERS(parameters)
 {
+	if (parameters.matchingContextsCount == 0) {
+		throw std::invalid_argument("ListDetector requires at least one matching context");
+	}
+
+	for (size_t index = 0; index < parameters.matchingContextsCount; index++) {
+		m_matchingContexts.emplace_back(
+			m_rulesMatcher.createMatchingContext(
+				parameters.verdictCacheSize,
+				parameters.profileRules));
+	}
 }
 
 bool ListDetector::matches(const Nemea::UnirecRecordView& unirecRecordView)
 {
-	const bool match = m_rulesMatcher.anyOfRuleMatches(unirecRecordView);
+	return matches(unirecRecordView, m_matchingContexts.front());
+}
+
+bool ListDetector::matches(
+	const Nemea::UnirecRecordView& unirecRecordView,
+	MatchingContext& context) const
+{
+	const bool match = m_rulesMatcher.anyOfRuleMatches(unirecRecordView, context);
 
 	if (m_mode == ListDetectorMode::WHITELIST) {
 		return match;
@@ -57,6 +319,16 @@ bool ListDetector::matches(const Nemea::UnirecRecordView& unirecRecordView)
 	return !match;
 }
 
+bool ListDetector::anyOfRulesMatches(const Nemea::UnirecRecordView& unirecRecordView)
+{
+	return m_rulesMatcher.anyOfRuleMatches(unirecRecordView, m_matchingContexts.front());
+}
+
+MatchingContext& ListDetector::getMatchingContext(size_t index)
+{
+	return m_matchingContexts.at(index);
+}
+
 void ListDetector::setTelemetryDirectory(const std::shared_ptr<telemetry::Directory>& directory)
 {
 	m_holder.add(directory);
@@ -65,21 +337,59 @@ void ListDetector::setTelemetryDirectory(const std::shared_ptr<telemetry::Direct
 	const std::vector<Rule>& rules = m_rulesMatcher.getRules();
 
 	for (size_t ruleIndex = 0; ruleIndex < rules.size(); ruleIndex++) {
-		const Rule& rule = rules.at(ruleIndex);
 		const telemetry::FileOps fileOps
-			= {[&rule]() { return createRuleTelemetryContent(rule); }, nullptr};
+			= {[this, ruleIndex]() {
+				   return createRuleTelemetryContent(ruleIndex, m_matchingContexts);
+			   },
+			   nullptr};
 		auto ruleFile = rulesDirectory->addFile(std::to_string(ruleIndex), fileOps);
 		m_holder.add(ruleFile);
 	}
 
-	const telemetry::AggOperation aggFileOps = {
-		telemetry::AggMethodType::SUM,
-		"matchedCount",
-		"totalMatchedCount",
+	std::vector<telemetry::AggOperation> aggFileOps = {
+		{telemetry::AggMethodType::SUM, "matchedCount", "totalMatchedCount"},
 	};
+	if (M_PARAMETERS.profileRules) {
+		aggFileOps.push_back(
+			{telemetry::AggMethodType::SUM, "evaluatedCount", "totalEvaluatedCount"});
+		aggFileOps.push_back(
+			{telemetry::AggMethodType::SUM, "estimatedTimeNs", "totalEstimatedTimeNs"});
+	}
 
-	auto aggFile = directory->addAggFile("aggStats", "rules/.*", {aggFileOps});
+	auto aggFile = directory->addAggFile("aggStats", "rules/.*", aggFileOps);
 	m_holder.add(aggFile);
+
+	const telemetry::FileOps evaluationPlanFileOps
+		= {[this, filterStagesNames = m_rulesMatcher.getFilterStagesNames()]() {
+			   return createEvaluationPlanTelemetryContent(filterStagesNames, m_matchingContexts);
+		   },
+		   nullptr};
+	m_holder.add(directory->addFile("evaluationPlan", evaluationPlanFileOps));
+
+	if (M_PARAMETERS.usePrefilter) {
+		const telemetry::FileOps prefilterFileOps
+			= {[this]() {
+				   return createPrefilterTelemetryContent(
+					   m_rulesMatcher.hasPrefilter(),
+					   m_matchingContexts);
+			   },
+			   nullptr};
+		m_holder.add(directory->addFile("prefilter", prefilterFileOps));
+	}
+
+	if (M_PARAMETERS.profileRules) {
+		const telemetry::FileOps rulesProfileFileOps
+			= {[this]() { return createRulesProfileTelemetryContent(m_matchingContexts); },
+			   nullptr};
+		m_holder.add(directory->addFile("rulesProfile", rulesProfileFileOps));
+	}
+
+	if (M_PARAMETERS.verdictCacheSize != 0) {
+		const telemetry::FileOps verdictCacheFileOps
+			= {[this]() { return createVerdictCacheTelemetryContent(m_matchingContexts); },
+			   nullptr};
+		m_holder.add(directory->addFile("verdictCache", verdictCacheFileOps));
+	}
 }
 
 } // namespace ListDetector
@@ -27,6 +27,16 @@ enum class ListDetectorMode : uint8_t {
 	WHITELIST ///< Only records that do not match any rule in rule list are forwarded.
 };
 
+/**
+ * @brief Parameters of the ListDetector.
+ */
+struct ListDetectorParameters {
+	size_t matchingContextsCount = 1; ///< Number of matching contexts (one per matching thread).
+	size_t verdictCacheSize = 0; ///< Cached verdicts per matching context, 0 disables the cache.
+	bool usePrefilter = false; ///< Screen records by the Bloom filter prefilter.
+	bool profileRules = false; ///< Collect the matching cost of rules and mask groups.
+};
+
 /**
  * @brief Represents a ListDetector for Nemea++ records.
  */
@@ -36,16 +46,51 @@ public:
 	 * @brief Constructor for ListDetector.
 	 * @param configParser Pointer to the ConfigParser providing rules.
 	 * @param mode Mode to use.
+	 * @param parameters Parameters of the ListDetector.
 	 */
-	explicit ListDetector(const ConfigParser* configParser, ListDetectorMode mode);
+	explicit ListDetector(
+		const ConfigParser* configParser,
+		ListDetectorMode mode,
+		const ListDetectorParameters& parameters = {});
 
 	/**
 	 * @brief Checks if the given UnirecRecordView matches some rule from ListDetector.
+	 *
+	 * Uses the first matching context, so it must be called from a single thread only.
+	 *
 	 * @param unirecRecordView The Unirec record to check against the ListDetector.
 	 * @return True if matches, false otherwise.
 	 */
 	bool matches(const Nemea::UnirecRecordView& unirecRecordView);
 
+	/**
+	 * @brief Checks if the given UnirecRecordView matches some rule from ListDetector.
+	 *
+	 * Can be called concurrently as long as each thread uses its own matching context.
+	 *
+	 * @param unirecRecordView The Unirec record to check against the ListDetector.
+	 * @param context Matching context of the calling thread.
+	 * @return True if matches, false otherwise.
+	 */
+	bool matches(const Nemea::UnirecRecordView& unirecRecordView, MatchingContext& context) const;
+
+	/**
+	 * @brief Checks if some rule of the ListDetector matches the given record regardless of mode.
+	 *
+	 * Uses the first matching context, so it must be called from a single thread only.
+	 *
+	 * @param unirecRecordView The Unirec record to check against the rules.
+	 * @return True if some rule matches, false otherwise.
+	 */
+	bool anyOfRulesMatches(const Nemea::UnirecRecordView& unirecRecordView);
+
+	/**
+	 * @brief Returns matching context with the given index.
+	 * @param index Index of the context, must be less than the count passed in parameters.
+	 * @return Reference to the matching context.
+	 */
+	MatchingContext& getMatchingContext(size_t index);
+
 	/**
 	 * @brief Sets the telemetry directory for the ListDetector.
 	 * @param directory directory for ListDetector telemetry.
@@ -65,6 +110,8 @@ private:
 	ListDetectorMode m_mode;
 
 	RulesMatcher m_rulesMatcher;
+	const ListDetectorParameters M_PARAMETERS;
+	std::vector<MatchingContext> m_matchingContexts;
 };
 
 } // namespace ListDetector
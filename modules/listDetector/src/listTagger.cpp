@@ -0,0 +1,115 @@
+/**
+ * @file
+ * @brief Implementation of the ListTagger class matching records against several rule lists.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "listTagger.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace ListDetector {
+
+static std::string mergeUnirecTemplateDescriptions(const std::vector<std::string>& descriptions)
+{
+	std::vector<std::string> fields;
+	std::unordered_map<std::string, std::string> fieldTypes;
+
+	for (const auto& description : descriptions) {
+		std::istringstream sstream(description);
+		std::string field;
+		while (std::getline(sstream, field, ',')) {
+			const size_t pos = field.find(' ');
+			const std::string fieldType = field.substr(0, pos);
+			const std::string fieldName = field.substr(pos + 1);
+
+			const auto [it, inserted] = fieldTypes.emplace(fieldName, fieldType);
+			if (inserted) {
+				fields.emplace_back(field);
+			} else if (it->second != fieldType) {
+				throw std::invalid_argument(
+					"Field '" + fieldName + "' has different types in rule lists");
+			}
+		}
+	}
+
+	std::string mergedDescription;
+	for (const auto& field : fields) {
+		mergedDescription += (mergedDescription.empty() ? "" : ",") + field;
+	}
+	return mergedDescription;
+}
+
+ListTagger::ListTagger(
+	const std::vector<RulesList>& rulesLists,
+	const ListDetectorParameters& parameters)
+{
+	if (rulesLists.empty() || rulesLists.size() > MAX_LISTS_COUNT) {
+		throw std::invalid_argument(
+			"ListTagger requires 1 to " + std::to_string(MAX_LISTS_COUNT) + " rule lists");
+	}
+
+	std::vector<std::string> descriptions;
+	for (const auto& [name, configParser] : rulesLists) {
+		if (std::find(m_listNames.begin(), m_listNames.end(), name) != m_listNames.end()) {
+			throw std::invalid_argument("Rule list name '" + name + "' is not unique");
+		}
+
+		m_listNames.emplace_back(name);
+		// Mode of the detectors is not used, only matching of their rules
+		m_listDetectors.emplace_back(
+			std::make_unique<ListDetector>(configParser, ListDetectorMode::BLACKLIST, parameters));
+		descriptions.emplace_back(configParser->getUnirecTemplateDescription());
+	}
+
+	m_listMatchedCounts.resize(rulesLists.size());
+	m_unirecTemplateDescription = mergeUnirecTemplateDescriptions(descriptions);
+}
+
+uint64_t ListTagger::getMatchingListsMask(const Nemea::UnirecRecordView& unirecRecordView)
+{
+	uint64_t matchingListsMask = 0;
+
+	for (size_t listIndex = 0; listIndex < m_listDetectors.size(); listIndex++) {
+		if (m_listDetectors[listIndex]->anyOfRulesMatches(unirecRecordView)) {
+			matchingListsMask |= 1ULL << listIndex;
+			m_listMatchedCounts[listIndex].add();
+		}
+	}
+
+	return matchingListsMask;
+}
+
+std::string ListTagger::getUnirecTemplateDescription() const
+{
+	return m_unirecTemplateDescription;
+}
+
+telemetry::Content ListTagger::createListsTelemetryContent() const
+{
+	telemetry::Dict dict;
+	for (size_t listIndex = 0; listIndex < m_listNames.size(); listIndex++) {
+		dict[m_listNames[listIndex]] = telemetry::Scalar(m_listMatchedCounts[listIndex].load());
+	}
+	return dict;
+}
+
+void ListTagger::setTelemetryDirectory(const std::shared_ptr<telemetry::Directory>& directory)
+{
+	m_holder.add(directory);
+
+	for (size_t listIndex = 0; listIndex < m_listDetectors.size(); listIndex++) {
+		m_listDetectors[listIndex]->setTelemetryDirectory(
+			directory->addDir(m_listNames[listIndex]));
+	}
+
+	const telemetry::FileOps fileOps
+		= {[this]() { return createListsTelemetryContent(); }, nullptr};
+	m_holder.add(directory->addFile("lists", fileOps));
+}
+
+} // namespace ListDetector
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief Declaration of the ListTagger class matching records against several rule lists.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "configParser.hpp"
+#include "counter/counter.hpp"
+#include "listDetector.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <telemetry.hpp>
+#include <unirec++/unirec.hpp>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Matches Unirec records against several named rule lists in a single pass.
+ *
+ * Each list is kept by its own ListDetector. The result of matching is a bitmask where the i-th
+ * bit is set when some rule of the i-th list matched the record.
+ */
+class ListTagger {
+public:
+	/**
+	 * @brief Maximal number of lists, limited by the width of the result bitmask.
+	 */
+	static inline const size_t MAX_LISTS_COUNT = 64;
+
+	/**
+	 * @brief Named list of rules.
+	 */
+	struct RulesList {
+		std::string name; ///< Name of the list used in telemetry.
+		const ConfigParser* configParser; ///< Parser providing rules of the list.
+	};
+
+	/**
+	 * @brief Constructor for ListTagger.
+	 * @param rulesLists Lists of rules. Order of the lists defines the bits of the result.
+	 * @param parameters Parameters used for ListDetector of each list.
+	 */
+	ListTagger(const std::vector<RulesList>& rulesLists, const ListDetectorParameters& parameters);
+
+	/**
+	 * @brief Matches the record against all lists.
+	 * @param unirecRecordView The Unirec record to match.
+	 * @return Bitmask of the lists with some matching rule.
+	 */
+	uint64_t getMatchingListsMask(const Nemea::UnirecRecordView& unirecRecordView);
+
+	/**
+	 * @brief Get the Unirec template description required by all lists.
+	 * @return Unirec template description with fields of all lists.
+	 */
+	std::string getUnirecTemplateDescription() const;
+
+	/**
+	 * @brief Sets the telemetry directory for the ListTagger.
+	 *
+	 * Each list gets own subdirectory with the ListDetector telemetry.
+	 *
+	 * @param directory directory for ListTagger telemetry.
+	 */
+	void setTelemetryDirectory(const std::shared_ptr<telemetry::Directory>& directory);
+
+private:
+	telemetry::Content createListsTelemetryContent() const;
+
+	telemetry::Holder m_holder;
+
+	std::vector<std::string> m_listNames;
+	std::vector<std::unique_ptr<ListDetector>> m_listDetectors;
+	std::vector<Nm::Counter> m_listMatchedCounts;
+	std::string m_unirecTemplateDescription;
+};
+
+} // namespace ListDetector
@@ -13,22 +13,45 @@
  */
 
 #include "csvConfigParser.hpp"
+#include "instrumentation/processingLatency.hpp"
 #include "listDetector.hpp"
+#include "listTagger.hpp"
 #include "logger/logger.hpp"
+#include "matchingPipeline.hpp"
 #include "unirec/unirec-telemetry.hpp"
 
 #include <appFs.hpp>
 #include <argparse/argparse.hpp>
 #include <atomic>
 #include <csignal>
+#include <filesystem>
 #include <iostream>
+#include <libtrap/trap.h>
 #include <stdexcept>
+#include <string>
 #include <telemetry.hpp>
 #include <unirec++/unirec.hpp>
+#include <utility>
+#include <vector>
 
 using namespace Nemea;
 
 static std::atomic<bool> g_stopFlag(false);
+static Nm::ProcessingLatency g_processingLatency;
+static Nm::SendStats g_sendStats;
+
+/**
+ * @brief Receive timeout (in microseconds) used when records are matched by worker threads.
+ *
+ * When no record is received within the timeout, the partially filled batch is flushed so the
+ * latency of forwarded records stays bounded on slow inputs.
+ */
+static const int g_PIPELINE_RECEIVE_TIMEOUT = 100000;
+
+/**
+ * @brief Name of the field with bitmask of matching lists added by the tagging mode.
+ */
+static const std::string g_LIST_MATCH_MASK_FIELD = "LIST_MATCH_MASK";
 
 static void signalHandler(int signum)
 {
@@ -62,13 +85,19 @@ static void processNextRecord(
 	UnirecBidirectionalInterface& biInterface,
 	ListDetector::ListDetector& listDetector)
 {
+	Nm::PhaseTimer phaseTimer;
 	std::optional<UnirecRecordView> unirecRecord = biInterface.receive();
 	if (!unirecRecord) {
 		return;
 	}
+	phaseTimer.lap(g_processingLatency.receive);
+
+	const bool isMatched = listDetector.matches(*unirecRecord);
+	phaseTimer.lap(g_processingLatency.process);
 
-	if (!listDetector.matches(*unirecRecord)) {
-		biInterface.send(*unirecRecord);
+	if (!isMatched) {
+		g_sendStats.send(biInterface, *unirecRecord);
+		phaseTimer.lap(g_processingLatency.send);
 	}
 }
 
@@ -101,6 +130,222 @@ static void processUnirecRecords(
 	}
 }
 
+/**
+ * @brief Process the next Unirec record by the matching pipeline.
+ *
+ * This function receives the next Unirec record through the bidirectional interface and passes
+ * it to the matching pipeline, which forwards matched records in the input order. If no record is
+ * received, the pipeline is flushed.
+ *
+ * @param biInterface Bidirectional interface for Unirec communication.
+ * @param matchingPipeline Pipeline matching the records in worker threads.
+ */
+static void processNextRecord(
+	UnirecBidirectionalInterface& biInterface,
+	ListDetector::MatchingPipeline& matchingPipeline)
+{
+	Nm::PhaseTimer phaseTimer;
+	std::optional<UnirecRecordView> unirecRecord = biInterface.receive();
+	if (!unirecRecord) {
+		matchingPipeline.flush();
+		return;
+	}
+	phaseTimer.lap(g_processingLatency.receive);
+
+	// Matched batches are forwarded from here, so the process phase includes their send phases
+	matchingPipeline.process(*unirecRecord);
+	phaseTimer.lap(g_processingLatency.process);
+}
+
+/**
+ * @brief Process Unirec records by the matching pipeline.
+ *
+ * Works as the single threaded variant, but the records are matched by worker threads of the
+ * matching pipeline. Pending records are flushed before the template is changed and when the
+ * loop ends.
+ *
+ * @param biInterface Bidirectional interface for Unirec communication.
+ * @param matchingPipeline Pipeline matching the records in worker threads.
+ */
+static void processUnirecRecords(
+	UnirecBidirectionalInterface& biInterface,
+	ListDetector::MatchingPipeline& matchingPipeline)
+{
+	biInterface.setReceiveTimeout(g_PIPELINE_RECEIVE_TIMEOUT);
+
+	while (!g_stopFlag.load()) {
+		try {
+			processNextRecord(biInterface, matchingPipeline);
+		} catch (FormatChangeException& ex) {
+			matchingPipeline.changeTemplate();
+			handleFormatChange(biInterface);
+		} catch (const EoFException& ex) {
+			break;
+		} catch (const std::exception& ex) {
+			throw;
+		}
+	}
+
+	matchingPipeline.flush();
+}
+
+/**
+ * @brief Output of the tagging mode.
+ */
+struct TaggingOutput {
+	UnirecOutputInterface& interface; ///< Output interface.
+	std::optional<UnirecRecord> record; ///< Output record, created on the format change.
+	ur_field_id_t listMatchMaskId; ///< Id of the field with bitmask of matching lists.
+};
+
+/**
+ * @brief Handle a format change exception in the tagging mode.
+ *
+ * The output template is the input template extended by the field with bitmask of matching lists.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output of the tagging mode.
+ */
+static void handleFormatChange(UnirecInputInterface& inputInterface, TaggingOutput& output)
+{
+	inputInterface.changeTemplate();
+
+	uint8_t dataType;
+	const char* inputSpecification = nullptr;
+	if (trap_get_data_fmt(TRAPIFC_INPUT, 0, &dataType, &inputSpecification) != TRAP_E_OK) {
+		throw std::runtime_error("Unable to get the format of the input interface");
+	}
+
+	std::string outputSpecification = inputSpecification;
+	if (("," + outputSpecification + ",").find(" " + g_LIST_MATCH_MASK_FIELD + ",")
+		== std::string::npos) {
+		outputSpecification += ",uint64 " + g_LIST_MATCH_MASK_FIELD;
+	}
+
+	output.interface.changeTemplate(outputSpecification);
+	output.record.emplace(output.interface.createUnirecRecord());
+	output.listMatchMaskId
+		= static_cast<ur_field_id_t>(ur_get_id_by_name(g_LIST_MATCH_MASK_FIELD.c_str()));
+}
+
+/**
+ * @brief Process the next Unirec record and forward it tagged by the matching lists.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output of the tagging mode.
+ * @param listTagger ListTagger instance for matching Unirec records.
+ */
+static void processNextRecord(
+	UnirecInputInterface& inputInterface,
+	TaggingOutput& output,
+	ListDetector::ListTagger& listTagger)
+{
+	Nm::PhaseTimer phaseTimer;
+	std::optional<UnirecRecordView> unirecRecord = inputInterface.receive();
+	if (!unirecRecord) {
+		return;
+	}
+	phaseTimer.lap(g_processingLatency.receive);
+
+	output.record->copyFieldsFrom(*unirecRecord);
+	output.record->setFieldFromType(
+		listTagger.getMatchingListsMask(*unirecRecord),
+		output.listMatchMaskId);
+	phaseTimer.lap(g_processingLatency.process);
+
+	output.interface.send(*output.record);
+	phaseTimer.lap(g_processingLatency.send);
+}
+
+/**
+ * @brief Process Unirec records in the tagging mode.
+ *
+ * Every received record is matched against all rule lists in a single pass and forwarded with
+ * the bitmask of matching lists.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output of the tagging mode.
+ * @param listTagger ListTagger instance for matching Unirec records.
+ */
+static void processUnirecRecords(
+	UnirecInputInterface& inputInterface,
+	TaggingOutput& output,
+	ListDetector::ListTagger& listTagger)
+{
+	while (!g_stopFlag.load()) {
+		try {
+			processNextRecord(inputInterface, output, listTagger);
+		} catch (FormatChangeException& ex) {
+			handleFormatChange(inputInterface, output);
+		} catch (const EoFException& ex) {
+			break;
+		} catch (const std::exception& ex) {
+			throw;
+		}
+	}
+}
+
+/**
+ * @brief Splits the rule list specification `[name=]file` to the name and the file.
+ *
+ * If the name is not specified, the file name without extension is used.
+ *
+ * @param specification Rule list specification.
+ * @return Pair of the list name and the rule file.
+ */
+static std::pair<std::string, std::string>
+splitRulesListSpecification(const std::string& specification)
+{
+	const size_t pos = specification.find('=');
+	if (pos == std::string::npos) {
+		return {std::filesystem::path(specification).stem().string(), specification};
+	}
+	return {specification.substr(0, pos), specification.substr(pos + 1)};
+}
+
+/**
+ * @brief Runs the tagging mode matching records against all rule lists in a single pass.
+ *
+ * @param unirec Initialized Unirec instance.
+ * @param rulesListSpecifications Rule lists in the `[name=]file` format.
+ * @param parameters Parameters of the ListDetector of each list.
+ * @param telemetryRootDirectory Root telemetry directory.
+ */
+static void runTaggingMode(
+	Unirec& unirec,
+	const std::vector<std::string>& rulesListSpecifications,
+	const ListDetector::ListDetectorParameters& parameters,
+	const std::shared_ptr<telemetry::Directory>& telemetryRootDirectory)
+{
+	std::vector<std::unique_ptr<ListDetector::ConfigParser>> configParsers;
+	std::vector<ListDetector::ListTagger::RulesList> rulesLists;
+	for (const auto& specification : rulesListSpecifications) {
+		const auto [name, rulesFile] = splitRulesListSpecification(specification);
+		configParsers.emplace_back(std::make_unique<ListDetector::CsvConfigParser>(rulesFile));
+		rulesLists.push_back({name, configParsers.back().get()});
+	}
+
+	ListDetector::ListTagger listTagger(rulesLists, parameters);
+
+	UnirecInputInterface inputInterface = unirec.buildInputInterface();
+	UnirecOutputInterface outputInterface = unirec.buildOutputInterface();
+	inputInterface.setRequieredFormat(listTagger.getUnirecTemplateDescription());
+
+	auto telemetryInputDirectory = telemetryRootDirectory->addDir("input");
+	const Nm::InterfaceRatesSampler ratesSampler(inputInterface);
+	const telemetry::FileOps inputFileOps
+		= {[&inputInterface, &ratesSampler]() {
+			   return Nm::getInterfaceTelemetry(inputInterface, ratesSampler);
+		   },
+		   nullptr};
+	const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
+
+	listTagger.setTelemetryDirectory(telemetryRootDirectory->addDir("listdetector"));
+
+	TaggingOutput output = {outputInterface, std::nullopt, 0};
+	processUnirecRecords(inputInterface, output, listTagger);
+}
+
 int main(int argc, char** argv)
 {
 	argparse::ArgumentParser program("listdetector");
@@ -113,13 +358,49 @@ int main(int argc, char** argv)
 	try {
 		program.add_argument("-r", "--rules")
 			.required()
-			.help("specify the CSV rule file.")
+			.append()
+			.help("specify the CSV rule file. In the tagging mode it can be repeated as "
+				  "[name=]csv_file")
 			.metavar("csv_file");
 
+		program.add_argument("--tag")
+			.help("tag every record by bitmask of matching rule lists in the LIST_MATCH_MASK "
+				  "field instead of filtering")
+			.default_value(false)
+			.implicit_value(true);
+
 		program.add_argument("-lm", "--listmode")
 			.help("specify the list detector mode. Default is whitelist")
 			.default_value(std::string("whitelist"));
 
+		program.add_argument("-t", "--threads")
+			.help("number of threads matching the records. Default is 1 (matching in the receive "
+				  "thread)")
+			.default_value(1)
+			.scan<'i', int>();
+
+		program.add_argument("-b", "--batch-size")
+			.help("number of records passed to a matching thread at once. Used only with more "
+				  "than one thread")
+			.default_value(static_cast<int>(ListDetector::MatchingPipeline::DEFAULT_BATCH_SIZE))
+			.scan<'i', int>();
+
+		program.add_argument("-c", "--verdict-cache-size")
+			.help("number of cached verdicts per matching thread. Default is 0 (cache disabled)")
+			.default_value(0)
+			.scan<'i', int>();
+
+		program.add_argument("-p", "--prefilter")
+			.help("reject records that can not match any rule by a Bloom filter before full "
+				  "matching. Useful for blacklists")
+			.default_value(false)
+			.implicit_value(true);
+
+		program.add_argument("--profile-rules")
+			.help("collect the matching cost of rules and mask groups in the telemetry")
+			.default_value(false)
+			.implicit_value(true);
+
 		program.add_argument("-m", "--appfs-mountpoint")
 			.required()
 			.help("path where the appFs directory will be mounted")
@@ -150,6 +431,8 @@ int main(int argc, char** argv)
 
 	std::shared_ptr<telemetry::Directory> telemetryRootDirectory;
 	telemetryRootDirectory = telemetry::Directory::create();
+	const auto latencyFile
+		= Nm::addProcessingLatencyFile(telemetryRootDirectory, g_processingLatency);
 
 	std::unique_ptr<telemetry::appFs::AppFsFuse> appFs;
 
@@ -171,26 +454,85 @@ int main(int argc, char** argv)
 	}
 
 	try {
+		const int threadsCount = program.get<int>("--threads");
+		const int batchSize = program.get<int>("--batch-size");
+		if (threadsCount <= 0 || batchSize <= 0) {
+			std::cerr << "Threads count and batch size must be higher than zero.\n";
+			return EXIT_FAILURE;
+		}
+		const int verdictCacheSize = program.get<int>("--verdict-cache-size");
+		if (verdictCacheSize < 0) {
+			std::cerr << "Verdict cache size can not be negative.\n";
+			return EXIT_FAILURE;
+		}
+
+		ListDetector::ListDetectorParameters parameters;
+		parameters.matchingContextsCount = static_cast<size_t>(threadsCount);
+		parameters.verdictCacheSize = static_cast<size_t>(verdictCacheSize);
+		parameters.usePrefilter = program.get<bool>("--prefilter");
+		parameters.profileRules = program.get<bool>("--profile-rules");
+
+		const auto rulesListSpecifications = program.get<std::vector<std::string>>("--rules");
+		if (program.get<bool>("--tag")) {
+			if (threadsCount != 1) {
+				std::cerr << "Tagging mode supports only one thread.\n";
+				return EXIT_FAILURE;
+			}
+			if (program.is_used("--listmode")) {
+				std::cerr << "Tagging mode does not filter records, list mode can not be used.\n";
+				return EXIT_FAILURE;
+			}
+			runTaggingMode(unirec, rulesListSpecifications, parameters, telemetryRootDirectory);
+			return EXIT_SUCCESS;
+		}
+		if (rulesListSpecifications.size() != 1) {
+			std::cerr << "Multiple rule files can be used only in the tagging mode.\n";
+			return EXIT_FAILURE;
+		}
+
 		std::unique_ptr<ListDetector::ConfigParser> configParser
-			= std::make_unique<ListDetector::CsvConfigParser>(program.get<std::string>("--rules"));
+			= std::make_unique<ListDetector::CsvConfigParser>(
+				splitRulesListSpecification(rulesListSpecifications.front()).second);
 		const std::string requiredUnirecTemplate = configParser->getUnirecTemplateDescription();
 
 		UnirecBidirectionalInterface biInterface = unirec.buildBidirectionalInterface();
 		biInterface.setRequieredFormat(requiredUnirecTemplate);
 
 		auto telemetryInputDirectory = telemetryRootDirectory->addDir("input");
+		const Nm::InterfaceRatesSampler ratesSampler(biInterface, g_sendStats);
 		const telemetry::FileOps inputFileOps
-			= {[&biInterface]() { return Nm::getInterfaceTelemetry(biInterface); }, nullptr};
+			= {[&biInterface, &ratesSampler]() {
+				   return Nm::getInterfaceTelemetry(biInterface, ratesSampler);
+			   },
+			   nullptr};
 		const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
 
+		auto telemetryOutputDirectory = telemetryRootDirectory->addDir("output");
+		const telemetry::FileOps outputFileOps
+			= {[&ratesSampler]() { return Nm::getSendTelemetry(g_sendStats, ratesSampler); },
+			   nullptr};
+		const auto outputFile = telemetryOutputDirectory->addFile("stats", outputFileOps);
+
 		auto mode = ListDetector::ListDetector::convertStringToListDetectorMode(
 			program.get<std::string>("--listmode"));
 
-		ListDetector::ListDetector listDetector(configParser.get(), mode);
+		ListDetector::ListDetector listDetector(configParser.get(), mode, parameters);
 		auto listDetectorTelemetryDirectory = telemetryRootDirectory->addDir("listdetector");
 		listDetector.setTelemetryDirectory(listDetectorTelemetryDirectory);
 
-		processUnirecRecords(biInterface, listDetector);
+		if (threadsCount == 1) {
+			processUnirecRecords(biInterface, listDetector);
+		} else {
+			ListDetector::MatchingPipeline matchingPipeline(
+				listDetector,
+				static_cast<size_t>(threadsCount),
+				static_cast<size_t>(batchSize),
+				[&biInterface](UnirecRecordView& unirecRecord) {
+					const Nm::ScopedTimer sendTimer(g_processingLatency.send);
+					g_sendStats.send(biInterface, unirecRecord);
+				});
+			processUnirecRecords(biInterface, matchingPipeline);
+		}
 
 	} catch (std::exception& ex) {
 		logger->error(ex.what());
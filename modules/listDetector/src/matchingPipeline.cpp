@@ -0,0 +1,221 @@
+/**
+ * @file
+ * @brief Implementation of the MatchingPipeline class for parallel matching of Unirec records.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "matchingPipeline.hpp"
+
+#include <cstring>
+#include <libtrap/trap.h>
+#include <stdexcept>
+
+namespace ListDetector {
+
+static ur_template_t* createInputTemplate()
+{
+	uint8_t dataType;
+	const char* templateSpecification = nullptr;
+	if (trap_get_data_fmt(TRAPIFC_INPUT, 0, &dataType, &templateSpecification) != TRAP_E_OK) {
+		throw std::runtime_error("MatchingPipeline: unable to get format of the input interface");
+	}
+
+	ur_template_t* unirecTemplate = ur_create_template_from_ifc_spec(templateSpecification);
+	if (unirecTemplate == nullptr) {
+		throw std::runtime_error("MatchingPipeline: unable to create template of the input");
+	}
+	return unirecTemplate;
+}
+
+MatchingPipeline::MatchingPipeline(
+	ListDetector& listDetector,
+	size_t workersCount,
+	size_t batchSize,
+	SendCallback sendCallback)
+	: m_listDetector(listDetector)
+	, M_BATCH_SIZE(batchSize)
+	, M_MAX_IN_FLIGHT_BATCHES(2 * workersCount)
+	, m_sendCallback(std::move(sendCallback))
+	, m_currentBatch(std::make_unique<RecordBatch>())
+{
+	if (workersCount == 0 || batchSize == 0) {
+		throw std::invalid_argument("MatchingPipeline: workers count and batch size must be > 0");
+	}
+
+	for (size_t workerIndex = 0; workerIndex < workersCount; workerIndex++) {
+		// Fail early if the ListDetector does not provide enough matching contexts
+		m_listDetector.getMatchingContext(workerIndex);
+	}
+
+	for (size_t workerIndex = 0; workerIndex < workersCount; workerIndex++) {
+		m_workers.emplace_back(&MatchingPipeline::runWorker, this, workerIndex);
+	}
+}
+
+MatchingPipeline::~MatchingPipeline()
+{
+	{
+		const std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopWorkers = true;
+	}
+	m_batchAvailable.notify_all();
+
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+
+	if (m_template != nullptr) {
+		ur_free_template(m_template);
+	}
+}
+
+void MatchingPipeline::process(const Nemea::UnirecRecordView& unirecRecordView)
+{
+	if (m_template == nullptr) {
+		loadTemplate();
+	}
+
+	const auto* recordData = static_cast<const std::byte*>(unirecRecordView.data());
+	const size_t recordSize = ur_rec_size(m_template, unirecRecordView.data());
+
+	auto& batch = *m_currentBatch;
+	batch.recordOffsets.push_back(batch.data.size());
+	batch.data.insert(batch.data.end(), recordData, recordData + recordSize);
+
+	if (batch.recordOffsets.size() >= M_BATCH_SIZE) {
+		dispatchCurrentBatch();
+	}
+
+	forwardMatchedBatches(M_MAX_IN_FLIGHT_BATCHES);
+}
+
+void MatchingPipeline::flush()
+{
+	dispatchCurrentBatch();
+	forwardMatchedBatches(0);
+}
+
+void MatchingPipeline::changeTemplate()
+{
+	flush();
+
+	if (m_template != nullptr) {
+		ur_free_template(m_template);
+		m_template = nullptr;
+	}
+}
+
+void MatchingPipeline::loadTemplate()
+{
+	m_template = createInputTemplate();
+}
+
+void MatchingPipeline::dispatchCurrentBatch()
+{
+	if (m_currentBatch->recordOffsets.empty()) {
+		return;
+	}
+
+	RecordBatch* batch = m_currentBatch.get();
+	m_inFlightBatches.emplace_back(std::move(m_currentBatch));
+
+	if (m_freeBatches.empty()) {
+		m_currentBatch = std::make_unique<RecordBatch>();
+	} else {
+		m_currentBatch = std::move(m_freeBatches.back());
+		m_freeBatches.pop_back();
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(m_mutex);
+		m_pendingBatches.push(batch);
+	}
+	m_batchAvailable.notify_one();
+}
+
+void MatchingPipeline::forwardMatchedBatches(size_t maxInFlightBatches)
+{
+	while (!m_inFlightBatches.empty()) {
+		auto& batch = m_inFlightBatches.front();
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_inFlightBatches.size() > maxInFlightBatches) {
+				m_batchMatched.wait(lock, [&batch]() { return batch->isMatched; });
+			} else if (!batch->isMatched) {
+				return;
+			}
+		}
+
+		forwardBatch(*batch);
+
+		batch->data.clear();
+		batch->recordOffsets.clear();
+		batch->forwardMask.clear();
+		batch->isMatched = false;
+		m_freeBatches.emplace_back(std::move(batch));
+		m_inFlightBatches.pop_front();
+	}
+}
+
+void MatchingPipeline::forwardBatch(const RecordBatch& batch)
+{
+	if (batch.exception) {
+		std::rethrow_exception(batch.exception);
+	}
+
+	for (size_t recordIndex = 0; recordIndex < batch.recordOffsets.size(); recordIndex++) {
+		if (batch.forwardMask[recordIndex]) {
+			Nemea::UnirecRecordView unirecRecordView(
+				batch.data.data() + batch.recordOffsets[recordIndex],
+				m_template);
+			m_sendCallback(unirecRecordView);
+		}
+	}
+}
+
+void MatchingPipeline::matchBatch(RecordBatch& batch, MatchingContext& context) const
+{
+	batch.forwardMask.resize(batch.recordOffsets.size());
+
+	for (size_t recordIndex = 0; recordIndex < batch.recordOffsets.size(); recordIndex++) {
+		const Nemea::UnirecRecordView unirecRecordView(
+			batch.data.data() + batch.recordOffsets[recordIndex],
+			m_template);
+		batch.forwardMask[recordIndex] = !m_listDetector.matches(unirecRecordView, context);
+	}
+}
+
+void MatchingPipeline::runWorker(size_t workerIndex)
+{
+	MatchingContext& context = m_listDetector.getMatchingContext(workerIndex);
+
+	while (true) {
+		RecordBatch* batch = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_batchAvailable.wait(lock, [this]() {
+				return m_stopWorkers || !m_pendingBatches.empty();
+			});
+			if (m_stopWorkers) {
+				return;
+			}
+			batch = m_pendingBatches.front();
+			m_pendingBatches.pop();
+		}
+
+		try {
+			matchBatch(*batch, context);
+		} catch (...) {
+			batch->exception = std::current_exception();
+		}
+
+		{
+			const std::lock_guard<std::mutex> lock(m_mutex);
+			batch->isMatched = true;
+		}
+		m_batchMatched.notify_all();
+	}
+}
+
+} // namespace ListDetector
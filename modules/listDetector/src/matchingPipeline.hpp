@@ -0,0 +1,126 @@
+/**
+ * @file
+ * @brief Declaration of the MatchingPipeline class for parallel matching of Unirec records.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "listDetector.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unirec++/unirec.hpp>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Matches Unirec records by a pool of worker threads while preserving their order.
+ *
+ * Received records are copied into batches which are matched by the worker threads, each of them
+ * using its own matching context of the ListDetector. Matched batches are forwarded by the thread
+ * that calls `process()` or `flush()` strictly in the order in which they were created, so the
+ * forwarded records keep the input order.
+ */
+class MatchingPipeline {
+public:
+	/**
+	 * @brief Callable used to forward records that passed the ListDetector.
+	 *
+	 * The view is not const, as output interfaces of Unirec send only non-const views.
+	 */
+	using SendCallback = std::function<void(Nemea::UnirecRecordView&)>;
+
+	/**
+	 * @brief Default number of records in one batch.
+	 */
+	static inline const size_t DEFAULT_BATCH_SIZE = 256;
+
+	/**
+	 * @brief Constructs the pipeline and starts worker threads.
+	 * @param listDetector ListDetector with at least `workersCount` matching contexts.
+	 * @param workersCount Number of worker threads.
+	 * @param batchSize Number of records dispatched to a worker at once.
+	 * @param sendCallback Callable used to forward records that passed the ListDetector.
+	 */
+	MatchingPipeline(
+		ListDetector& listDetector,
+		size_t workersCount,
+		size_t batchSize,
+		SendCallback sendCallback);
+
+	MatchingPipeline(const MatchingPipeline&) = delete;
+	MatchingPipeline& operator=(const MatchingPipeline&) = delete;
+	MatchingPipeline(MatchingPipeline&&) = delete;
+	MatchingPipeline& operator=(MatchingPipeline&&) = delete;
+
+	/**
+	 * @brief Stops and joins worker threads. Records that were not flushed are dropped.
+	 */
+	~MatchingPipeline();
+
+	/**
+	 * @brief Copies the record to the current batch and forwards already matched batches.
+	 * @param unirecRecordView Received Unirec record.
+	 */
+	void process(const Nemea::UnirecRecordView& unirecRecordView);
+
+	/**
+	 * @brief Dispatches the current batch and waits until all batches are matched and forwarded.
+	 */
+	void flush();
+
+	/**
+	 * @brief Flushes the pipeline and drops the template of the input interface.
+	 *
+	 * Must be called before the template of the Unirec interface is changed. The new template is
+	 * loaded with the next processed record.
+	 */
+	void changeTemplate();
+
+private:
+	struct RecordBatch {
+		std::vector<std::byte> data; ///< Copied records.
+		std::vector<size_t> recordOffsets; ///< Offset of each record in data.
+		std::vector<bool> forwardMask; ///< True for records that should be forwarded.
+		std::exception_ptr exception; ///< Exception thrown while matching the batch.
+		bool isMatched = false; ///< True when the batch was matched by a worker.
+	};
+
+	void loadTemplate();
+	void dispatchCurrentBatch();
+	void forwardMatchedBatches(size_t maxInFlightBatches);
+	void forwardBatch(const RecordBatch& batch);
+	void matchBatch(RecordBatch& batch, MatchingContext& context) const;
+	void runWorker(size_t workerIndex);
+
+	ListDetector& m_listDetector;
+	const size_t M_BATCH_SIZE;
+	const size_t M_MAX_IN_FLIGHT_BATCHES;
+	SendCallback m_sendCallback;
+
+	ur_template_t* m_template = nullptr;
+
+	std::unique_ptr<RecordBatch> m_currentBatch;
+	std::deque<std::unique_ptr<RecordBatch>> m_inFlightBatches;
+	std::vector<std::unique_ptr<RecordBatch>> m_freeBatches;
+
+	std::mutex m_mutex;
+	std::condition_variable m_batchAvailable;
+	std::condition_variable m_batchMatched;
+	std::queue<RecordBatch*> m_pendingBatches;
+	bool m_stopWorkers = false;
+
+	std::vector<std::thread> m_workers;
+};
+
+} // namespace ListDetector
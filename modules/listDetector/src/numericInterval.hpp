@@ -0,0 +1,51 @@
+/**
+ * @file
+ * @brief Declares the NumericInterval structure used to match integer fields against ranges.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Closed interval of integer values of a rule field.
+ *
+ * Values of all integer types are kept as order preserving unsigned keys (see
+ * `toIntervalKey()`), so intervals of all integer fields can be kept by the same structures.
+ */
+struct NumericInterval {
+	uint64_t low; ///< Key of the lowest value of the interval.
+	uint64_t high; ///< Key of the highest value of the interval.
+};
+
+/**
+ * @brief Represents range (`a-b`) or set (`{a,b,c}`) of integer values of a rule field.
+ */
+using NumericIntervals = std::vector<NumericInterval>;
+
+/**
+ * @brief Converts integer value to the unsigned key that keeps the order of values.
+ * @param value Value to convert.
+ * @return Key of the value.
+ */
+template <typename T>
+constexpr uint64_t toIntervalKey(T value) noexcept
+{
+	static_assert(std::is_integral_v<T>, "Only integer values can be converted to interval key");
+
+	if constexpr (std::is_signed_v<T>) {
+		constexpr uint64_t signBit = 1ULL << 63U;
+		return static_cast<uint64_t>(static_cast<int64_t>(value)) ^ signBit;
+	} else {
+		return static_cast<uint64_t>(value);
+	}
+}
+
+} // namespace ListDetector
@@ -59,7 +59,7 @@ bool Rule::isStaticRuleField(const RuleField& ruleField) noexcept
 	return type != UR_TYPE_IP && type != UR_TYPE_STRING;
 }
 
-bool Rule::dynamicFieldsMatch(const Nemea::UnirecRecordView& unirecRecordView)
+bool Rule::dynamicFieldsMatch(const Nemea::UnirecRecordView& unirecRecordView) const
 {
 	auto lambdaPredicate = [&](const auto& ruleField) {
 		return isStaticRuleField(ruleField)
@@ -67,16 +67,7 @@ bool Rule::dynamicFieldsMatch(const Nemea::UnirecRecordView& unirecRecordView)
 			|| isWildcardRuleField(ruleField);
 	};
 
-	const bool isMatched = std::all_of(M_RULE_FIELDS.begin(), M_RULE_FIELDS.end(), lambdaPredicate);
-	if (isMatched) {
-		m_stats.matchedCount++;
-	}
-	return isMatched;
-}
-
-const RuleStats& Rule::getStats() const noexcept
-{
-	return m_stats;
+	return std::all_of(M_RULE_FIELDS.begin(), M_RULE_FIELDS.end(), lambdaPredicate);
 }
 
 const std::vector<RuleField>& Rule::getRuleFields() const noexcept
@@ -101,12 +92,18 @@ bool Rule::isRegexRuleField(const RuleField& ruleField) noexcept
 		&& std::holds_alternative<std::regex>(ruleField.second.value());
 }
 
+bool Rule::isIntervalRuleField(const RuleField& ruleField) noexcept
+{
+	return ruleField.second.has_value()
+		&& std::holds_alternative<NumericIntervals>(ruleField.second.value());
+}
+
 std::vector<bool> Rule::getPresentedStaticFieldsMask() const noexcept
 {
 	std::vector<bool> presentedFieldsMask;
 	for (const auto& ruleField : M_RULE_FIELDS) {
 		if (!Rule::isWildcardRuleField(ruleField) && !Rule::isRegexRuleField(ruleField)
-			&& !Rule::isIPRuleField(ruleField)) {
+			&& !Rule::isIPRuleField(ruleField) && !Rule::isIntervalRuleField(ruleField)) {
 			presentedFieldsMask.push_back(true);
 		} else {
 			presentedFieldsMask.push_back(false);
@@ -9,8 +9,10 @@
 
 #pragma once
 
+#include "counter/counter.hpp"
+#include "ip/ipAddressPrefix.hpp"
 #include "ipAddressFieldMatcher.hpp"
-#include "ipAddressPrefix.hpp"
+#include "numericInterval.hpp"
 
 #include <cstdint>
 #include <memory>
@@ -27,7 +29,7 @@ namespace ListDetector {
  * @brief Stores statistics about a rule.
  */
 struct RuleStats {
-	uint64_t matchedCount; /**< Number of times the rule has been matched. */
+	Nm::Counter matchedCount; /**< Number of times the rule has been matched. */
 };
 
 /**
@@ -45,7 +47,8 @@ using RuleFieldValue = std::variant<
 	int64_t,
 	std::string,
 	std::regex,
-	IpAddressPrefix>;
+	Nm::IpAddressPrefix,
+	NumericIntervals>;
 
 /**
  * @brief Represents a field in a rule.
@@ -72,13 +75,7 @@ public:
 	 * @param unirecRecordView The Unirec record which is tried to match.
 	 * @return True if matched, false otherwise.
 	 */
-	bool dynamicFieldsMatch(const Nemea::UnirecRecordView& unirecRecordView);
-
-	/**
-	 * @brief Gets the statistics for this rule.
-	 * @return A constant reference to the RuleStats structure.
-	 */
-	const RuleStats& getStats() const noexcept;
+	bool dynamicFieldsMatch(const Nemea::UnirecRecordView& unirecRecordView) const;
 
 	/**
 	 * @brief Checks if the given RuleField keeps static Unirec type.
@@ -108,6 +105,13 @@ public:
 	 */
 	static bool isIPRuleField(const RuleField& ruleField) noexcept;
 
+	/**
+	 * @brief Checks if the given RuleField represents range or set of integer values.
+	 * @param ruleField The RuleField to check.
+	 * @return True if kept value is range or set, false otherwise.
+	 */
+	static bool isIntervalRuleField(const RuleField& ruleField) noexcept;
+
 	/**
 	 * @brief Checks if the given RuleField represents string - normal string or regular expression.
 	 * @param ruleField The RuleField to check.
@@ -123,15 +127,13 @@ public:
 
 	/**
 	 * @brief Calculates presented static fields mask.
-	 * @return Bitset where presented static fields are set to true, regex, IP address or wildcard
-	 * fields are set to false.
+	 * @return Bitset where presented static fields are set to true, regex, IP address, interval or
+	 * wildcard fields are set to false.
 	 */
 	std::vector<bool> getPresentedStaticFieldsMask() const noexcept;
 
 private:
 	const std::vector<RuleField> M_RULE_FIELDS;
-
-	RuleStats m_stats {};
 };
 
 } // namespace ListDetector
@@ -13,6 +13,7 @@
 #include <regex>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
 
 namespace ListDetector {
 
@@ -31,7 +32,76 @@ static std::optional<T> convertStringToType(const std::string& str)
 	throw std::runtime_error("convertStringToType() has failed");
 }
 
-static std::optional<IpAddressPrefix> convertStringToIpAddressPrefix(const std::string& ipStr)
+template <typename T>
+static T convertStringToValue(std::string_view str)
+{
+	T value;
+	const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+	if (ec != std::errc {} || ptr != str.data() + str.size()) {
+		throw std::runtime_error("convertStringToValue() has failed");
+	}
+	return value;
+}
+
+static std::string_view trimSpaces(std::string_view str)
+{
+	const size_t first = str.find_first_not_of(' ');
+	if (first == std::string_view::npos) {
+		return {};
+	}
+	return str.substr(first, str.find_last_not_of(' ') - first + 1);
+}
+
+static bool isIntervalDescription(const std::string& str)
+{
+	// First character is skipped, it can be a minus sign of the lower bound
+	return (!str.empty() && str.front() == '{') || str.find('-', 1) != std::string::npos;
+}
+
+template <typename T>
+static NumericInterval convertStringToInterval(std::string_view str)
+{
+	const size_t delimiterPosition = str.find('-', 1);
+	if (delimiterPosition == std::string_view::npos) {
+		const auto value = convertStringToValue<T>(str);
+		return {toIntervalKey(value), toIntervalKey(value)};
+	}
+
+	const auto low = convertStringToValue<T>(trimSpaces(str.substr(0, delimiterPosition)));
+	const auto high = convertStringToValue<T>(trimSpaces(str.substr(delimiterPosition + 1)));
+	if (low > high) {
+		throw std::runtime_error("convertStringToInterval() has failed, empty range");
+	}
+	return {toIntervalKey(low), toIntervalKey(high)};
+}
+
+template <typename T>
+static NumericIntervals convertStringToIntervals(const std::string& str)
+{
+	if (str.front() != '{') {
+		return {convertStringToInterval<T>(str)};
+	}
+
+	if (str.back() != '}') {
+		throw std::runtime_error("convertStringToIntervals() has failed, missing '}'");
+	}
+
+	NumericIntervals intervals;
+	const std::string_view items(str.data() + 1, str.size() - 2);
+	size_t itemStart = 0;
+	while (itemStart <= items.size()) {
+		size_t itemEnd = items.find(',', itemStart);
+		if (itemEnd == std::string_view::npos) {
+			itemEnd = items.size();
+		}
+		intervals.push_back(
+			convertStringToInterval<T>(trimSpaces(items.substr(itemStart, itemEnd - itemStart))));
+		itemStart = itemEnd + 1;
+	}
+	return intervals;
+}
+
+static std::optional<Nm::IpAddressPrefix> convertStringToIpAddressPrefix(const std::string& ipStr)
 {
 	if (ipStr.empty()) {
 		return std::nullopt;
@@ -52,9 +122,9 @@ static std::optional<IpAddressPrefix> convertStringToIpAddressPrefix(const std::
 	size_t prefixNumber;
 	if (prefixPart.empty()) {
 		if (ipAddress.isIpv4()) {
-			prefixNumber = IpAddressPrefix::IPV4_MAX_PREFIX;
+			prefixNumber = Nm::IpAddressPrefix::IPV4_MAX_PREFIX;
 		} else {
-			prefixNumber = IpAddressPrefix::IPV6_MAX_PREFIX;
+			prefixNumber = Nm::IpAddressPrefix::IPV6_MAX_PREFIX;
 		}
 	} else {
 		if (std::from_chars(prefixPart.data(), prefixPart.data() + prefixPart.size(), prefixNumber)
@@ -63,7 +133,7 @@ static std::optional<IpAddressPrefix> convertStringToIpAddressPrefix(const std::
 			throw std::runtime_error("convertStringToIpAddressPrefix() has failed");
 		}
 	}
-	return IpAddressPrefix(ipAddress, prefixNumber);
+	return Nm::IpAddressPrefix(ipAddress, prefixNumber);
 }
 
 RuleBuilder::RuleBuilder(const std::string& unirecTemplateDescription)
@@ -71,6 +141,8 @@ RuleBuilder::RuleBuilder(const std::string& unirecTemplateDescription)
 	extractUnirecFieldsId(unirecTemplateDescription);
 	m_ipAddressFieldMatchers
 		= std::make_shared<std::unordered_map<ur_field_id_t, IpAddressFieldMatcher>>();
+	m_intervalFieldMatchers
+		= std::make_shared<std::unordered_map<ur_field_id_t, IntervalFieldMatcher>>();
 }
 
 void RuleBuilder::extractUnirecFieldsId(const std::string& unirecTemplateDescription)
@@ -86,6 +158,9 @@ void RuleBuilder::extractUnirecFieldsId(const std::string& unirecTemplateDescrip
 			const int fieldId = ur_get_id_by_name(fieldName.c_str());
 			validateUnirecFieldId(fieldName, fieldId);
 			m_unirecFieldsId.emplace_back(fieldId);
+			if (ur_get_type(m_unirecFieldsId.back()) == UR_TYPE_IP) {
+				m_ipFieldsId.emplace_back(m_unirecFieldsId.back());
+			}
 		}
 	}
 }
@@ -100,17 +175,73 @@ void RuleBuilder::validateUnirecFieldId(const std::string& fieldName, int unirec
 
 Rule RuleBuilder::build(const ConfigParser::RuleDescription& ruleDescription)
 {
-	std::vector<RuleField> ruleFields;
+	Rule rule = parse(ruleDescription);
+	add(rule);
+	return rule;
+}
+
+Rule RuleBuilder::parse(const ConfigParser::RuleDescription& ruleDescription) const
+{
+	if (ruleDescription.size() != m_unirecFieldsId.size()) {
+		m_logger->error(
+			"Rule has invalid number of columns. Expected {} columns, got {} columns.",
+			m_unirecFieldsId.size(),
+			ruleDescription.size());
+		throw std::runtime_error("RuleBuilder::parse() has failed");
+	}
 
+	std::vector<RuleField> ruleFields;
 	for (const auto& fieldValue : ruleDescription) {
-		auto ruleField = createRuleField(fieldValue, m_unirecFieldsId.at(ruleFields.size()));
-		ruleFields.emplace_back(ruleField);
+		ruleFields.emplace_back(createRuleField(fieldValue, m_unirecFieldsId[ruleFields.size()]));
 	}
+	return Rule {std::move(ruleFields)};
+}
 
-	return Rule {ruleFields};
+void RuleBuilder::add(const Rule& rule)
+{
+	for (const auto& ruleField : rule.getRuleFields()) {
+		const auto& [fieldId, fieldValue] = ruleField;
+		if (Rule::isIPRuleField(ruleField)) {
+			if (isIpTupleSpaceClassified()) {
+				continue;
+			}
+			if (fieldValue.has_value()) {
+				(*m_ipAddressFieldMatchers)[fieldId].addPrefix(
+					std::get<Nm::IpAddressPrefix>(*fieldValue));
+			} else {
+				(*m_ipAddressFieldMatchers)[fieldId].addEmptyPrefix();
+			}
+		} else if (Rule::isIntervalRuleField(ruleField)) {
+			(*m_intervalFieldMatchers)[fieldId].addIntervals(
+				m_builtRulesCount,
+				std::get<NumericIntervals>(*fieldValue));
+		}
+	}
+
+	m_builtRulesCount++;
 }
 
-RuleField RuleBuilder::createRuleField(const std::string& fieldValue, ur_field_id_t fieldId)
+template <typename T>
+RuleField
+RuleBuilder::createIntegerRuleField(const std::string& fieldValue, ur_field_id_t fieldId) const
+{
+	if (!isIntervalDescription(fieldValue)) {
+		return std::make_pair(fieldId, convertStringToType<T>(fieldValue));
+	}
+
+	try {
+		return std::make_pair(fieldId, convertStringToIntervals<T>(fieldValue));
+	} catch (const std::exception& ex) {
+		m_logger->error(
+			"Invalid range or set '{}' of field '{}': {}",
+			fieldValue,
+			ur_get_name(fieldId),
+			ex.what());
+		throw std::runtime_error("RuleBuilder::createIntegerRuleField() has failed");
+	}
+}
+
+RuleField RuleBuilder::createRuleField(const std::string& fieldValue, ur_field_id_t fieldId) const
 {
 	const ur_field_type_t unirecFieldType = ur_get_type(fieldId);
 	validateUnirecFieldType(fieldValue, unirecFieldType);
@@ -130,30 +261,23 @@ RuleField RuleBuilder::createRuleField(const std::string& fieldValue, ur_field_i
 	case UR_TYPE_CHAR:
 		return std::make_pair(fieldId, convertStringToType<char>(fieldValue));
 	case UR_TYPE_UINT8:
-		return std::make_pair(fieldId, convertStringToType<uint8_t>(fieldValue));
+		return createIntegerRuleField<uint8_t>(fieldValue, fieldId);
 	case UR_TYPE_INT8:
-		return std::make_pair(fieldId, convertStringToType<int8_t>(fieldValue));
+		return createIntegerRuleField<int8_t>(fieldValue, fieldId);
 	case UR_TYPE_UINT16:
-		return std::make_pair(fieldId, convertStringToType<uint16_t>(fieldValue));
+		return createIntegerRuleField<uint16_t>(fieldValue, fieldId);
 	case UR_TYPE_INT16:
-		return std::make_pair(fieldId, convertStringToType<int16_t>(fieldValue));
+		return createIntegerRuleField<int16_t>(fieldValue, fieldId);
 	case UR_TYPE_UINT32:
-		return std::make_pair(fieldId, convertStringToType<uint32_t>(fieldValue));
+		return createIntegerRuleField<uint32_t>(fieldValue, fieldId);
 	case UR_TYPE_INT32:
-		return std::make_pair(fieldId, convertStringToType<int32_t>(fieldValue));
+		return createIntegerRuleField<int32_t>(fieldValue, fieldId);
 	case UR_TYPE_UINT64:
-		return std::make_pair(fieldId, convertStringToType<uint64_t>(fieldValue));
+		return createIntegerRuleField<uint64_t>(fieldValue, fieldId);
 	case UR_TYPE_INT64:
-		return std::make_pair(fieldId, convertStringToType<int64_t>(fieldValue));
-	case UR_TYPE_IP: {
-		auto ruleField = std::make_pair(fieldId, convertStringToIpAddressPrefix(fieldValue));
-		if (ruleField.second.has_value()) {
-			(*m_ipAddressFieldMatchers)[fieldId].addPrefix(ruleField.second.value());
-		} else {
-			(*m_ipAddressFieldMatchers)[fieldId].addEmptyPrefix();
-		}
-		return ruleField;
-	}
+		return createIntegerRuleField<int64_t>(fieldValue, fieldId);
+	case UR_TYPE_IP:
+		return std::make_pair(fieldId, convertStringToIpAddressPrefix(fieldValue));
 	default:
 		m_logger->error("Unsopported unirec data type for field '{}'", ur_get_name(fieldId));
 		throw std::runtime_error("RuleBuilder::createRuleField has failed");
@@ -161,6 +285,7 @@ RuleField RuleBuilder::createRuleField(const std::string& fieldValue, ur_field_i
 }
 
 void RuleBuilder::validateUnirecFieldType(const std::string& fieldTypeString, int unirecFieldType)
+	const
 {
 	if (unirecFieldType == UR_E_INVALID_TYPE) {
 		m_logger->error("Invalid unirec field type '{}' in unirec template", fieldTypeString);
@@ -168,10 +293,26 @@ void RuleBuilder::validateUnirecFieldType(const std::string& fieldTypeString, in
 	}
 }
 
+bool RuleBuilder::isIpTupleSpaceClassified() const noexcept
+{
+	return m_ipFieldsId.size() > 1;
+}
+
+const std::vector<ur_field_id_t>& RuleBuilder::getIpFieldsId() const noexcept
+{
+	return m_ipFieldsId;
+}
+
 std::shared_ptr<std::unordered_map<ur_field_id_t, IpAddressFieldMatcher>>
 RuleBuilder::getIpAddressFieldMatchers() const noexcept
 {
 	return m_ipAddressFieldMatchers;
 }
 
+std::shared_ptr<std::unordered_map<ur_field_id_t, IntervalFieldMatcher>>
+RuleBuilder::getIntervalFieldMatchers() const noexcept
+{
+	return m_intervalFieldMatchers;
+}
+
 } // namespace ListDetector
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "configParser.hpp"
+#include "intervalFieldMatcher.hpp"
 #include "logger/logger.hpp"
 #include "rule.hpp"
 
@@ -32,32 +33,86 @@ public:
 	explicit RuleBuilder(const std::string& unirecTemplateDescription);
 
 	/**
-	 * @brief Builds a Rule based on the given rule description.
+	 * @brief Builds a Rule based on the given rule description and adds it to the field matchers.
 	 * @param ruleDescription The description of the rule.
 	 * @return Constructed Rule.
 	 */
 	Rule build(const ConfigParser::RuleDescription& ruleDescription);
 
+	/**
+	 * @brief Converts the rule description to a Rule without adding it to the field matchers.
+	 *
+	 * The builder is not modified, so descriptions can be parsed by several threads at once.
+	 *
+	 * @param ruleDescription The description of the rule.
+	 * @return Constructed Rule.
+	 * @throw std::runtime_error If the description is not valid.
+	 */
+	Rule parse(const ConfigParser::RuleDescription& ruleDescription) const;
+
+	/**
+	 * @brief Adds the parsed rule to the field matchers as the next rule.
+	 * @param rule Rule returned by `parse()`.
+	 */
+	void add(const Rule& rule);
+
+	/**
+	 * @brief Checks if the IP fields are matched together by the IpTupleSpaceClassifier.
+	 *
+	 * Several IP fields are classified together, so the per-field IP address matchers are not
+	 * built for them.
+	 *
+	 * @return True if the Unirec template has more than one IP field, false otherwise.
+	 */
+	bool isIpTupleSpaceClassified() const noexcept;
+
+	/**
+	 * @brief Getter for ids of the IP fields of the Unirec template.
+	 * @return Ids of the IP fields in the order of the template.
+	 */
+	const std::vector<ur_field_id_t>& getIpFieldsId() const noexcept;
+
 	/**
 	 * @brief Getter for IP address field matchers.
+	 *
+	 * The map is empty if `isIpTupleSpaceClassified()` is true.
+	 *
 	 * @return Shared pointer to unordered map of IP address field matcher, where id of Unirec field
 	 * is a key.
 	 */
 	std::shared_ptr<std::unordered_map<ur_field_id_t, IpAddressFieldMatcher>>
 	getIpAddressFieldMatchers() const noexcept;
 
+	/**
+	 * @brief Getter for interval field matchers.
+	 *
+	 * Matchers are not built, `IntervalFieldMatcher::build()` must be called once all rules are
+	 * built.
+	 *
+	 * @return Shared pointer to unordered map of interval field matchers, where id of Unirec field
+	 * is a key.
+	 */
+	std::shared_ptr<std::unordered_map<ur_field_id_t, IntervalFieldMatcher>>
+	getIntervalFieldMatchers() const noexcept;
+
 private:
 	void extractUnirecFieldsId(const std::string& unirecTemplateDescription);
 	void validateUnirecFieldId(const std::string& fieldName, int unirecFieldId);
-	void validateUnirecFieldType(const std::string& fieldTypeString, int unirecFieldType);
-	RuleField createRuleField(const std::string& fieldValue, ur_field_id_t fieldId);
+	void validateUnirecFieldType(const std::string& fieldTypeString, int unirecFieldType) const;
+	RuleField createRuleField(const std::string& fieldValue, ur_field_id_t fieldId) const;
+	template <typename T>
+	RuleField createIntegerRuleField(const std::string& fieldValue, ur_field_id_t fieldId) const;
 
 	std::vector<ur_field_id_t> m_unirecFieldsId;
+	std::vector<ur_field_id_t> m_ipFieldsId;
+	uint32_t m_builtRulesCount = 0;
 
 	std::shared_ptr<spdlog::logger> m_logger = Nm::loggerGet("RuleBuilder");
 
 	std::shared_ptr<std::unordered_map<ur_field_id_t, IpAddressFieldMatcher>>
 		m_ipAddressFieldMatchers;
+	std::shared_ptr<std::unordered_map<ur_field_id_t, IntervalFieldMatcher>>
+		m_intervalFieldMatchers;
 };
 
 } // namespace ListDetector
@@ -7,49 +7,252 @@
  */
 
 #include "rulesMatcher.hpp"
+#include "instrumentation/timer.hpp"
 #include "ruleBuilder.hpp"
 
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
 namespace ListDetector {
 
-RulesMatcher::RulesMatcher(const ConfigParser* configParser) noexcept
+static uint64_t
+getIntervalKey(const Nemea::UnirecRecordView& unirecRecordView, ur_field_id_t fieldId)
+{
+	switch (ur_get_type(fieldId)) {
+	case UR_TYPE_UINT8:
+		return toIntervalKey(unirecRecordView.getFieldAsType<uint8_t>(fieldId));
+	case UR_TYPE_INT8:
+		return toIntervalKey(unirecRecordView.getFieldAsType<int8_t>(fieldId));
+	case UR_TYPE_UINT16:
+		return toIntervalKey(unirecRecordView.getFieldAsType<uint16_t>(fieldId));
+	case UR_TYPE_INT16:
+		return toIntervalKey(unirecRecordView.getFieldAsType<int16_t>(fieldId));
+	case UR_TYPE_UINT32:
+		return toIntervalKey(unirecRecordView.getFieldAsType<uint32_t>(fieldId));
+	case UR_TYPE_INT32:
+		return toIntervalKey(unirecRecordView.getFieldAsType<int32_t>(fieldId));
+	case UR_TYPE_UINT64:
+		return toIntervalKey(unirecRecordView.getFieldAsType<uint64_t>(fieldId));
+	case UR_TYPE_INT64:
+		return toIntervalKey(unirecRecordView.getFieldAsType<int64_t>(fieldId));
+	default:
+		throw std::invalid_argument(
+			std::string("Given field id ") + std::to_string(fieldId) + " is not an integer field");
+	}
+}
+
+RulesMatcher::RulesMatcher(const ConfigParser* configParser, bool usePrefilter)
 {
 	const std::string unirecTemplateDescription = configParser->getUnirecTemplateDescription();
 
 	RuleBuilder ruleBuilder(unirecTemplateDescription);
-
-	for (const auto& ruleDescription : configParser->getRulesDescription()) {
-		auto rule = ruleBuilder.build(ruleDescription);
-		m_rules.emplace_back(rule);
-	}
+	m_rules = configParser->buildRules(ruleBuilder);
 
 	m_ipAddressFieldMatchers = ruleBuilder.getIpAddressFieldMatchers();
+	m_intervalFieldMatchers = ruleBuilder.getIntervalFieldMatchers();
+	for (auto& [fieldId, intervalMatcher] : *m_intervalFieldMatchers) {
+		intervalMatcher.build(m_rules.size());
+	}
 	m_fieldsMatcher = std::make_unique<FieldsMatcher>(m_rules);
+	m_fieldsMatcher->countMaskGroupsCandidates(
+		std::vector<bool>(m_rules.size(), true),
+		m_maskGroupsRulesCounts);
+
+	// Initial plan evaluates IP fields first, then interval fields
+	if (ruleBuilder.isIpTupleSpaceClassified()) {
+		// Several IP fields are matched together, so selective pairs do not cost a tree walk
+		// and a full rule mask per field, and no per-field matcher is built for them
+		m_ipTupleSpaceClassifier
+			= std::make_unique<IpTupleSpaceClassifier>(ruleBuilder.getIpFieldsId(), m_rules);
+		m_filterStages.push_back({0, nullptr, nullptr, m_ipTupleSpaceClassifier.get()});
+	} else {
+		for (const auto& [fieldId, ipAddressMatcher] : *m_ipAddressFieldMatchers) {
+			m_filterStages.push_back({fieldId, &ipAddressMatcher, nullptr, nullptr});
+		}
+	}
+	for (const auto& [fieldId, intervalMatcher] : *m_intervalFieldMatchers) {
+		m_filterStages.push_back({fieldId, nullptr, &intervalMatcher, nullptr});
+	}
+
+	if (usePrefilter) {
+		m_prefilter = std::make_unique<RulesPrefilter>(m_rules, *m_fieldsMatcher);
+		if (!m_prefilter->isUsable()) {
+			m_prefilter.reset();
+		}
+	}
+}
+
+std::vector<bool> RulesMatcher::evaluateFilterStage(
+	const FilterStage& filterStage,
+	const Nemea::UnirecRecordView& unirecRecordView,
+	const std::vector<bool>& previouslyMatchedRulesMask)
+{
+	if (filterStage.ipTupleSpaceClassifier != nullptr) {
+		return filterStage.ipTupleSpaceClassifier->getMatchingRulesMask(
+			unirecRecordView,
+			previouslyMatchedRulesMask);
+	}
+	if (filterStage.ipAddressFieldMatcher != nullptr) {
+		const auto& ipAddress
+			= unirecRecordView.getFieldAsType<Nemea::IpAddress>(filterStage.fieldId);
+		return filterStage.ipAddressFieldMatcher->getMatchingIpRulesMask(
+			ipAddress,
+			previouslyMatchedRulesMask);
+	}
+	return filterStage.intervalFieldMatcher->getMatchingRulesMask(
+		getIntervalKey(unirecRecordView, filterStage.fieldId),
+		previouslyMatchedRulesMask);
+}
+
+std::optional<size_t> RulesMatcher::getMatchingRuleIndex(
+	const Nemea::UnirecRecordView& unirecRecordView,
+	MatchingContext& context) const
+{
+	EvaluationPlanner& planner = context.evaluationPlanner;
+	const bool updateFilterStagesStats = planner.nextRecord();
+
+	std::vector<bool> matchingRulesMask(m_rules.size(), true);
+	uint64_t candidatesCount = m_rules.size();
+
+	for (const size_t stageIndex : planner.getFilterStagesOrder()) {
+		const uint64_t stageStart = updateFilterStagesStats ? Nm::InstrumentationClock::now() : 0;
+		matchingRulesMask
+			= evaluateFilterStage(m_filterStages[stageIndex], unirecRecordView, matchingRulesMask);
+
+		bool hasCandidate;
+		if (updateFilterStagesStats) {
+			FilterStageStats& stats = planner.getFilterStageStats(stageIndex);
+			stats.sampledTime.add(Nm::InstrumentationClock::now() - stageStart);
+			stats.sampledCount.add();
+			const auto outputCandidatesCount = static_cast<uint64_t>(
+				std::count(matchingRulesMask.begin(), matchingRulesMask.end(), true));
+			stats.inputCandidatesCount.add(candidatesCount);
+			stats.outputCandidatesCount.add(outputCandidatesCount);
+			candidatesCount = outputCandidatesCount;
+			hasCandidate = candidatesCount != 0;
+		} else {
+			hasCandidate = std::find(matchingRulesMask.begin(), matchingRulesMask.end(), true)
+				!= matchingRulesMask.end();
+		}
+
+		if (!hasCandidate) {
+			planner.countEarlyExit();
+			return std::nullopt;
+		}
+	}
+
+	// Without filter stages all rules of every mask group are candidates
+	const std::vector<uint32_t>* maskGroupsCandidatesCounts = &m_maskGroupsRulesCounts;
+	if (!m_filterStages.empty()) {
+		m_fieldsMatcher->countMaskGroupsCandidates(
+			matchingRulesMask,
+			context.maskGroupsCandidatesCounts);
+		maskGroupsCandidatesCounts = &context.maskGroupsCandidatesCounts;
+	}
+
+	return m_fieldsMatcher->getMatchingRuleIndex(
+		unirecRecordView,
+		matchingRulesMask,
+		*maskGroupsCandidatesCounts,
+		planner,
+		context.hashState.get(),
+		context.rulesProfiler.get());
 }
 
-std::vector<bool>
-RulesMatcher::getMatchingIpRulesMask(const Nemea::UnirecRecordView& unirecRecordView)
+bool RulesMatcher::anyOfRuleMatches(
+	const Nemea::UnirecRecordView& unirecRecordView,
+	MatchingContext& context) const
 {
-	std::vector<bool> previouslyMatchedRulesMask(m_rules.size(), true);
+	if (m_prefilter) {
+		if (!m_prefilter->mayMatch(unirecRecordView, context.hashState.get())) {
+			context.prefilterStats.rejectedCount.add();
+			return false;
+		}
+		context.prefilterStats.passedCount.add();
+	}
 
-	for (auto& [fieldId, ipAddressMatcher] : *m_ipAddressFieldMatchers) {
-		const auto& ipAddress = unirecRecordView.getFieldAsType<Nemea::IpAddress>(fieldId);
-		auto matchingRulesMask
-			= ipAddressMatcher.getMatchingIpRulesMask(ipAddress, previouslyMatchedRulesMask);
-		previouslyMatchedRulesMask = std::move(matchingRulesMask);
+	std::optional<size_t> ruleIndex;
+
+	if (context.verdictCache) {
+		std::vector<std::byte>& cacheKey = context.verdictCacheKey;
+		m_fieldsMatcher->packRuleFields(unirecRecordView, cacheKey);
+		if (const auto verdict = context.verdictCache->find(cacheKey); verdict.has_value()) {
+			if (*verdict != VerdictCache::NO_MATCH) {
+				ruleIndex = *verdict;
+			}
+		} else {
+			ruleIndex = getMatchingRuleIndex(unirecRecordView, context);
+			context.verdictCache->insert(
+				cacheKey,
+				ruleIndex.has_value() ? static_cast<uint32_t>(*ruleIndex)
+									  : VerdictCache::NO_MATCH);
+		}
+	} else {
+		ruleIndex = getMatchingRuleIndex(unirecRecordView, context);
 	}
 
-	return previouslyMatchedRulesMask;
+	if (!ruleIndex.has_value()) {
+		if (m_prefilter) {
+			context.prefilterStats.falsePositiveCount.add();
+		}
+		return false;
+	}
+
+	context.rulesStats[*ruleIndex].matchedCount.add();
+	return true;
 }
 
-bool RulesMatcher::anyOfRuleMatches(const Nemea::UnirecRecordView& unirecRecordView)
+MatchingContext
+RulesMatcher::createMatchingContext(size_t verdictCacheSize, bool profileRules) const
 {
-	auto matchingIpRulesMask = getMatchingIpRulesMask(unirecRecordView);
-	return m_fieldsMatcher->anyOfRulesMatch(unirecRecordView, matchingIpRulesMask);
+	MatchingContext context;
+	context.rulesStats.resize(m_rules.size());
+	context.hashState = FieldsMatcher::createHashState();
+	if (verdictCacheSize != 0) {
+		context.verdictCache = std::make_unique<VerdictCache>(
+			verdictCacheSize,
+			m_fieldsMatcher->getPackedRuleFieldsSize(VerdictCache::MAX_STRING_LENGTH));
+	}
+
+	context.evaluationPlanner
+		= EvaluationPlanner(m_filterStages.size(), m_fieldsMatcher->getMaskGroupsCount());
+	if (profileRules) {
+		context.rulesProfiler = std::make_unique<RulesProfiler>(
+			m_rules.size(),
+			m_fieldsMatcher->getMaskGroupsCount());
+	}
+	return context;
 }
 
-std::vector<Rule>& RulesMatcher::getRules() noexcept
+const std::vector<Rule>& RulesMatcher::getRules() const noexcept
 {
 	return m_rules;
 }
 
+bool RulesMatcher::hasPrefilter() const noexcept
+{
+	return m_prefilter != nullptr;
+}
+
+std::vector<std::string> RulesMatcher::getFilterStagesNames() const
+{
+	std::vector<std::string> filterStagesNames;
+	std::transform(
+		m_filterStages.begin(),
+		m_filterStages.end(),
+		std::back_inserter(filterStagesNames),
+		[](const FilterStage& filterStage) {
+			if (filterStage.ipTupleSpaceClassifier == nullptr) {
+				return std::string(ur_get_name(filterStage.fieldId));
+			}
+			std::string name;
+			for (const auto fieldId : filterStage.ipTupleSpaceClassifier->getFieldIds()) {
+				name += (name.empty() ? "" : "+") + std::string(ur_get_name(fieldId));
+			}
+			return name;
+		});
+	return filterStagesNames;
+}
+
 } // namespace ListDetector
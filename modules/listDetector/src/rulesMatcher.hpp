@@ -9,10 +9,36 @@
 #pragma once
 
 #include "configParser.hpp"
+#include "evaluationPlanner.hpp"
 #include "fieldsMatcher.hpp"
+#include "intervalFieldMatcher.hpp"
+#include "ipTupleSpaceClassifier.hpp"
+#include "rulesPrefilter.hpp"
+#include "verdictCache.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
 
 namespace ListDetector {
 
+/**
+ * @brief Mutable state used by RulesMatcher while matching records.
+ *
+ * Matching itself does not modify the RulesMatcher, so each thread that matches records
+ * keeps its own context and the rules statistics are merged on read.
+ */
+struct MatchingContext {
+	std::vector<RuleStats> rulesStats; ///< Statistics of rules, indexed by rule index.
+	HashState hashState {nullptr, XXH3_freeState}; ///< State of the hash of record fields.
+	std::unique_ptr<VerdictCache> verdictCache; ///< Cache of verdicts, nullptr if disabled.
+	std::vector<std::byte> verdictCacheKey; ///< Packed rule fields of the record for the cache.
+	std::vector<uint32_t> maskGroupsCandidatesCounts; ///< Candidate rules of each mask group.
+	EvaluationPlanner evaluationPlanner; ///< Order of matching stages and their statistics.
+	PrefilterStats prefilterStats; ///< Statistics of the prefilter.
+	std::unique_ptr<RulesProfiler> rulesProfiler; ///< Cost of rules, nullptr if disabled.
+};
+
 /**
  * @brief RulesMatcher class to match unirec records against prefix IP trees and rule hashes.
  */
@@ -21,30 +47,79 @@ public:
 	/**
 	 * @brief Constructor for a RulesMatcher.
 	 * @param configParser pointer to config parser.
+	 * @param usePrefilter True to screen records by the prefilter before full matching.
+	 * @throw std::runtime_error If some rule can not be built.
 	 */
-	explicit RulesMatcher(const ConfigParser* configParser) noexcept;
+	explicit RulesMatcher(const ConfigParser* configParser, bool usePrefilter = false);
 
 	/**
 	 * @brief Checks if some rule matches given Unirec view.
 	 * @param unirecRecordView The Unirec view to match.
+	 * @param context Matching context of the calling thread.
 	 * @return True if some rule matched, false otherwise.
 	 */
-	bool anyOfRuleMatches(const Nemea::UnirecRecordView& unirecRecordView);
+	bool anyOfRuleMatches(
+		const Nemea::UnirecRecordView& unirecRecordView,
+		MatchingContext& context) const;
+
+	/**
+	 * @brief Creates a new matching context for the kept rules.
+	 * @param verdictCacheSize Number of verdicts cached by the context, 0 disables the cache.
+	 * @param profileRules True to collect the matching cost of rules.
+	 * @return Matching context with zeroed rules statistics.
+	 */
+	MatchingContext
+	createMatchingContext(size_t verdictCacheSize = 0, bool profileRules = false) const;
 
 	/**
 	 * @brief Getter for kept rules.
 	 * @return Vector of rules.
 	 */
-	std::vector<Rule>& getRules() noexcept;
+	const std::vector<Rule>& getRules() const noexcept;
+
+	/**
+	 * @brief Returns names of the filter stages, indexed by the stage index.
+	 *
+	 * Each interval field used by rules is one filter stage named by the field. IP fields are one
+	 * stage each, or a single stage named by all IP fields joined by `+` if there are several.
+	 *
+	 * @return Names of the filter stages.
+	 */
+	std::vector<std::string> getFilterStagesNames() const;
+
+	/**
+	 * @brief Checks if records are screened by the prefilter.
+	 * @return True if the prefilter was requested and can be used for the rules.
+	 */
+	bool hasPrefilter() const noexcept;
 
 private:
-	std::vector<bool> getMatchingIpRulesMask(const Nemea::UnirecRecordView& unirecRecordView);
+	struct FilterStage {
+		ur_field_id_t fieldId;
+		const IpAddressFieldMatcher* ipAddressFieldMatcher;
+		const IntervalFieldMatcher* intervalFieldMatcher;
+		const IpTupleSpaceClassifier* ipTupleSpaceClassifier;
+	};
+
+	std::optional<size_t> getMatchingRuleIndex(
+		const Nemea::UnirecRecordView& unirecRecordView,
+		MatchingContext& context) const;
+	static std::vector<bool> evaluateFilterStage(
+		const FilterStage& filterStage,
+		const Nemea::UnirecRecordView& unirecRecordView,
+		const std::vector<bool>& previouslyMatchedRulesMask);
 
 	std::vector<Rule> m_rules;
+	std::vector<FilterStage> m_filterStages;
+	std::vector<uint32_t> m_maskGroupsRulesCounts;
 
 	std::shared_ptr<std::unordered_map<ur_field_id_t, IpAddressFieldMatcher>>
 		m_ipAddressFieldMatchers;
+	std::shared_ptr<std::unordered_map<ur_field_id_t, IntervalFieldMatcher>>
+		m_intervalFieldMatchers;
+	std::unique_ptr<IpTupleSpaceClassifier> m_ipTupleSpaceClassifier;
 	std::unique_ptr<FieldsMatcher> m_fieldsMatcher;
+	std::unique_ptr<RulesPrefilter> m_prefilter;
 };
 
 } // namespace ListDetector
@@ -0,0 +1,126 @@
+/**
+ * @file
+ * @brief Implementation of the RulesPrefilter class rejecting records that can not match any
+ * rule.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "rulesPrefilter.hpp"
+
+#include "logger/logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <variant>
+
+namespace ListDetector {
+
+/**
+ * @brief Seed of static field keys, distinct from seeds of IP keys which are field ids.
+ */
+static const uint64_t g_STATIC_KEY_SEED = 1ULL << 32U;
+
+RulesPrefilter::RulesPrefilter(const std::vector<Rule>& rules, const FieldsMatcher& fieldsMatcher)
+	: m_fieldsMatcher(fieldsMatcher)
+	, m_filter(rules.size())
+{
+	for (size_t ruleIndex = 0; ruleIndex < rules.size(); ruleIndex++) {
+		const Nm::IpAddressPrefix* longestPrefix = nullptr;
+		ur_field_id_t longestPrefixFieldId = 0;
+		for (const auto& ruleField : rules[ruleIndex].getRuleFields()) {
+			if (!Rule::isIPRuleField(ruleField) || Rule::isWildcardRuleField(ruleField)) {
+				continue;
+			}
+			const auto& prefix = std::get<Nm::IpAddressPrefix>(*ruleField.second);
+			if (longestPrefix == nullptr || prefix.getLength() > longestPrefix->getLength()) {
+				longestPrefix = &prefix;
+				longestPrefixFieldId = ruleField.first;
+			}
+		}
+
+		if (longestPrefix != nullptr) {
+			addIpDimension(longestPrefixFieldId, longestPrefix->getMask());
+			m_filter.insert(calculateIpKey(longestPrefixFieldId, longestPrefix->getAddress()));
+			continue;
+		}
+
+		const size_t groupIndex = fieldsMatcher.getRuleMaskGroupIndex(ruleIndex);
+		if (fieldsMatcher.maskGroupHasStaticFields(groupIndex)) {
+			addMaskGroup(groupIndex);
+			m_filter.insert(
+				calculateStaticKey(groupIndex, fieldsMatcher.getRuleStaticHash(ruleIndex)));
+			continue;
+		}
+
+		Nm::loggerGet("RulesPrefilter")
+			->warn("Rule {} has no IP prefix or static field, prefilter is not used", ruleIndex);
+		m_isUsable = false;
+		return;
+	}
+}
+
+void RulesPrefilter::addIpDimension(ur_field_id_t fieldId, const Nemea::IpAddress& mask)
+{
+	const bool exists = std::any_of(
+		m_ipDimensions.begin(),
+		m_ipDimensions.end(),
+		[&](const IpDimension& dimension) {
+			return dimension.fieldId == fieldId
+				&& std::memcmp(&dimension.mask.ip, &mask.ip, sizeof(mask.ip)) == 0;
+		});
+	if (!exists) {
+		m_ipDimensions.push_back({fieldId, mask});
+	}
+}
+
+void RulesPrefilter::addMaskGroup(size_t groupIndex)
+{
+	if (std::find(m_maskGroupIndexes.begin(), m_maskGroupIndexes.end(), groupIndex)
+		== m_maskGroupIndexes.end()) {
+		m_maskGroupIndexes.emplace_back(groupIndex);
+	}
+}
+
+uint64_t
+RulesPrefilter::calculateIpKey(ur_field_id_t fieldId, const Nemea::IpAddress& network) noexcept
+{
+	return XXH3_64bits_withSeed(&network.ip, sizeof(network.ip), static_cast<uint64_t>(fieldId));
+}
+
+uint64_t RulesPrefilter::calculateStaticKey(size_t groupIndex, uint64_t staticHash) noexcept
+{
+	return XXH3_64bits_withSeed(&staticHash, sizeof(staticHash), g_STATIC_KEY_SEED + groupIndex);
+}
+
+bool RulesPrefilter::isUsable() const noexcept
+{
+	return m_isUsable;
+}
+
+bool RulesPrefilter::mayMatch(
+	const Nemea::UnirecRecordView& unirecRecordView,
+	XXH3_state_t* hashState) const
+{
+	for (const auto& [fieldId, mask] : m_ipDimensions) {
+		const auto address = unirecRecordView.getFieldAsType<Nemea::IpAddress>(fieldId);
+		if (address.isIpv4() != mask.isIpv4()) {
+			continue;
+		}
+		if (m_filter.mayContain(calculateIpKey(fieldId, address & mask))) {
+			return true;
+		}
+	}
+
+	for (const size_t groupIndex : m_maskGroupIndexes) {
+		const uint64_t staticHash
+			= m_fieldsMatcher.calculateMaskGroupHash(unirecRecordView, groupIndex, hashState);
+		if (m_filter.mayContain(calculateStaticKey(groupIndex, staticHash))) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+} // namespace ListDetector
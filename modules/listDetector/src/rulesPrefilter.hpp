@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief Declaration of the RulesPrefilter class rejecting records that can not match any rule.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "blockedBloomFilter.hpp"
+#include "counter/counter.hpp"
+#include "fieldsMatcher.hpp"
+#include "rule.hpp"
+
+#include <cstdint>
+#include <unirec++/ipAddress.hpp>
+#include <unirec++/unirec.hpp>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Statistics of the prefilter.
+ */
+struct PrefilterStats {
+	Nm::Counter rejectedCount; ///< Records rejected without full matching.
+	Nm::Counter passedCount; ///< Records passed to full matching.
+	Nm::Counter falsePositiveCount; ///< Passed records that did not match any rule.
+};
+
+/**
+ * @brief Bloom filter screening of records before full matching of rules.
+ *
+ * Each rule contributes one key that every matching record must produce: network address of its
+ * longest IP prefix, or hash of its static fields if the rule has no IP prefix. Records compute
+ * the keys of all used prefix masks and mask groups, and are rejected if none of the keys is in
+ * the filter. Rejected records certainly do not match any rule.
+ */
+class RulesPrefilter {
+public:
+	/**
+	 * @brief Builds the prefilter for the given rules.
+	 * @param rules Rules to screen records for.
+	 * @param fieldsMatcher Fields matcher of the rules used to hash static fields.
+	 */
+	RulesPrefilter(const std::vector<Rule>& rules, const FieldsMatcher& fieldsMatcher);
+
+	/**
+	 * @brief Checks if all rules can be screened by the prefilter.
+	 *
+	 * Rules without IP prefix and static field, e.g. rules with only ranges or regular
+	 * expressions, have no key, so the prefilter can not reject any record.
+	 *
+	 * @return True if the prefilter can be used, false otherwise.
+	 */
+	bool isUsable() const noexcept;
+
+	/**
+	 * @brief Checks if the record may match some rule.
+	 * @param unirecRecordView The Unirec record view to check.
+	 * @param hashState State of the streaming hash used for the static fields of the record.
+	 * @return False if the record certainly does not match any rule, true otherwise.
+	 */
+	bool mayMatch(const Nemea::UnirecRecordView& unirecRecordView, XXH3_state_t* hashState) const;
+
+private:
+	struct IpDimension {
+		ur_field_id_t fieldId;
+		Nemea::IpAddress mask;
+	};
+
+	void addIpDimension(ur_field_id_t fieldId, const Nemea::IpAddress& mask);
+	void addMaskGroup(size_t groupIndex);
+	static uint64_t calculateIpKey(ur_field_id_t fieldId, const Nemea::IpAddress& network) noexcept;
+	static uint64_t calculateStaticKey(size_t groupIndex, uint64_t staticHash) noexcept;
+
+	const FieldsMatcher& m_fieldsMatcher;
+	BlockedBloomFilter m_filter;
+	std::vector<IpDimension> m_ipDimensions;
+	std::vector<size_t> m_maskGroupIndexes;
+	bool m_isUsable = true;
+};
+
+} // namespace ListDetector
@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Implementation of the RulesProfiler class sampling the matching cost of rules and mask
+ * groups.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "rulesProfiler.hpp"
+
+#include <chrono>
+
+namespace ListDetector {
+
+RulesProfiler::RulesProfiler(size_t rulesCount, size_t maskGroupsCount)
+	: m_rulesProfiles(rulesCount)
+	, m_maskGroupsProfiles(maskGroupsCount)
+{
+}
+
+bool RulesProfiler::nextRecord() noexcept
+{
+	return m_recordsCount++ % SAMPLING_PERIOD == 0;
+}
+
+uint64_t RulesProfiler::now() noexcept
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+									 std::chrono::steady_clock::now().time_since_epoch())
+									 .count());
+}
+
+void RulesProfiler::countEvaluation(size_t ruleIndex) noexcept
+{
+	m_rulesProfiles[ruleIndex].evaluatedCount.add();
+}
+
+void RulesProfiler::addLookupSample(size_t groupIndex, uint64_t time) noexcept
+{
+	m_maskGroupsProfiles[groupIndex].sampledCount.add();
+	m_maskGroupsProfiles[groupIndex].sampledLookupTime.add(time);
+}
+
+void RulesProfiler::addEvaluationSample(size_t ruleIndex, size_t groupIndex, uint64_t time) noexcept
+{
+	m_rulesProfiles[ruleIndex].sampledCount.add();
+	m_rulesProfiles[ruleIndex].sampledTime.add(time);
+	m_maskGroupsProfiles[groupIndex].sampledMatchTime.add(time);
+}
+
+const std::vector<RuleProfile>& RulesProfiler::getRulesProfiles() const noexcept
+{
+	return m_rulesProfiles;
+}
+
+const std::vector<MaskGroupProfile>& RulesProfiler::getMaskGroupsProfiles() const noexcept
+{
+	return m_maskGroupsProfiles;
+}
+
+} // namespace ListDetector
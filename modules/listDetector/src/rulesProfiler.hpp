@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @brief Declaration of the RulesProfiler class sampling the matching cost of rules and mask
+ * groups.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "counter/counter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Profile of a rule.
+ */
+struct RuleProfile {
+	Nm::Counter evaluatedCount; ///< Candidate evaluations of the rule dynamic fields.
+	Nm::Counter sampledCount; ///< Evaluations of the rule in sampled records.
+	Nm::Counter sampledTime; ///< Time of the sampled evaluations in nanoseconds.
+};
+
+/**
+ * @brief Profile of a group of rules sharing the same set of static fields.
+ */
+struct MaskGroupProfile {
+	Nm::Counter sampledCount; ///< Sampled records where the group static fields were looked up.
+	Nm::Counter sampledLookupTime; ///< Time of hashing and lookups in sampled records in ns.
+	Nm::Counter sampledMatchTime; ///< Time of dynamic fields matching in sampled records in ns.
+};
+
+/**
+ * @brief Collects the matching cost of rules and mask groups of one matching context.
+ *
+ * Candidate evaluations are counted for every record, while the time is measured only for every
+ * `SAMPLING_PERIOD`-th record, so the profiling can stay enabled in production. Total time
+ * of a rule is estimated as its mean sampled time multiplied by its evaluations.
+ */
+class RulesProfiler {
+public:
+	/**
+	 * @brief Every n-th record is timed.
+	 */
+	static inline const uint64_t SAMPLING_PERIOD = 64;
+
+	/**
+	 * @brief Constructs the profiler with zeroed profiles.
+	 * @param rulesCount Number of rules.
+	 * @param maskGroupsCount Number of mask groups.
+	 */
+	RulesProfiler(size_t rulesCount, size_t maskGroupsCount);
+
+	/**
+	 * @brief Advances to the next record.
+	 * @return True if the record is timed.
+	 */
+	bool nextRecord() noexcept;
+
+	/**
+	 * @brief Returns current time of the monotonic clock in nanoseconds.
+	 */
+	static uint64_t now() noexcept;
+
+	/**
+	 * @brief Counts a candidate evaluation of the rule.
+	 * @param ruleIndex Index of the rule.
+	 */
+	void countEvaluation(size_t ruleIndex) noexcept;
+
+	/**
+	 * @brief Adds timed hashing and lookup of the mask group static fields.
+	 * @param groupIndex Index of the mask group.
+	 * @param time Elapsed time in nanoseconds.
+	 */
+	void addLookupSample(size_t groupIndex, uint64_t time) noexcept;
+
+	/**
+	 * @brief Adds timed evaluation of the rule dynamic fields.
+	 * @param ruleIndex Index of the rule.
+	 * @param groupIndex Index of the mask group of the rule.
+	 * @param time Elapsed time in nanoseconds.
+	 */
+	void addEvaluationSample(size_t ruleIndex, size_t groupIndex, uint64_t time) noexcept;
+
+	/**
+	 * @brief Returns profiles of the rules, indexed by rule index.
+	 */
+	const std::vector<RuleProfile>& getRulesProfiles() const noexcept;
+
+	/**
+	 * @brief Returns profiles of the mask groups, indexed by group index.
+	 */
+	const std::vector<MaskGroupProfile>& getMaskGroupsProfiles() const noexcept;
+
+private:
+	std::vector<RuleProfile> m_rulesProfiles;
+	std::vector<MaskGroupProfile> m_maskGroupsProfiles;
+	uint64_t m_recordsCount = 0;
+};
+
+} // namespace ListDetector
@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @brief Implementation of the VerdictCache class caching results of rules matching.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "verdictCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <xxhash.h>
+
+namespace ListDetector {
+
+static size_t getBucketsCount(size_t size)
+{
+	if (size == 0) {
+		throw std::invalid_argument("VerdictCache size must be higher than zero");
+	}
+
+	const size_t requiredBuckets = (size + VerdictCache::WAYS_PER_BUCKET - 1)
+		/ VerdictCache::WAYS_PER_BUCKET;
+	size_t bucketsCount = 1;
+	while (bucketsCount < requiredBuckets) {
+		bucketsCount <<= 1U;
+	}
+	return bucketsCount;
+}
+
+VerdictCache::VerdictCache(size_t size, size_t maxKeySize)
+	: m_buckets(getBucketsCount(size), Bucket {})
+	, M_BUCKET_MASK(m_buckets.size() - 1)
+	, M_MAX_KEY_SIZE(std::min<size_t>(maxKeySize, std::numeric_limits<KeyLength>::max()))
+	, M_KEY_SLOT_SIZE(sizeof(KeyLength) + M_MAX_KEY_SIZE)
+	, m_keys(m_buckets.size() * WAYS_PER_BUCKET * M_KEY_SLOT_SIZE)
+{
+}
+
+std::byte* VerdictCache::getKeySlot(size_t bucketIndex, size_t way) noexcept
+{
+	return m_keys.data() + (bucketIndex * WAYS_PER_BUCKET + way) * M_KEY_SLOT_SIZE;
+}
+
+void VerdictCache::storeKey(
+	size_t bucketIndex,
+	size_t way,
+	const std::vector<std::byte>& key) noexcept
+{
+	std::byte* slot = getKeySlot(bucketIndex, way);
+	const auto keyLength = static_cast<KeyLength>(key.size());
+	std::memcpy(slot, &keyLength, sizeof(keyLength));
+	std::memcpy(slot + sizeof(keyLength), key.data(), key.size());
+}
+
+bool VerdictCache::isKeyEqual(
+	size_t bucketIndex,
+	size_t way,
+	const std::vector<std::byte>& key) noexcept
+{
+	const std::byte* slot = getKeySlot(bucketIndex, way);
+	KeyLength keyLength;
+	std::memcpy(&keyLength, slot, sizeof(keyLength));
+	return keyLength == key.size()
+		&& std::memcmp(slot + sizeof(keyLength), key.data(), key.size()) == 0;
+}
+
+std::optional<uint32_t> VerdictCache::find(const std::vector<std::byte>& key) noexcept
+{
+	if (key.size() > M_MAX_KEY_SIZE) {
+		m_stats.misses.add();
+		return std::nullopt;
+	}
+
+	const uint64_t keyHash = XXH3_64bits(key.data(), key.size());
+	const size_t bucketIndex = keyHash & M_BUCKET_MASK;
+	const auto tag = static_cast<uint32_t>(keyHash >> 32U);
+	Bucket& bucket = m_buckets[bucketIndex];
+
+	for (size_t way = 0; way < WAYS_PER_BUCKET; way++) {
+		const auto wayBit = static_cast<uint8_t>(1U << way);
+		if ((bucket.validMask & wayBit) != 0 && bucket.tags[way] == tag
+			&& isKeyEqual(bucketIndex, way, key)) {
+			bucket.referencedMask |= wayBit;
+			m_stats.hits.add();
+			return bucket.verdicts[way];
+		}
+	}
+
+	m_stats.misses.add();
+	return std::nullopt;
+}
+
+void VerdictCache::insert(const std::vector<std::byte>& key, uint32_t verdict) noexcept
+{
+	if (key.size() > M_MAX_KEY_SIZE) {
+		return;
+	}
+
+	const uint64_t keyHash = XXH3_64bits(key.data(), key.size());
+	const size_t bucketIndex = keyHash & M_BUCKET_MASK;
+	const auto tag = static_cast<uint32_t>(keyHash >> 32U);
+	Bucket& bucket = m_buckets[bucketIndex];
+
+	for (size_t way = 0; way < WAYS_PER_BUCKET; way++) {
+		const auto wayBit = static_cast<uint8_t>(1U << way);
+		if ((bucket.validMask & wayBit) == 0) {
+			storeKey(bucketIndex, way, key);
+			bucket.validMask |= wayBit;
+			bucket.tags[way] = tag;
+			bucket.verdicts[way] = verdict;
+			return;
+		}
+	}
+
+	// Bucket is full, give referenced verdicts a second chance
+	while ((bucket.referencedMask & (1U << bucket.clockHand)) != 0) {
+		bucket.referencedMask &= static_cast<uint8_t>(~(1U << bucket.clockHand));
+		bucket.clockHand = static_cast<uint8_t>((bucket.clockHand + 1U) % WAYS_PER_BUCKET);
+	}
+
+	storeKey(bucketIndex, bucket.clockHand, key);
+	bucket.tags[bucket.clockHand] = tag;
+	bucket.verdicts[bucket.clockHand] = verdict;
+	bucket.clockHand = static_cast<uint8_t>((bucket.clockHand + 1U) % WAYS_PER_BUCKET);
+	m_stats.evictions.add();
+}
+
+const VerdictCacheStats& VerdictCache::getStats() const noexcept
+{
+	return m_stats;
+}
+
+} // namespace ListDetector
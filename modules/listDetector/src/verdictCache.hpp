@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @brief Declaration of the VerdictCache class caching results of rules matching.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "counter/counter.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace ListDetector {
+
+/**
+ * @brief Statistics of the verdict cache.
+ */
+struct VerdictCacheStats {
+	Nm::Counter hits; ///< Number of lookups that found a cached verdict.
+	Nm::Counter misses; ///< Number of lookups that did not find a cached verdict.
+	Nm::Counter evictions; ///< Number of verdicts replaced by newer ones.
+};
+
+/**
+ * @brief Bounded cache of matching verdicts keyed by the packed rule fields of a record.
+ *
+ * The cache is set-associative. Hash of the key selects the bucket, which fits one cache line
+ * and keeps `WAYS_PER_BUCKET` verdicts with 32-bit tags of their keys. Verdicts are evicted by the
+ * CLOCK (second chance) algorithm. Keys are stored in one flat arena, each way has a slot of the
+ * maximal key size. A verdict is returned only if its whole key equals the looked up key, so
+ * colliding hashes never return a verdict of other field values. Keys longer than the slot are
+ * not cached. The cache is not thread-safe, each matching thread keeps its own instance.
+ */
+class VerdictCache {
+public:
+	/**
+	 * @brief Verdict saying that no rule matched the record.
+	 */
+	static inline const uint32_t NO_MATCH = std::numeric_limits<uint32_t>::max();
+
+	/**
+	 * @brief Number of verdicts kept in one bucket.
+	 */
+	static inline const size_t WAYS_PER_BUCKET = 7;
+
+	/**
+	 * @brief Maximal length of string fields of cached keys, longer strings are not cached.
+	 */
+	static inline const size_t MAX_STRING_LENGTH = 64;
+
+	/**
+	 * @brief Constructs the cache.
+	 * @param size Requested number of cached verdicts. Rounded up to a power of two buckets.
+	 * @param maxKeySize Size of the longest cached key in bytes.
+	 */
+	VerdictCache(size_t size, size_t maxKeySize);
+
+	/**
+	 * @brief Looks up the verdict for the given key.
+	 * @param key Packed rule fields of the record.
+	 * @return Index of the matched rule, `NO_MATCH` or std::nullopt if the key is not cached.
+	 */
+	std::optional<uint32_t> find(const std::vector<std::byte>& key) noexcept;
+
+	/**
+	 * @brief Inserts the verdict for the given key, evicting an older verdict if needed.
+	 *
+	 * Keys longer than the maximal key size are not inserted.
+	 *
+	 * @param key Packed rule fields of the record.
+	 * @param verdict Index of the matched rule or `NO_MATCH`.
+	 */
+	void insert(const std::vector<std::byte>& key, uint32_t verdict) noexcept;
+
+	/**
+	 * @brief Returns statistics of the cache.
+	 * @return Cache statistics.
+	 */
+	const VerdictCacheStats& getStats() const noexcept;
+
+private:
+	static constexpr size_t CACHE_LINE_SIZE = 64;
+
+	struct alignas(CACHE_LINE_SIZE) Bucket {
+		std::array<uint32_t, WAYS_PER_BUCKET> tags; ///< Upper halves of hashes of cached keys.
+		std::array<uint32_t, WAYS_PER_BUCKET> verdicts; ///< Verdicts of cached keys.
+		uint8_t validMask; ///< Bit set for each occupied way.
+		uint8_t referencedMask; ///< CLOCK reference bit for each way.
+		uint8_t clockHand; ///< Next way inspected by the CLOCK algorithm.
+	};
+
+	static_assert(sizeof(Bucket) == CACHE_LINE_SIZE, "Bucket must fit one cache line");
+
+	/**
+	 * @brief Slot of a key in the arena: the key length followed by the key bytes.
+	 */
+	using KeyLength = uint16_t;
+
+	std::byte* getKeySlot(size_t bucketIndex, size_t way) noexcept;
+	void storeKey(size_t bucketIndex, size_t way, const std::vector<std::byte>& key) noexcept;
+	bool isKeyEqual(size_t bucketIndex, size_t way, const std::vector<std::byte>& key) noexcept;
+
+	std::vector<Bucket> m_buckets;
+	const uint64_t M_BUCKET_MASK;
+	const size_t M_MAX_KEY_SIZE;
+	const size_t M_KEY_SLOT_SIZE;
+	std::vector<std::byte> m_keys; ///< Arena of key slots, `WAYS_PER_BUCKET` per bucket.
+
+	VerdictCacheStats m_stats;
+};
+
+} // namespace ListDetector
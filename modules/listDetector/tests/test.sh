@@ -16,13 +16,12 @@ function process_started {
   fi
 }
 
-data_path="$(dirname "$0")/testsData/"
-list_detector=$1
-
-set -e
-trap 'echo "Command \"$BASH_COMMAND\" failed!"; exit_with_error' ERR
-for input_file in $data_path/inputs/*; do
-  index=$(echo "$input_file" | grep -o '[0-9]\+')
+# Replays the input file through the list detector and compares the output with the result file.
+# Arguments: input file, expected result file, arguments of the list detector
+function run_test {
+  input_file=$1
+  expected_file=$2
+  shift 2
 
   res_file="/tmp/res"
   logger -i "u:listDetector" -w $res_file &
@@ -33,14 +32,13 @@ for input_file in $data_path/inputs/*; do
 
   $list_detector \
     -i "u:lr,u:listDetector" \
-    -r "$data_path/rules/rule$index.csv" \
-    -lm blacklist &
+    "$@" &
 
   detector_pid=$!
   sleep 0.1
   process_started $detector_pid
 
-  logreplay -i "u:lr" -f "$data_path/inputs/input$index.csv" 2>/dev/null &
+  logreplay -i "u:lr" -f "$input_file" 2>/dev/null &
   sleep 0.1
   process_started $!
 
@@ -48,15 +46,51 @@ for input_file in $data_path/inputs/*; do
   wait $detector_pid
 
   if [ -f "$res_file" ]; then
-    if ! cmp -s "$data_path/results/res$index.csv" "$res_file"; then
-      echo "Files results/res$index.csv and $res_file are not equal"
+    if ! cmp -s "$expected_file" "$res_file"; then
+      echo "Files $expected_file and $res_file are not equal (arguments: $*)"
       exit_with_error
     fi
   else
     echo "File $res_file not found"
     exit_with_error
   fi
+}
+
+data_path="$(dirname "$0")/testsData/"
+list_detector=$1
+
+set -e
+trap 'echo "Command \"$BASH_COMMAND\" failed!"; exit_with_error' ERR
+# Inputs 32 and 33 are matched against IPv4 and IPv6 sibling prefixes of one field, less than
+# 64 of them are matched by the linear scan and more than 64 by the octet trees. Inputs 34 and 35
+# are matched the same way against /32 and /128 host rules mixed with prefixes containing them
+for input_file in $data_path/inputs/*; do
+  index=$(echo "$input_file" | grep -o '[0-9]\+')
+
+  run_test "$input_file" "$data_path/results/res$index.csv" \
+    -r "$data_path/rules/rule$index.csv" -lm blacklist
+
+  # Several matching threads with small batches must give the same records in the same order
+  run_test "$input_file" "$data_path/results/res$index.csv" \
+    -r "$data_path/rules/rule$index.csv" -lm blacklist --threads 4 --batch-size 3
+
+  # Cached verdicts must give the same records as the full matching
+  run_test "$input_file" "$data_path/results/res$index.csv" \
+    -r "$data_path/rules/rule$index.csv" -lm blacklist --verdict-cache-size 1024
+
+  # The prefilter rejects only records that can not match, so the records must be the same
+  run_test "$input_file" "$data_path/results/res$index.csv" \
+    -r "$data_path/rules/rule$index.csv" -lm blacklist --prefilter
 done
 
+# The cache of one bucket keeps all records in one bucket and evicts them. Records "ab","c" and
+# "a","bc" concatenate to the same bytes, the 70 characters long string is too long to be cached
+run_test "$data_path/verdictCache/input.csv" "$data_path/verdictCache/res.csv" \
+  -r "$data_path/verdictCache/rules.csv" -lm blacklist --verdict-cache-size 1
+
+# Records matching none, one or both lists are tagged by 0, 1, 2 or 3 in LIST_MATCH_MASK
+run_test "$data_path/tagging/input.csv" "$data_path/tagging/res.csv" \
+  --tag -r "$data_path/tagging/list1.csv" -r "second=$data_path/tagging/list2.csv"
+
 echo "All tests passed"
 exit 0
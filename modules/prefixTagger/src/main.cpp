@@ -0,0 +1,285 @@
+/**
+ * @file
+ * @brief PrefixTagger Module: Enrich Unirec records by payload of IP prefixes.
+ *
+ * This file contains the main function and supporting functions for the Unirec PrefixTagger
+ * Module. The module receives Unirec records, looks up IP fields in the prefix database and
+ * forwards the records extended by payload fields of the longest matching prefixes, e.g.
+ * `SRC_ASN` and `DST_ASN`. The database is reloaded on the SIGHUP signal.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "instrumentation/processingLatency.hpp"
+#include "logger/logger.hpp"
+#include "prefixTagger.hpp"
+#include "unirec/unirec-telemetry.hpp"
+
+#include <algorithm>
+#include <appFs.hpp>
+#include <argparse/argparse.hpp>
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <libtrap/trap.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <telemetry.hpp>
+#include <unirec++/unirec.hpp>
+#include <vector>
+
+using namespace Nemea;
+
+static std::atomic<bool> g_stopFlag(false);
+static std::atomic<bool> g_reloadFlag(false);
+static Nm::ProcessingLatency g_processingLatency;
+
+/**
+ * @brief Receive timeout in microseconds, so the reload is requested even on an idle input.
+ */
+static const int g_RECEIVE_TIMEOUT_US = 100000;
+
+static void signalHandler(int signum)
+{
+	Nm::loggerGet("signalHandler")->info("Interrupt signal {} received", signum);
+	g_stopFlag.store(true);
+}
+
+static void reloadSignalHandler([[maybe_unused]] int signum)
+{
+	g_reloadFlag.store(true);
+}
+
+/**
+ * @brief Splits the comma separated list of field names.
+ * @param fieldNames Comma separated field names.
+ * @return Field names.
+ */
+static std::vector<std::string> splitFieldNames(const std::string& fieldNames)
+{
+	std::vector<std::string> names;
+	size_t begin = 0;
+	while (begin <= fieldNames.size()) {
+		const size_t end = std::min(fieldNames.find(',', begin), fieldNames.size());
+		if (end != begin) {
+			names.emplace_back(fieldNames.substr(begin, end - begin));
+		}
+		begin = end + 1;
+	}
+	return names;
+}
+
+/**
+ * @brief Output of the module.
+ */
+struct TaggingOutput {
+	UnirecOutputInterface& interface; ///< Output interface.
+	std::optional<UnirecRecord> record; ///< Output record, created on the format change.
+};
+
+/**
+ * @brief Handle a format change exception by adjusting the templates.
+ *
+ * The output template is the input template extended by the payload fields of the tagger.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output of the module.
+ * @param prefixTagger PrefixTagger instance for tagging Unirec records.
+ */
+static void handleFormatChange(
+	UnirecInputInterface& inputInterface,
+	TaggingOutput& output,
+	PrefixTagger::PrefixTagger& prefixTagger)
+{
+	inputInterface.changeTemplate();
+
+	uint8_t dataType;
+	const char* inputSpecification = nullptr;
+	if (trap_get_data_fmt(TRAPIFC_INPUT, 0, &dataType, &inputSpecification) != TRAP_E_OK) {
+		throw std::runtime_error("Unable to get the format of the input interface");
+	}
+
+	std::string outputSpecification = inputSpecification;
+	const std::string extendedInputSpecification = "," + outputSpecification + ",";
+	for (const auto& field : splitFieldNames(prefixTagger.getOutputFieldsDescription())) {
+		const std::string fieldName = field.substr(field.find(' ') + 1);
+		if (extendedInputSpecification.find(" " + fieldName + ",") == std::string::npos) {
+			outputSpecification += "," + field;
+		}
+	}
+
+	output.interface.changeTemplate(outputSpecification);
+	output.record.emplace(output.interface.createUnirecRecord());
+	prefixTagger.changeTemplate();
+}
+
+/**
+ * @brief Process the next Unirec record and forward it with the payload fields.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output of the module.
+ * @param prefixTagger PrefixTagger instance for tagging Unirec records.
+ */
+static void processNextRecord(
+	UnirecInputInterface& inputInterface,
+	TaggingOutput& output,
+	PrefixTagger::PrefixTagger& prefixTagger)
+{
+	Nm::PhaseTimer phaseTimer;
+	std::optional<UnirecRecordView> unirecRecord = inputInterface.receive();
+	if (!unirecRecord) {
+		return;
+	}
+	phaseTimer.lap(g_processingLatency.receive);
+
+	output.record->copyFieldsFrom(*unirecRecord);
+	prefixTagger.tag(*unirecRecord, *output.record);
+	phaseTimer.lap(g_processingLatency.process);
+
+	output.interface.send(*output.record);
+	phaseTimer.lap(g_processingLatency.send);
+}
+
+/**
+ * @brief Process Unirec records.
+ *
+ * Every received record is forwarded with the payload fields. Reload of the prefix database is
+ * requested when the SIGHUP signal was received, at the latest after the receive timeout. The
+ * loop runs until an end-of-file condition is encountered.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output of the module.
+ * @param prefixTagger PrefixTagger instance for tagging Unirec records.
+ */
+static void processUnirecRecords(
+	UnirecInputInterface& inputInterface,
+	TaggingOutput& output,
+	PrefixTagger::PrefixTagger& prefixTagger)
+{
+	while (!g_stopFlag.load()) {
+		if (g_reloadFlag.exchange(false)) {
+			prefixTagger.requestReload();
+		}
+
+		try {
+			processNextRecord(inputInterface, output, prefixTagger);
+		} catch (FormatChangeException& ex) {
+			handleFormatChange(inputInterface, output, prefixTagger);
+		} catch (const EoFException& ex) {
+			break;
+		} catch (const std::exception& ex) {
+			throw;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	argparse::ArgumentParser program("prefixTagger");
+
+	Nm::loggerInit();
+	auto logger = Nm::loggerGet("main");
+
+	signal(SIGINT, signalHandler);
+	signal(SIGHUP, reloadSignalHandler);
+
+	try {
+		program.add_argument("-d", "--database")
+			.required()
+			.help("specify the CSV prefix database. It is reloaded on the SIGHUP signal")
+			.metavar("csv_file");
+
+		program.add_argument("-f", "--fields")
+			.help("comma separated names of the tagged IP fields")
+			.default_value(std::string("SRC_IP,DST_IP"));
+
+		program.add_argument("-m", "--appfs-mountpoint")
+			.required()
+			.help("path where the appFs directory will be mounted")
+			.default_value(std::string(""));
+	} catch (std::exception& ex) {
+		logger->error(ex.what());
+		return EXIT_FAILURE;
+	}
+
+	Unirec unirec({1, 1, "PrefixTagger", "Unirec prefix tagger module"});
+
+	try {
+		unirec.init(argc, argv);
+	} catch (const HelpException& ex) {
+		std::cerr << program;
+		return EXIT_SUCCESS;
+	} catch (const std::exception& ex) {
+		logger->error(ex.what());
+		return EXIT_FAILURE;
+	}
+
+	try {
+		program.parse_args(argc, argv);
+	} catch (const std::exception& ex) {
+		logger->error(ex.what());
+		return EXIT_FAILURE;
+	}
+
+	std::shared_ptr<telemetry::Directory> telemetryRootDirectory;
+	telemetryRootDirectory = telemetry::Directory::create();
+	const auto latencyFile
+		= Nm::addProcessingLatencyFile(telemetryRootDirectory, g_processingLatency);
+
+	std::unique_ptr<telemetry::appFs::AppFsFuse> appFs;
+
+	try {
+		auto mountPoint = program.get<std::string>("--appfs-mountpoint");
+		if (!mountPoint.empty()) {
+			const bool tryToUnmountOnStart = true;
+			const bool createMountPoint = true;
+			appFs = std::make_unique<telemetry::appFs::AppFsFuse>(
+				telemetryRootDirectory,
+				mountPoint,
+				tryToUnmountOnStart,
+				createMountPoint);
+			appFs->start();
+		}
+	} catch (std::exception& ex) {
+		logger->error(ex.what());
+		return EXIT_FAILURE;
+	}
+
+	try {
+		const auto ipFieldNames = splitFieldNames(program.get<std::string>("--fields"));
+		if (ipFieldNames.empty()) {
+			std::cerr << "At least one IP field must be specified.\n";
+			return EXIT_FAILURE;
+		}
+
+		PrefixTagger::PrefixTagger prefixTagger(
+			program.get<std::string>("--database"),
+			ipFieldNames);
+
+		UnirecInputInterface inputInterface = unirec.buildInputInterface();
+		UnirecOutputInterface outputInterface = unirec.buildOutputInterface();
+		inputInterface.setRequieredFormat(prefixTagger.getUnirecTemplateDescription());
+		inputInterface.setReceiveTimeout(g_RECEIVE_TIMEOUT_US);
+
+		auto telemetryInputDirectory = telemetryRootDirectory->addDir("input");
+		const Nm::InterfaceRatesSampler ratesSampler(inputInterface);
+		const telemetry::FileOps inputFileOps
+			= {[&inputInterface, &ratesSampler]() {
+				   return Nm::getInterfaceTelemetry(inputInterface, ratesSampler);
+			   },
+			   nullptr};
+		const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
+
+		prefixTagger.setTelemetryDirectory(telemetryRootDirectory->addDir("prefixtagger"));
+
+		TaggingOutput output = {outputInterface, std::nullopt};
+		processUnirecRecords(inputInterface, output, prefixTagger);
+
+	} catch (std::exception& ex) {
+		logger->error(ex.what());
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,287 @@
+/**
+ * @file
+ * @brief Implementation of the PrefixDatabase class for longest prefix lookup of IP addresses
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "prefixDatabase.hpp"
+#include "csv/csvLine.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <xxhash.h>
+
+namespace PrefixTagger {
+
+static const char g_SEPARATOR = ',';
+static const char g_COMMENT_PREFIX = '#';
+
+static PayloadValue createDefaultValue(const std::string& type)
+{
+	static const std::vector<std::pair<std::string, PayloadValue>> g_SUPPORTED_TYPES = {
+		{"uint8", uint8_t {0}},
+		{"int8", int8_t {0}},
+		{"uint16", uint16_t {0}},
+		{"int16", int16_t {0}},
+		{"uint32", uint32_t {0}},
+		{"int32", int32_t {0}},
+		{"uint64", uint64_t {0}},
+		{"int64", int64_t {0}},
+		{"string", std::string()},
+	};
+
+	for (const auto& [supportedType, defaultValue] : g_SUPPORTED_TYPES) {
+		if (supportedType == type) {
+			return defaultValue;
+		}
+	}
+	throw std::invalid_argument("Unsupported type of payload field '" + type + "'");
+}
+
+static PayloadValue convertCell(const std::string& cell, const PayloadValue& defaultValue)
+{
+	return std::visit(
+		[&cell](const auto& value) -> PayloadValue {
+			using ValueType = std::decay_t<decltype(value)>;
+			if constexpr (std::is_same_v<ValueType, std::string>) {
+				return cell;
+			} else {
+				ValueType result;
+				const char* cellEnd = cell.data() + cell.size();
+				const auto [end, errorCode] = std::from_chars(cell.data(), cellEnd, result);
+				if (errorCode != std::errc {} || end != cellEnd) {
+					throw std::invalid_argument("Invalid payload value '" + cell + "'");
+				}
+				return result;
+			}
+		},
+		defaultValue);
+}
+
+static Nm::IpAddressPrefix convertCellToPrefix(const std::string& cell)
+{
+	const size_t delimiterPosition = cell.find('/');
+	const Nemea::IpAddress address(cell.substr(0, delimiterPosition));
+	if (delimiterPosition == std::string::npos) {
+		return {
+			address,
+			address.isIpv4() ? Nm::IpAddressPrefix::IPV4_MAX_PREFIX
+							 : Nm::IpAddressPrefix::IPV6_MAX_PREFIX};
+	}
+
+	size_t length;
+	const char* cellEnd = cell.data() + cell.size();
+	const auto [end, errorCode]
+		= std::from_chars(cell.data() + delimiterPosition + 1, cellEnd, length);
+	if (errorCode != std::errc {} || end != cellEnd) {
+		throw std::invalid_argument("Invalid prefix '" + cell + "'");
+	}
+	return {address, length};
+}
+
+size_t PrefixDatabase::PrefixTable::findSlot(const ip_addr_t& network) const noexcept
+{
+	// Capacity is a power of two, empty slot always exists as the load factor is at most 1/2
+	const size_t slotMask = slots.size() - 1;
+	size_t slotIndex = static_cast<size_t>(XXH3_64bits(&network, sizeof(network))) & slotMask;
+	while (slots[slotIndex].payloadIndex != NO_PAYLOAD
+		   && std::memcmp(&slots[slotIndex].network, &network, sizeof(ip_addr_t)) != 0) {
+		slotIndex = (slotIndex + 1) & slotMask;
+	}
+	return slotIndex;
+}
+
+void PrefixDatabase::PrefixTable::grow()
+{
+	std::vector<Slot> oldSlots = std::move(slots);
+	slots.assign(oldSlots.empty() ? INITIAL_CAPACITY : oldSlots.size() * 2, Slot {});
+	for (const auto& slot : oldSlots) {
+		if (slot.payloadIndex != NO_PAYLOAD) {
+			slots[findSlot(slot.network)] = slot;
+		}
+	}
+}
+
+void PrefixDatabase::PrefixTable::insert(const Nemea::IpAddress& network, uint32_t payloadIndex)
+{
+	if ((prefixesCount + 1) * 2 > slots.size()) {
+		grow();
+	}
+
+	Slot& slot = slots[findSlot(network.ip)];
+	if (slot.payloadIndex == NO_PAYLOAD) {
+		slot.network = network.ip;
+		prefixesCount++;
+	}
+	slot.payloadIndex = payloadIndex;
+}
+
+PrefixDatabase::PrefixDatabase(const std::string& filename)
+{
+	std::ifstream file(filename);
+	if (!file) {
+		m_logger->error("Unable to open file {}", filename);
+		throw std::runtime_error("PrefixDatabase::PrefixDatabase() has failed");
+	}
+
+	std::unordered_map<std::string, uint32_t> payloadIndexes;
+	bool isHeaderParsed = false;
+	size_t lineNumber = 0;
+	std::string line;
+	try {
+		while (std::getline(file, line)) {
+			lineNumber++;
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (line.empty() || line.front() == g_COMMENT_PREFIX) {
+				continue;
+			}
+
+			if (isHeaderParsed) {
+				parseRow(line, payloadIndexes);
+			} else {
+				parseHeader(line);
+				isHeaderParsed = true;
+			}
+		}
+	} catch (const std::exception& ex) {
+		m_logger->error("Invalid line {} of {}: {}", lineNumber, filename, ex.what());
+		throw std::runtime_error("PrefixDatabase::PrefixDatabase() has failed");
+	}
+
+	if (!isHeaderParsed) {
+		m_logger->error("File {} has no header", filename);
+		throw std::runtime_error("PrefixDatabase::PrefixDatabase() has failed");
+	}
+
+	// Longer prefixes are probed first to find the longest matching prefix
+	auto isLonger = [](const PrefixTable& left, const PrefixTable& right) {
+		return left.length > right.length;
+	};
+	std::sort(m_ipv4Tables.begin(), m_ipv4Tables.end(), isLonger);
+	std::sort(m_ipv6Tables.begin(), m_ipv6Tables.end(), isLonger);
+
+	for (const auto* tables : {&m_ipv4Tables, &m_ipv6Tables}) {
+		for (const auto& table : *tables) {
+			m_prefixesCount += table.prefixesCount;
+		}
+	}
+}
+
+void PrefixDatabase::parseHeader(const std::string& line)
+{
+	const std::vector<std::string> cells = Nm::splitLine(line);
+	if (cells.front() != PREFIX_COLUMN) {
+		throw std::invalid_argument("The first column must be '" + PREFIX_COLUMN + "'");
+	}
+
+	for (size_t column = 1; column < cells.size(); column++) {
+		const size_t delimiterPosition = cells[column].find(' ');
+		if (delimiterPosition == std::string::npos) {
+			throw std::invalid_argument("Invalid payload field '" + cells[column] + "'");
+		}
+
+		PayloadField field;
+		field.type = cells[column].substr(0, delimiterPosition);
+		field.name = Nm::trimCell(std::string_view(cells[column]).substr(delimiterPosition + 1));
+		field.defaultValue = createDefaultValue(field.type);
+		m_payloadFields.emplace_back(std::move(field));
+	}
+}
+
+void PrefixDatabase::parseRow(
+	const std::string& line,
+	std::unordered_map<std::string, uint32_t>& payloadIndexes)
+{
+	const std::vector<std::string> cells = Nm::splitLine(line);
+	if (cells.size() != m_payloadFields.size() + 1) {
+		throw std::invalid_argument(
+			"Expected " + std::to_string(m_payloadFields.size() + 1) + " columns, got "
+			+ std::to_string(cells.size()));
+	}
+
+	const Nm::IpAddressPrefix prefix = convertCellToPrefix(cells.front());
+	const size_t payloadStart = std::min(line.find(g_SEPARATOR), line.size());
+	insertPrefix(prefix, addPayload(line.substr(payloadStart), cells, payloadIndexes));
+}
+
+uint32_t PrefixDatabase::addPayload(
+	const std::string& payloadText,
+	const std::vector<std::string>& cells,
+	std::unordered_map<std::string, uint32_t>& payloadIndexes)
+{
+	const auto iter = payloadIndexes.find(payloadText);
+	if (iter != payloadIndexes.end()) {
+		return iter->second;
+	}
+
+	if (m_payloads.size() >= NO_PAYLOAD) {
+		throw std::overflow_error("Too many distinct payloads");
+	}
+
+	std::vector<PayloadValue> payload;
+	for (size_t fieldIndex = 0; fieldIndex < m_payloadFields.size(); fieldIndex++) {
+		payload.emplace_back(
+			convertCell(cells[fieldIndex + 1], m_payloadFields[fieldIndex].defaultValue));
+	}
+
+	const auto payloadIndex = static_cast<uint32_t>(m_payloads.size());
+	m_payloads.emplace_back(std::move(payload));
+	payloadIndexes.emplace(payloadText, payloadIndex);
+	return payloadIndex;
+}
+
+void PrefixDatabase::insertPrefix(
+	const Nm::IpAddressPrefix& prefix,
+	uint32_t payloadIndex)
+{
+	auto& tables = prefix.getAddress().isIpv4() ? m_ipv4Tables : m_ipv6Tables;
+	auto hasSameLength
+		= [&prefix](const PrefixTable& table) { return table.length == prefix.getLength(); };
+	auto table = std::find_if(tables.begin(), tables.end(), hasSameLength);
+	if (table == tables.end()) {
+		tables.push_back({prefix.getLength(), prefix.getMask(), {}, 0});
+		table = std::prev(tables.end());
+	}
+	table->insert(prefix.getAddress(), payloadIndex);
+}
+
+const std::vector<PayloadValue>*
+PrefixDatabase::find(const Nemea::IpAddress& address) const noexcept
+{
+	const auto& tables = address.isIpv4() ? m_ipv4Tables : m_ipv6Tables;
+	for (const auto& table : tables) {
+		const Nemea::IpAddress network = address & table.mask;
+		const Slot& slot = table.slots[table.findSlot(network.ip)];
+		if (slot.payloadIndex != NO_PAYLOAD) {
+			return &m_payloads[slot.payloadIndex];
+		}
+	}
+	return nullptr;
+}
+
+const std::vector<PayloadField>& PrefixDatabase::getPayloadFields() const noexcept
+{
+	return m_payloadFields;
+}
+
+size_t PrefixDatabase::getPrefixesCount() const noexcept
+{
+	return m_prefixesCount;
+}
+
+size_t PrefixDatabase::getPayloadsCount() const noexcept
+{
+	return m_payloads.size();
+}
+
+} // namespace PrefixTagger
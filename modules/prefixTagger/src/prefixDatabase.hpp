@@ -0,0 +1,134 @@
+/**
+ * @file
+ * @brief Declaration of the PrefixDatabase class for longest prefix lookup of IP addresses
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "ip/ipAddressPrefix.hpp"
+#include "logger/logger.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unirec++/ipAddress.hpp>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace PrefixTagger {
+
+/**
+ * @brief Value of a payload field.
+ */
+using PayloadValue = std::
+	variant<uint8_t, int8_t, uint16_t, int16_t, uint32_t, int32_t, uint64_t, int64_t, std::string>;
+
+/**
+ * @brief Payload field given by the header of the database file.
+ */
+struct PayloadField {
+	std::string type; ///< Unirec type of the field.
+	std::string name; ///< Name of the field without the IP field prefix.
+	PayloadValue defaultValue; ///< Value used when no prefix matches.
+};
+
+/**
+ * @brief Database of IP prefixes with payload, looked up by the longest matching prefix.
+ *
+ * The database is loaded from a CSV file. The first column of the header must be
+ * `ipaddr PREFIX`, the other columns define the payload fields in the Unirec format, e.g.
+ * `uint32 ASN`. Each row contains a prefix in the `address[/length]` format followed by the
+ * payload values. Equal payloads are stored only once.
+ *
+ * Prefixes are kept in a separate open addressing hash table for each prefix length and address
+ * family. An address is looked up by probing the tables from the longest prefix length, so the
+ * lookup cost depends only on the number of distinct prefix lengths, not on the number of
+ * prefixes.
+ */
+class PrefixDatabase {
+public:
+	/**
+	 * @brief Name of the column with prefixes.
+	 */
+	static inline const std::string PREFIX_COLUMN = "ipaddr PREFIX";
+
+	/**
+	 * @brief Loads the database from the CSV file.
+	 *
+	 * If the same prefix is present several times, the last row is used.
+	 *
+	 * @param filename Path to the database file.
+	 * @throw std::runtime_error If the file can not be read or it is not valid.
+	 */
+	explicit PrefixDatabase(const std::string& filename);
+
+	/**
+	 * @brief Finds payload of the longest prefix containing the address.
+	 * @param address The IP address to find.
+	 * @return Payload values in the order of payload fields or nullptr if no prefix matches.
+	 */
+	const std::vector<PayloadValue>* find(const Nemea::IpAddress& address) const noexcept;
+
+	/**
+	 * @brief Returns payload fields of the database.
+	 */
+	const std::vector<PayloadField>& getPayloadFields() const noexcept;
+
+	/**
+	 * @brief Returns number of distinct prefixes.
+	 */
+	size_t getPrefixesCount() const noexcept;
+
+	/**
+	 * @brief Returns number of distinct payloads.
+	 */
+	size_t getPayloadsCount() const noexcept;
+
+private:
+	static inline const uint32_t NO_PAYLOAD = std::numeric_limits<uint32_t>::max();
+	static inline const size_t INITIAL_CAPACITY = 16;
+
+	struct Slot {
+		ip_addr_t network;
+		uint32_t payloadIndex = NO_PAYLOAD;
+	};
+
+	/**
+	 * @brief Prefixes of one length and address family.
+	 */
+	struct PrefixTable {
+		size_t length;
+		Nemea::IpAddress mask;
+		std::vector<Slot> slots;
+		size_t prefixesCount = 0;
+
+		size_t findSlot(const ip_addr_t& network) const noexcept;
+		void insert(const Nemea::IpAddress& network, uint32_t payloadIndex);
+		void grow();
+	};
+
+	void parseHeader(const std::string& line);
+	void parseRow(
+		const std::string& line,
+		std::unordered_map<std::string, uint32_t>& payloadIndexes);
+	uint32_t addPayload(
+		const std::string& payloadText,
+		const std::vector<std::string>& cells,
+		std::unordered_map<std::string, uint32_t>& payloadIndexes);
+	void insertPrefix(const Nm::IpAddressPrefix& prefix, uint32_t payloadIndex);
+
+	std::vector<PayloadField> m_payloadFields;
+	std::vector<std::vector<PayloadValue>> m_payloads;
+	std::vector<PrefixTable> m_ipv4Tables;
+	std::vector<PrefixTable> m_ipv6Tables;
+	size_t m_prefixesCount = 0;
+
+	std::shared_ptr<spdlog::logger> m_logger = Nm::loggerGet("PrefixDatabase");
+};
+
+} // namespace PrefixTagger
@@ -0,0 +1,221 @@
+/**
+ * @file
+ * @brief Implementation of the PrefixTagger class enriching records by payload of IP prefixes
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "prefixTagger.hpp"
+
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+namespace PrefixTagger {
+
+static const std::string g_IP_FIELD_SUFFIX = "_IP";
+
+static std::string createOutputPrefix(const std::string& ipFieldName)
+{
+	if (ipFieldName.size() > g_IP_FIELD_SUFFIX.size()
+		&& ipFieldName.compare(
+			   ipFieldName.size() - g_IP_FIELD_SUFFIX.size(),
+			   g_IP_FIELD_SUFFIX.size(),
+			   g_IP_FIELD_SUFFIX)
+			== 0) {
+		return ipFieldName.substr(0, ipFieldName.size() - g_IP_FIELD_SUFFIX.size() + 1);
+	}
+	return ipFieldName + "_";
+}
+
+static bool hasSamePayloadFields(
+	const std::vector<PayloadField>& fields,
+	const std::vector<PayloadField>& otherFields)
+{
+	if (fields.size() != otherFields.size()) {
+		return false;
+	}
+	for (size_t fieldIndex = 0; fieldIndex < fields.size(); fieldIndex++) {
+		if (fields[fieldIndex].type != otherFields[fieldIndex].type
+			|| fields[fieldIndex].name != otherFields[fieldIndex].name) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void setPayloadValue(
+	Nemea::UnirecRecord& unirecRecord,
+	const PayloadValue& value,
+	ur_field_id_t fieldId)
+{
+	std::visit(
+		[&unirecRecord, fieldId](const auto& fieldValue) {
+			unirecRecord.setFieldFromType(fieldValue, fieldId);
+		},
+		value);
+}
+
+PrefixTagger::PrefixTagger(std::string databaseFilename, std::vector<std::string> ipFieldNames)
+	: m_databaseFilename(std::move(databaseFilename))
+	, m_database(std::make_shared<const PrefixDatabase>(m_databaseFilename))
+	, m_activeDatabase(m_database)
+{
+	m_payloadFields = m_database->getPayloadFields();
+	if (m_payloadFields.empty()) {
+		m_logger->error("Prefix database {} has no payload fields", m_databaseFilename);
+		throw std::runtime_error("PrefixTagger::PrefixTagger() has failed");
+	}
+
+	for (auto& ipFieldName : ipFieldNames) {
+		IpField ipField;
+		ipField.outputPrefix = createOutputPrefix(ipFieldName);
+		ipField.name = std::move(ipFieldName);
+		m_ipFields.emplace_back(std::move(ipField));
+	}
+
+	m_reloader = std::thread(&PrefixTagger::runReloader, this);
+}
+
+PrefixTagger::~PrefixTagger()
+{
+	{
+		const std::lock_guard<std::mutex> lock(m_reloadMutex);
+		m_isStopRequested = true;
+	}
+	m_reloadCondition.notify_one();
+	m_reloader.join();
+}
+
+std::string PrefixTagger::getUnirecTemplateDescription() const
+{
+	std::string description;
+	for (const auto& ipField : m_ipFields) {
+		description += (description.empty() ? "" : ",") + std::string("ipaddr ") + ipField.name;
+	}
+	return description;
+}
+
+std::string PrefixTagger::getOutputFieldsDescription() const
+{
+	std::string description;
+	for (const auto& ipField : m_ipFields) {
+		for (const auto& payloadField : m_payloadFields) {
+			description += (description.empty() ? "" : ",") + payloadField.type + " "
+				+ ipField.outputPrefix + payloadField.name;
+		}
+	}
+	return description;
+}
+
+void PrefixTagger::changeTemplate()
+{
+	for (auto& ipField : m_ipFields) {
+		ipField.id = static_cast<ur_field_id_t>(ur_get_id_by_name(ipField.name.c_str()));
+		ipField.outputIds.clear();
+		for (const auto& payloadField : m_payloadFields) {
+			const std::string outputName = ipField.outputPrefix + payloadField.name;
+			ipField.outputIds.emplace_back(
+				static_cast<ur_field_id_t>(ur_get_id_by_name(outputName.c_str())));
+		}
+	}
+}
+
+void PrefixTagger::tag(
+	const Nemea::UnirecRecordView& unirecRecordView,
+	Nemea::UnirecRecord& unirecRecord)
+{
+	// The shared database pointer is loaded only when the reloading thread replaced it
+	const uint64_t databaseGeneration = m_databaseGeneration.load(std::memory_order_acquire);
+	if (databaseGeneration != m_activeDatabaseGeneration) {
+		m_activeDatabase = std::atomic_load(&m_database);
+		m_activeDatabaseGeneration = databaseGeneration;
+	}
+
+	m_recordsCount.add();
+	for (auto& ipField : m_ipFields) {
+		const auto address = unirecRecordView.getFieldAsType<Nemea::IpAddress>(ipField.id);
+		const std::vector<PayloadValue>* payload = m_activeDatabase->find(address);
+		if (payload != nullptr) {
+			ipField.matchedCount.add();
+		} else {
+			ipField.unmatchedCount.add();
+		}
+
+		for (size_t fieldIndex = 0; fieldIndex < m_payloadFields.size(); fieldIndex++) {
+			const PayloadValue& value = payload != nullptr
+				? (*payload)[fieldIndex]
+				: m_payloadFields[fieldIndex].defaultValue;
+			setPayloadValue(unirecRecord, value, ipField.outputIds[fieldIndex]);
+		}
+	}
+}
+
+void PrefixTagger::requestReload()
+{
+	{
+		const std::lock_guard<std::mutex> lock(m_reloadMutex);
+		m_isReloadRequested = true;
+	}
+	m_reloadCondition.notify_one();
+}
+
+void PrefixTagger::runReloader()
+{
+	std::unique_lock<std::mutex> lock(m_reloadMutex);
+	while (true) {
+		m_reloadCondition.wait(lock, [this]() { return m_isReloadRequested || m_isStopRequested; });
+		if (m_isStopRequested) {
+			return;
+		}
+		m_isReloadRequested = false;
+
+		lock.unlock();
+		reload();
+		lock.lock();
+	}
+}
+
+void PrefixTagger::reload()
+{
+	m_logger->info("Reloading prefix database {}", m_databaseFilename);
+	try {
+		auto database = std::make_shared<const PrefixDatabase>(m_databaseFilename);
+		if (!hasSamePayloadFields(database->getPayloadFields(), m_payloadFields)) {
+			throw std::runtime_error("Payload fields of the reloaded database differ");
+		}
+		std::atomic_store(&m_database, std::shared_ptr<const PrefixDatabase>(database));
+		m_databaseGeneration.fetch_add(1, std::memory_order_release);
+		m_reloadsCount++;
+		m_logger->info("Prefix database reloaded with {} prefixes", database->getPrefixesCount());
+	} catch (const std::exception& ex) {
+		m_failedReloadsCount++;
+		m_logger->error("Reload failed, the previous database is kept: {}", ex.what());
+	}
+}
+
+telemetry::Content PrefixTagger::createTelemetryContent() const
+{
+	const std::shared_ptr<const PrefixDatabase> database = std::atomic_load(&m_database);
+
+	telemetry::Dict dict;
+	dict["recordsCount"] = m_recordsCount.load();
+	dict["prefixesCount"] = static_cast<uint64_t>(database->getPrefixesCount());
+	dict["payloadsCount"] = static_cast<uint64_t>(database->getPayloadsCount());
+	dict["reloadsCount"] = m_reloadsCount.load();
+	dict["failedReloadsCount"] = m_failedReloadsCount.load();
+	for (const auto& ipField : m_ipFields) {
+		dict[ipField.name + ".matchedCount"] = ipField.matchedCount.load();
+		dict[ipField.name + ".unmatchedCount"] = ipField.unmatchedCount.load();
+	}
+	return dict;
+}
+
+void PrefixTagger::setTelemetryDirectory(const std::shared_ptr<telemetry::Directory>& directory)
+{
+	const telemetry::FileOps fileOps = {[this]() { return createTelemetryContent(); }, nullptr};
+	m_holder.add(directory->addFile("stats", fileOps));
+}
+
+} // namespace PrefixTagger
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Declaration of the PrefixTagger class enriching records by payload of IP prefixes
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "counter/counter.hpp"
+#include "logger/logger.hpp"
+#include "prefixDatabase.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <telemetry.hpp>
+#include <thread>
+#include <unirec++/unirec.hpp>
+#include <vector>
+
+namespace PrefixTagger {
+
+/**
+ * @brief Adds payload of the longest matching prefix of IP fields to Unirec records.
+ *
+ * For each IP field and payload field an output field is added. Its name is the IP field name
+ * without the trailing `IP` followed by the payload field name, e.g. `SRC_IP` and `ASN` give
+ * `SRC_ASN`. Names of IP fields without the `_IP` suffix are followed by an underscore.
+ *
+ * The database can be reloaded while records are tagged. The new database is loaded by a
+ * background thread and atomically replaces the old one, which is kept if the loading fails.
+ */
+class PrefixTagger {
+public:
+	/**
+	 * @brief Loads the prefix database and starts the reloading thread.
+	 * @param databaseFilename Path to the prefix database file.
+	 * @param ipFieldNames Names of the IP fields to tag.
+	 * @throw std::runtime_error If the database can not be loaded.
+	 */
+	PrefixTagger(std::string databaseFilename, std::vector<std::string> ipFieldNames);
+
+	PrefixTagger(const PrefixTagger&) = delete;
+	PrefixTagger& operator=(const PrefixTagger&) = delete;
+
+	/**
+	 * @brief Stops the reloading thread.
+	 */
+	~PrefixTagger();
+
+	/**
+	 * @brief Get the Unirec template description of the tagged IP fields.
+	 */
+	std::string getUnirecTemplateDescription() const;
+
+	/**
+	 * @brief Get the Unirec template description of the added output fields.
+	 */
+	std::string getOutputFieldsDescription() const;
+
+	/**
+	 * @brief Resolves ids of the input and output fields after the format change.
+	 */
+	void changeTemplate();
+
+	/**
+	 * @brief Sets the payload fields of the output record.
+	 *
+	 * Fields of IP addresses without any matching prefix are set to zero or an empty string.
+	 *
+	 * @param unirecRecordView Received Unirec record.
+	 * @param unirecRecord Output record with the added fields.
+	 */
+	void tag(const Nemea::UnirecRecordView& unirecRecordView, Nemea::UnirecRecord& unirecRecord);
+
+	/**
+	 * @brief Asks the reloading thread to load the database file again.
+	 */
+	void requestReload();
+
+	/**
+	 * @brief Sets the telemetry directory for the PrefixTagger.
+	 * @param directory directory for PrefixTagger telemetry.
+	 */
+	void setTelemetryDirectory(const std::shared_ptr<telemetry::Directory>& directory);
+
+private:
+	/**
+	 * @brief Tagged IP field with ids of its output fields.
+	 */
+	struct IpField {
+		std::string name;
+		std::string outputPrefix;
+		ur_field_id_t id = 0;
+		std::vector<ur_field_id_t> outputIds;
+		Nm::Counter matchedCount;
+		Nm::Counter unmatchedCount;
+	};
+
+	void runReloader();
+	void reload();
+	telemetry::Content createTelemetryContent() const;
+
+	std::string m_databaseFilename;
+	std::vector<IpField> m_ipFields;
+	std::vector<PayloadField> m_payloadFields;
+
+	std::shared_ptr<const PrefixDatabase> m_database;
+	std::atomic<uint64_t> m_databaseGeneration = 0;
+	std::shared_ptr<const PrefixDatabase> m_activeDatabase;
+	uint64_t m_activeDatabaseGeneration = 0;
+
+	std::mutex m_reloadMutex;
+	std::condition_variable m_reloadCondition;
+	bool m_isReloadRequested = false;
+	bool m_isStopRequested = false;
+	std::thread m_reloader;
+
+	Nm::Counter m_recordsCount;
+	std::atomic<uint64_t> m_reloadsCount = 0;
+	std::atomic<uint64_t> m_failedReloadsCount = 0;
+
+	telemetry::Holder m_holder;
+	std::shared_ptr<spdlog::logger> m_logger = Nm::loggerGet("PrefixTagger");
+};
+
+} // namespace PrefixTagger
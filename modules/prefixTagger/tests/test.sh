@@ -0,0 +1,81 @@
+#!/bin/bash
+
+function exit_with_error {
+  pkill logger
+  pkill logreplay
+  pkill prefixTagger
+  exit 1
+}
+
+function process_started {
+  pid=$1
+  if ! ps -p $pid > /dev/null
+    then
+      echo "Failed to start process"
+      exit_with_error
+  fi
+}
+
+function compare_result {
+  expected_file=$1
+  if [ -f "$res_file" ]; then
+    if ! cmp -s "$expected_file" "$res_file"; then
+      echo "Files $expected_file and $res_file are not equal"
+      exit_with_error
+    fi
+  else
+    echo "File $res_file not found"
+    exit_with_error
+  fi
+}
+
+# Starts the logger and the prefix tagger with the database, the pids are kept in logger_pid and
+# tagger_pid
+function start_tagger {
+  database_file=$1
+
+  logger -i "u:prefixTagger" -w $res_file &
+  logger_pid=$!
+  sleep 0.1
+  process_started $logger_pid
+
+  $prefix_tagger -i "u:lr,u:prefixTagger" -d "$database_file" &
+  tagger_pid=$!
+  sleep 0.1
+  process_started $tagger_pid
+}
+
+function replay_input {
+  logreplay -i "u:lr" -f "$data_path/input.csv" 2>/dev/null &
+  sleep 0.1
+  process_started $!
+
+  wait $logger_pid
+  wait $tagger_pid
+}
+
+data_path="$(dirname "$0")/testsData"
+prefix_tagger=$1
+res_file="/tmp/res"
+database_copy="/tmp/prefixTaggerDatabase.csv"
+
+set -e
+trap 'echo "Command \"$BASH_COMMAND\" failed!"; exit_with_error' ERR
+
+# Addresses get payload of their longest prefix, addresses without a prefix get default values
+start_tagger "$data_path/database1.csv"
+replay_input
+compare_result "$data_path/res1.csv"
+
+# The database is replaced on SIGHUP even when no records arrive
+cp "$data_path/database1.csv" "$database_copy"
+start_tagger "$database_copy"
+cp "$data_path/database2.csv" "$database_copy"
+kill -HUP $tagger_pid
+sleep 0.5
+replay_input
+compare_result "$data_path/res2.csv"
+rm -f "$database_copy"
+
+echo "All tests passed"
+exit 0
@@ -0,0 +1,100 @@
+/**
+ * @file
+ * @brief Implementation of the AdaptiveSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "adaptiveSamplingPolicy.hpp"
+#include "clockCheckPeriod.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Sampler {
+
+AdaptiveSamplingPolicy::AdaptiveSamplingPolicy(
+	double targetRate,
+	std::chrono::milliseconds windowDuration)
+	: M_TARGET_RATE(targetRate)
+	, M_BUCKET_DURATION(std::chrono::duration_cast<Clock::duration>(windowDuration) / BUCKETS_COUNT)
+	, m_bucketEnd(Clock::time_point::min())
+{
+}
+
+void AdaptiveSamplingPolicy::advanceWindow(Clock::time_point now) noexcept
+{
+	// Buckets without records are completed with zero count, at most the whole window is cleared
+	size_t advancedBucketsCount = 0;
+	while (now >= m_bucketEnd && advancedBucketsCount < BUCKETS_COUNT) {
+		m_currentBucket = (m_currentBucket + 1) % BUCKETS_COUNT;
+		m_bucketsCounts[m_currentBucket] = 0;
+		m_bucketEnd += M_BUCKET_DURATION;
+		advancedBucketsCount++;
+	}
+	if (now >= m_bucketEnd) {
+		m_bucketEnd = now + M_BUCKET_DURATION;
+	}
+
+	// The first record and the first record after an idle gap of the whole window start a new
+	// measurement, the rate is estimated from the current bucket until it is completed
+	if (advancedBucketsCount == BUCKETS_COUNT) {
+		m_completedBucketsCount = 0;
+		return;
+	}
+	m_completedBucketsCount
+		= std::min(m_completedBucketsCount + advancedBucketsCount, BUCKETS_COUNT - 1);
+
+	// Rate of the completed buckets, the current bucket is not completed yet
+	const uint64_t completedRecordsCount
+		= std::accumulate(m_bucketsCounts.begin(), m_bucketsCounts.end(), uint64_t {0})
+		- m_bucketsCounts[m_currentBucket];
+	const std::chrono::duration<double> completedDuration
+		= M_BUCKET_DURATION * m_completedBucketsCount;
+	updateSamplingProbability(
+		static_cast<double>(completedRecordsCount) / completedDuration.count());
+}
+
+void AdaptiveSamplingPolicy::estimateInitialRate(Clock::time_point now) noexcept
+{
+	const std::chrono::duration<double> elapsed = now - (m_bucketEnd - M_BUCKET_DURATION);
+	if (elapsed.count() > 0) {
+		updateSamplingProbability(
+			static_cast<double>(m_bucketsCounts[m_currentBucket]) / elapsed.count());
+	}
+}
+
+void AdaptiveSamplingPolicy::updateSamplingProbability(double inputRate) noexcept
+{
+	m_samplingProbability.store(
+		inputRate > M_TARGET_RATE ? M_TARGET_RATE / inputRate : 1.0,
+		std::memory_order_relaxed);
+}
+
+bool AdaptiveSamplingPolicy::isSelected(
+	[[maybe_unused]] const Nemea::UnirecRecordView& unirecRecordView)
+{
+	if (m_recordsCount++ % g_CLOCK_CHECK_PERIOD == 0) {
+		const Clock::time_point now = Clock::now();
+		if (now >= m_bucketEnd) {
+			advanceWindow(now);
+		} else if (m_completedBucketsCount == 0) {
+			estimateInitialRate(now);
+		}
+	}
+	m_bucketsCounts[m_currentBucket]++;
+
+	m_credit += m_samplingProbability.load(std::memory_order_relaxed);
+	if (m_credit >= 1.0) {
+		m_credit -= 1.0;
+		return true;
+	}
+	return false;
+}
+
+double AdaptiveSamplingPolicy::getSamplingRate() const noexcept
+{
+	return 1.0 / m_samplingProbability.load(std::memory_order_relaxed);
+}
+
+} // namespace Sampler
@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @brief Declaration of the AdaptiveSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "samplingPolicy.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Sampler {
+
+/**
+ * @brief Samples records to keep the output rate below the target rate.
+ *
+ * The input rate is measured over a sliding window divided into `BUCKETS_COUNT` buckets. When
+ * a bucket is completed, the sampling probability is set to the target rate divided by the input
+ * rate of the window, or to 1 if the input is slower than the target. Records are selected by
+ * accumulating the probability, so the fractional sampling rate is kept exactly. The window starts
+ * with the first record and again after an idle gap of the whole window. Until its first bucket
+ * is completed, the rate is estimated from the records of the current bucket.
+ */
+class AdaptiveSamplingPolicy : public SamplingPolicy {
+public:
+	/**
+	 * @brief Number of buckets of the sliding window.
+	 */
+	static inline const size_t BUCKETS_COUNT = 10;
+
+	/**
+	 * @brief Constructs the policy.
+	 * @param targetRate Target output rate in records per second.
+	 * @param windowDuration Duration of the sliding window of the input rate measurement.
+	 */
+	AdaptiveSamplingPolicy(double targetRate, std::chrono::milliseconds windowDuration);
+
+	/**
+	 * @brief Selects the record by the current sampling probability.
+	 * @param unirecRecordView The Unirec record, not used.
+	 * @return True if the record should be sampled, false otherwise.
+	 */
+	bool isSelected(const Nemea::UnirecRecordView& unirecRecordView) override;
+
+	/**
+	 * @brief Returns the current 1:r sampling rate.
+	 */
+	double getSamplingRate() const noexcept override;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void advanceWindow(Clock::time_point now) noexcept;
+	void estimateInitialRate(Clock::time_point now) noexcept;
+	void updateSamplingProbability(double inputRate) noexcept;
+
+	const double M_TARGET_RATE;
+	const Clock::duration M_BUCKET_DURATION;
+
+	std::array<uint64_t, BUCKETS_COUNT> m_bucketsCounts {};
+	size_t m_currentBucket = 0;
+	size_t m_completedBucketsCount = 0;
+	Clock::time_point m_bucketEnd;
+
+	uint64_t m_recordsCount = 0;
+	std::atomic<double> m_samplingProbability {1.0};
+	double m_credit = 0.0;
+};
+
+} // namespace Sampler
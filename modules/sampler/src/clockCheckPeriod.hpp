@@ -0,0 +1,23 @@
+/**
+ * @file
+ * @brief Period of reading the clock by the time driven sampling modes.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace Sampler {
+
+/**
+ * @brief The clock is read only for every n-th record.
+ *
+ * Adaptive, priority, reservoir and sample-and-hold modes depend on time. Reading the clock for
+ * every record would cost more than the sampling decision, so their time advances in steps of
+ * this number of records.
+ */
+static constexpr uint64_t g_CLOCK_CHECK_PERIOD = 64;
+
+} // namespace Sampler
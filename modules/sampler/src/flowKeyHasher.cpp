@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @brief Implementation of the FlowKeyHasher class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "flowKeyHasher.hpp"
+#include "unirec/unirecFieldId.hpp"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <unirec++/ipAddress.hpp>
+#include <utility>
+#include <xxhash.h>
+
+namespace Sampler {
+
+/**
+ * @brief Hashed bytes of the flow key: two addresses, two ports and the protocol.
+ */
+using FlowKeyBytes = std::array<std::byte, 2 * sizeof(ip_addr_t) + 2 * sizeof(uint16_t) + 1>;
+
+/**
+ * @brief Compares the endpoints by the address and then by the port.
+ */
+static bool isEndpointLower(
+	const ip_addr_t& address,
+	uint16_t port,
+	const ip_addr_t& otherAddress,
+	uint16_t otherPort) noexcept
+{
+	const int comparison = std::memcmp(&address, &otherAddress, sizeof(ip_addr_t));
+	return comparison < 0 || (comparison == 0 && port < otherPort);
+}
+
+FlowKeyHasher::FlowKeyHasher(FlowKeyType flowKeyType, uint64_t seed)
+	: M_FLOW_KEY_TYPE(flowKeyType)
+	, M_SEED(seed)
+{
+}
+
+std::string FlowKeyHasher::getUnirecTemplateDescription()
+{
+	return "ipaddr SRC_IP,ipaddr DST_IP,uint16 SRC_PORT,uint16 DST_PORT,uint8 PROTOCOL";
+}
+
+void FlowKeyHasher::updateUnirecIds()
+{
+	m_ids.srcIpId = Nm::getUnirecIdByName("SRC_IP");
+	m_ids.dstIpId = Nm::getUnirecIdByName("DST_IP");
+	m_ids.srcPortId = Nm::getUnirecIdByName("SRC_PORT");
+	m_ids.dstPortId = Nm::getUnirecIdByName("DST_PORT");
+	m_ids.protocolId = Nm::getUnirecIdByName("PROTOCOL");
+}
+
+uint64_t FlowKeyHasher::hash(const Nemea::UnirecRecordView& unirecRecordView) const
+{
+	ip_addr_t srcIp = unirecRecordView.getFieldAsType<Nemea::IpAddress>(m_ids.srcIpId).ip;
+	ip_addr_t dstIp = unirecRecordView.getFieldAsType<Nemea::IpAddress>(m_ids.dstIpId).ip;
+	uint16_t srcPort = unirecRecordView.getFieldAsType<uint16_t>(m_ids.srcPortId);
+	uint16_t dstPort = unirecRecordView.getFieldAsType<uint16_t>(m_ids.dstPortId);
+	const auto protocol = unirecRecordView.getFieldAsType<uint8_t>(m_ids.protocolId);
+
+	if (M_FLOW_KEY_TYPE == FlowKeyType::BIDIRECTIONAL
+		&& isEndpointLower(dstIp, dstPort, srcIp, srcPort)) {
+		std::swap(srcIp, dstIp);
+		std::swap(srcPort, dstPort);
+	}
+
+	// Fields are copied to a byte array, so no padding is hashed
+	FlowKeyBytes key;
+	size_t offset = 0;
+	auto append = [&key, &offset](const void* field, size_t size) {
+		std::memcpy(key.data() + offset, field, size);
+		offset += size;
+	};
+	append(&srcIp, sizeof(srcIp));
+	append(&dstIp, sizeof(dstIp));
+	append(&srcPort, sizeof(srcPort));
+	append(&dstPort, sizeof(dstPort));
+	append(&protocol, sizeof(protocol));
+
+	return XXH3_64bits_withSeed(key.data(), key.size(), M_SEED);
+}
+
+} // namespace Sampler
@@ -0,0 +1,66 @@
+/**
+ * @file
+ * @brief Declaration of the FlowKeyHasher class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unirec++/unirecRecordView.hpp>
+
+namespace Sampler {
+
+/**
+ * @brief Fields of the flow hashed by the FlowKeyHasher.
+ */
+enum class FlowKeyType : uint8_t {
+	UNIDIRECTIONAL, ///< Source and destination addresses and ports and the protocol.
+	BIDIRECTIONAL ///< As unidirectional, but a flow and its reverse flow have the same key.
+};
+
+/**
+ * @brief Hashes the flow key of records by the seeded xxHash.
+ */
+class FlowKeyHasher {
+public:
+	/**
+	 * @brief Constructs the hasher.
+	 * @param flowKeyType Fields of the flow key.
+	 * @param seed Seed of the hash function.
+	 */
+	FlowKeyHasher(FlowKeyType flowKeyType, uint64_t seed);
+
+	/**
+	 * @brief Get the Unirec template description of the flow key fields.
+	 */
+	static std::string getUnirecTemplateDescription();
+
+	/**
+	 * @brief Update Unirec Id of the flow key fields after template format change.
+	 */
+	void updateUnirecIds();
+
+	/**
+	 * @brief Returns the hash of the flow key of the record.
+	 * @param unirecRecordView The Unirec record.
+	 */
+	uint64_t hash(const Nemea::UnirecRecordView& unirecRecordView) const;
+
+private:
+	struct UnirecIds {
+		ur_field_id_t srcIpId;
+		ur_field_id_t dstIpId;
+		ur_field_id_t srcPortId;
+		ur_field_id_t dstPortId;
+		ur_field_id_t protocolId;
+	};
+
+	const FlowKeyType M_FLOW_KEY_TYPE;
+	const uint64_t M_SEED;
+	UnirecIds m_ids {};
+};
+
+} // namespace Sampler
@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @brief Implementation of the HashSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "hashSamplingPolicy.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace Sampler {
+
+FlowKeyType HashSamplingPolicy::convertStringToFlowKeyType(const std::string& str)
+{
+	if (str == "5tuple") {
+		return FlowKeyType::UNIDIRECTIONAL;
+	}
+	if (str == "biflow") {
+		return FlowKeyType::BIDIRECTIONAL;
+	}
+	throw std::runtime_error("Unknown flow key. Only allowed values are 5tuple and biflow");
+}
+
+HashSamplingPolicy::HashSamplingPolicy(
+	std::size_t samplingRate,
+	FlowKeyType flowKeyType,
+	uint64_t seed)
+	: M_SAMPLING_RATE(samplingRate)
+	, M_THRESHOLD(std::numeric_limits<uint64_t>::max() / samplingRate)
+	, m_flowKeyHasher(flowKeyType, seed)
+{
+}
+
+double HashSamplingPolicy::getSamplingRate() const noexcept
+{
+	return static_cast<double>(M_SAMPLING_RATE);
+}
+
+std::string HashSamplingPolicy::getUnirecTemplateDescription() const
+{
+	return FlowKeyHasher::getUnirecTemplateDescription();
+}
+
+void HashSamplingPolicy::updateUnirecIds()
+{
+	m_flowKeyHasher.updateUnirecIds();
+}
+
+bool HashSamplingPolicy::isSelected(const Nemea::UnirecRecordView& unirecRecordView)
+{
+	return m_flowKeyHasher.hash(unirecRecordView) <= M_THRESHOLD;
+}
+
+} // namespace Sampler
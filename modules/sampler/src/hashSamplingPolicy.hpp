@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @brief Declaration of the HashSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "flowKeyHasher.hpp"
+#include "samplingPolicy.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unirec++/unirecRecordView.hpp>
+
+namespace Sampler {
+
+/**
+ * @brief Samples flows by the hash of their key.
+ *
+ * A record is sampled when the seeded xxHash of its flow key is below 2^64/r. All records of
+ * a flow are sampled or dropped together, and instances with the same rate and seed sample
+ * the same flows, so the sampling can be coordinated across sensors.
+ */
+class HashSamplingPolicy : public SamplingPolicy {
+public:
+	/**
+	 * @brief Converts string to the flow key type.
+	 * @param str String `5tuple` or `biflow`.
+	 * @return The flow key type.
+	 * @throw std::runtime_error If the string is not a known flow key type.
+	 */
+	static FlowKeyType convertStringToFlowKeyType(const std::string& str);
+
+	/**
+	 * @brief Constructs the policy.
+	 * @param samplingRate The 1:r rate at which flows should be sampled.
+	 * @param flowKeyType Fields of the flow key.
+	 * @param seed Seed of the hash function.
+	 */
+	HashSamplingPolicy(std::size_t samplingRate, FlowKeyType flowKeyType, uint64_t seed);
+
+	/**
+	 * @brief Selects the record if the hash of its flow key is below the threshold.
+	 * @param unirecRecordView The Unirec record.
+	 * @return True if the record should be sampled, false otherwise.
+	 */
+	bool isSelected(const Nemea::UnirecRecordView& unirecRecordView) override;
+
+	/**
+	 * @brief Returns the 1:r sampling rate.
+	 */
+	double getSamplingRate() const noexcept override;
+
+	std::string getUnirecTemplateDescription() const override;
+
+	void updateUnirecIds() override;
+
+private:
+	const std::size_t M_SAMPLING_RATE;
+	const uint64_t M_THRESHOLD;
+	FlowKeyHasher m_flowKeyHasher;
+};
+
+} // namespace Sampler
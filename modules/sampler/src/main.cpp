@@ -12,22 +12,54 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include "adaptiveSamplingPolicy.hpp"
+#include "hashSamplingPolicy.hpp"
+#include "instrumentation/processingLatency.hpp"
 #include "logger/logger.hpp"
+#include "prioritySamplingPolicy.hpp"
+#include "randomSamplingPolicy.hpp"
+#include "reservoirSampler.hpp"
+#include "sampleAndHoldSamplingPolicy.hpp"
 #include "sampler.hpp"
+#include "stratifiedSamplingPolicy.hpp"
+#include "systematicSamplingPolicy.hpp"
 #include "unirec/unirec-telemetry.hpp"
 
 #include <appFs.hpp>
 #include <argparse/argparse.hpp>
+#include <algorithm>
 #include <atomic>
+#include <charconv>
+#include <chrono>
 #include <csignal>
 #include <iostream>
+#include <libtrap/trap.h>
+#include <memory>
+#include <random>
 #include <stdexcept>
+#include <string>
 #include <telemetry.hpp>
 #include <unirec++/unirec.hpp>
+#include <vector>
 
 using namespace Nemea;
 
 static std::atomic<bool> g_stopFlag(false);
+static Nm::ProcessingLatency g_processingLatency;
+static Nm::SendStats g_sendStats;
+
+/**
+ * @brief Name of the field with the sampling rate added to forwarded records.
+ */
+static const std::string g_SAMPLING_RATE_FIELD = "SAMPLING_RATE";
+
+/**
+ * @brief Receive timeout of the reservoir mode in microseconds.
+ *
+ * When no record is received within the timeout, the end of the window is checked, so the
+ * reservoir is flushed on time even on slow inputs.
+ */
+static const int g_RESERVOIR_RECEIVE_TIMEOUT = 100000;
 
 static void signalHandler(int signum)
 {
@@ -42,10 +74,13 @@ static void signalHandler(int signum)
  * It adjusts the template in the bidirectional interface to handle the format change.
  *
  * @param biInterface Bidirectional interface for Unirec communication.
+ * @param sampler Sampler class for sampling.
  */
-static void handleFormatChange(UnirecBidirectionalInterface& biInterface)
+static void
+handleFormatChange(UnirecBidirectionalInterface& biInterface, Sampler::Sampler& sampler)
 {
 	biInterface.changeTemplate();
+	sampler.updateUnirecIds();
 }
 
 /**
@@ -60,13 +95,19 @@ static void handleFormatChange(UnirecBidirectionalInterface& biInterface)
 
 static void processNextRecord(UnirecBidirectionalInterface& biInterface, Sampler::Sampler& sampler)
 {
+	Nm::PhaseTimer phaseTimer;
 	std::optional<UnirecRecordView> unirecRecord = biInterface.receive();
 	if (!unirecRecord) {
 		return;
 	}
+	phaseTimer.lap(g_processingLatency.receive);
+
+	const bool isSampled = sampler.shouldBeSampled(*unirecRecord);
+	phaseTimer.lap(g_processingLatency.process);
 
-	if (sampler.shouldBeSampled()) {
-		biInterface.send(*unirecRecord);
+	if (isSampled) {
+		g_sendStats.send(biInterface, *unirecRecord);
+		phaseTimer.lap(g_processingLatency.send);
 	}
 }
 
@@ -87,7 +128,331 @@ processUnirecRecords(UnirecBidirectionalInterface& biInterface, Sampler::Sampler
 		try {
 			processNextRecord(biInterface, sampler);
 		} catch (FormatChangeException& ex) {
-			handleFormatChange(biInterface);
+			handleFormatChange(biInterface, sampler);
+		} catch (EoFException& ex) {
+			break;
+		} catch (std::exception& ex) {
+			throw;
+		}
+	}
+}
+
+/**
+ * @brief Output with the sampling rate field.
+ */
+struct SamplingRateOutput {
+	UnirecOutputInterface& interface; ///< Output interface.
+	std::optional<UnirecRecord> record; ///< Output record, created on the format change.
+	ur_field_id_t samplingRateId; ///< Id of the field with the sampling rate.
+};
+
+/**
+ * @brief Returns the format of the input interface.
+ * @throw std::runtime_error If the format can not be read.
+ */
+static std::string getInputSpecification()
+{
+	uint8_t dataType;
+	const char* inputSpecification = nullptr;
+	if (trap_get_data_fmt(TRAPIFC_INPUT, 0, &dataType, &inputSpecification) != TRAP_E_OK) {
+		throw std::runtime_error("Unable to get the format of the input interface");
+	}
+	return inputSpecification;
+}
+
+/**
+ * @brief Returns the format extended by the sampling rate field if it does not contain it.
+ * @param specification Format of the input interface.
+ */
+static std::string addSamplingRateField(std::string specification)
+{
+	if (("," + specification + ",").find(" " + g_SAMPLING_RATE_FIELD + ",") == std::string::npos) {
+		specification += ",double " + g_SAMPLING_RATE_FIELD;
+	}
+	return specification;
+}
+
+/**
+ * @brief Handle a format change exception when the sampling rate field is added.
+ *
+ * The output template is the input template extended by the field with the sampling rate.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output with the sampling rate field.
+ * @param sampler Sampler class for sampling.
+ */
+static void handleFormatChange(
+	UnirecInputInterface& inputInterface,
+	SamplingRateOutput& output,
+	Sampler::Sampler& sampler)
+{
+	inputInterface.changeTemplate();
+	sampler.updateUnirecIds();
+
+	output.interface.changeTemplate(addSamplingRateField(getInputSpecification()));
+	output.record.emplace(output.interface.createUnirecRecord());
+	output.samplingRateId
+		= static_cast<ur_field_id_t>(ur_get_id_by_name(g_SAMPLING_RATE_FIELD.c_str()));
+}
+
+/**
+ * @brief Process the next Unirec record and forward it with the sampling rate if it is sampled.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output with the sampling rate field.
+ * @param sampler Sampler class for sampling.
+ */
+static void processNextRecord(
+	UnirecInputInterface& inputInterface,
+	SamplingRateOutput& output,
+	Sampler::Sampler& sampler)
+{
+	Nm::PhaseTimer phaseTimer;
+	std::optional<UnirecRecordView> unirecRecord = inputInterface.receive();
+	if (!unirecRecord) {
+		return;
+	}
+	phaseTimer.lap(g_processingLatency.receive);
+
+	const bool isSampled = sampler.shouldBeSampled(*unirecRecord);
+	phaseTimer.lap(g_processingLatency.process);
+
+	if (isSampled) {
+		output.record->copyFieldsFrom(*unirecRecord);
+		output.record->setFieldFromType(
+			sampler.getSelectedRecordSamplingRate(),
+			output.samplingRateId);
+		output.interface.send(*output.record);
+		phaseTimer.lap(g_processingLatency.send);
+	}
+}
+
+/**
+ * @brief Process Unirec records and forward the sampled ones with the sampling rate.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output with the sampling rate field.
+ * @param sampler Sampler class for sampling.
+ */
+static void processUnirecRecords(
+	UnirecInputInterface& inputInterface,
+	SamplingRateOutput& output,
+	Sampler::Sampler& sampler)
+{
+	while (!g_stopFlag.load()) {
+		try {
+			processNextRecord(inputInterface, output, sampler);
+		} catch (FormatChangeException& ex) {
+			handleFormatChange(inputInterface, output, sampler);
+		} catch (EoFException& ex) {
+			break;
+		} catch (std::exception& ex) {
+			throw;
+		}
+	}
+}
+
+/**
+ * @brief Output forwarding records, optionally extended by the sampling rate field.
+ */
+struct ForwardingOutput {
+	UnirecOutputInterface& interface; ///< Output interface.
+	bool hasSamplingRateField; ///< True if the sampling rate field is added.
+	std::optional<UnirecRecord> record; ///< Output record with the sampling rate field.
+	ur_field_id_t samplingRateId; ///< Id of the field with the sampling rate.
+};
+
+/**
+ * @brief Forward the sampled record, with the sampling rate if the field is added.
+ *
+ * @param output Output forwarding the records.
+ * @param unirecRecord Sampled Unirec record.
+ * @param samplingRate The 1:r sampling rate of the record.
+ */
+static void sendRecord(
+	ForwardingOutput& output,
+	UnirecRecordView& unirecRecord,
+	double samplingRate)
+{
+	if (!output.hasSamplingRateField) {
+		output.interface.send(unirecRecord);
+		return;
+	}
+
+	output.record->copyFieldsFrom(unirecRecord);
+	output.record->setFieldFromType(samplingRate, output.samplingRateId);
+	output.interface.send(*output.record);
+}
+
+/**
+ * @brief Change the output template after the input template has changed.
+ *
+ * The output template is the input template, extended by the sampling rate field if it is added.
+ *
+ * @param output Output forwarding the records.
+ */
+static void changeOutputTemplate(ForwardingOutput& output)
+{
+	if (!output.hasSamplingRateField) {
+		output.interface.changeTemplate(getInputSpecification());
+		return;
+	}
+
+	output.interface.changeTemplate(addSamplingRateField(getInputSpecification()));
+	output.record.emplace(output.interface.createUnirecRecord());
+	output.samplingRateId
+		= static_cast<ur_field_id_t>(ur_get_id_by_name(g_SAMPLING_RATE_FIELD.c_str()));
+}
+
+/**
+ * @brief Handle a format change exception in the reservoir mode.
+ *
+ * Records of the reservoir are flushed with the old template first.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output of the reservoir mode.
+ * @param reservoirSampler ReservoirSampler class for sampling.
+ */
+static void handleFormatChange(
+	UnirecInputInterface& inputInterface,
+	ForwardingOutput& output,
+	Sampler::ReservoirSampler& reservoirSampler)
+{
+	reservoirSampler.changeTemplate();
+	inputInterface.changeTemplate();
+	changeOutputTemplate(output);
+}
+
+/**
+ * @brief Process the next Unirec record by the reservoir.
+ *
+ * When no record is received within the timeout, the end of the window is checked.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param reservoirSampler ReservoirSampler class for sampling.
+ */
+static void processNextRecord(
+	UnirecInputInterface& inputInterface,
+	Sampler::ReservoirSampler& reservoirSampler)
+{
+	Nm::PhaseTimer phaseTimer;
+	std::optional<UnirecRecordView> unirecRecord = inputInterface.receive();
+	if (!unirecRecord) {
+		reservoirSampler.checkWindow();
+		return;
+	}
+	phaseTimer.lap(g_processingLatency.receive);
+
+	// Records are sent when the window is flushed, the send phase is timed by the callback
+	reservoirSampler.process(*unirecRecord);
+	phaseTimer.lap(g_processingLatency.process);
+}
+
+/**
+ * @brief Process Unirec records in the reservoir mode.
+ *
+ * The reservoir is flushed at the end of each window and when the loop ends.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param output Output of the reservoir mode.
+ * @param reservoirSampler ReservoirSampler class for sampling.
+ */
+static void processUnirecRecords(
+	UnirecInputInterface& inputInterface,
+	ForwardingOutput& output,
+	Sampler::ReservoirSampler& reservoirSampler)
+{
+	inputInterface.setReceiveTimeout(g_RESERVOIR_RECEIVE_TIMEOUT);
+
+	while (!g_stopFlag.load()) {
+		try {
+			processNextRecord(inputInterface, reservoirSampler);
+		} catch (FormatChangeException& ex) {
+			handleFormatChange(inputInterface, output, reservoirSampler);
+		} catch (EoFException& ex) {
+			break;
+		} catch (std::exception& ex) {
+			throw;
+		}
+	}
+
+	reservoirSampler.flush();
+}
+
+/**
+ * @brief Output of the fan-out mode with its own sampler.
+ */
+struct FanOutOutput {
+	ForwardingOutput output; ///< Output forwarding the sampled records.
+	Sampler::Sampler sampler; ///< Sampler of the output.
+};
+
+/**
+ * @brief Handle a format change exception in the fan-out mode.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param fanOutOutputs Outputs with their samplers.
+ */
+static void handleFormatChange(
+	UnirecInputInterface& inputInterface,
+	std::vector<FanOutOutput>& fanOutOutputs)
+{
+	inputInterface.changeTemplate();
+	for (auto& fanOutOutput : fanOutOutputs) {
+		fanOutOutput.sampler.updateUnirecIds();
+		changeOutputTemplate(fanOutOutput.output);
+	}
+}
+
+/**
+ * @brief Process the next Unirec record and forward it to each output whose sampler selects it.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param fanOutOutputs Outputs with their samplers.
+ */
+static void processNextRecord(
+	UnirecInputInterface& inputInterface,
+	std::vector<FanOutOutput>& fanOutOutputs)
+{
+	Nm::PhaseTimer phaseTimer;
+	std::optional<UnirecRecordView> unirecRecord = inputInterface.receive();
+	if (!unirecRecord) {
+		return;
+	}
+	phaseTimer.lap(g_processingLatency.receive);
+
+	// Each output adds its own process and send phases
+	for (auto& fanOutOutput : fanOutOutputs) {
+		const bool isSampled = fanOutOutput.sampler.shouldBeSampled(*unirecRecord);
+		phaseTimer.lap(g_processingLatency.process);
+
+		if (isSampled) {
+			sendRecord(
+				fanOutOutput.output,
+				*unirecRecord,
+				fanOutOutput.sampler.getSelectedRecordSamplingRate());
+			phaseTimer.lap(g_processingLatency.send);
+		}
+	}
+}
+
+/**
+ * @brief Process Unirec records in the fan-out mode.
+ *
+ * Each record is received once and sampled independently by the sampler of each output.
+ *
+ * @param inputInterface Input interface for Unirec communication.
+ * @param fanOutOutputs Outputs with their samplers.
+ */
+static void processUnirecRecords(
+	UnirecInputInterface& inputInterface,
+	std::vector<FanOutOutput>& fanOutOutputs)
+{
+	while (!g_stopFlag.load()) {
+		try {
+			processNextRecord(inputInterface, fanOutOutputs);
+		} catch (FormatChangeException& ex) {
+			handleFormatChange(inputInterface, fanOutOutputs);
 		} catch (EoFException& ex) {
 			break;
 		} catch (std::exception& ex) {
@@ -96,6 +461,19 @@ processUnirecRecords(UnirecBidirectionalInterface& biInterface, Sampler::Sampler
 	}
 }
 
+static telemetry::Content getReservoirTelemetry(const Sampler::ReservoirSampler& reservoirSampler)
+{
+	auto stats = reservoirSampler.getStats();
+
+	telemetry::Dict dict;
+	dict["totalRecords"] = stats.totalRecords;
+	dict["sampledRecords"] = stats.sampledRecords;
+	dict["samplingRate"] = stats.samplingRate;
+	dict["windowRecords"] = stats.windowRecords;
+	dict["windowFill"] = stats.windowFill;
+	return dict;
+}
+
 static telemetry::Content getSamplerTelemetry(const Sampler::Sampler& sampler)
 {
 	auto stats = sampler.getStats();
@@ -103,14 +481,282 @@ static telemetry::Content getSamplerTelemetry(const Sampler::Sampler& sampler)
 	telemetry::Dict dict;
 	dict["totalRecords"] = stats.totalRecords;
 	dict["sampledRecords"] = stats.sampledRecords;
+	dict["samplingRate"] = stats.samplingRate;
 	return dict;
 }
 
+/**
+ * @brief Returns the 1:r sampling rate given by the command line arguments.
+ * @param program Parsed command line arguments.
+ * @throw std::runtime_error If the rate is not given or it is not positive.
+ */
+static std::size_t getSamplingRate(const argparse::ArgumentParser& program)
+{
+	const auto samplingRate = program.present<int>("--rate");
+	if (!samplingRate || *samplingRate <= 0) {
+		throw std::runtime_error("Sampling rate must be specified and higher than zero");
+	}
+	return static_cast<std::size_t>(*samplingRate);
+}
+
+/**
+ * @brief Returns the target output rate given by the command line arguments.
+ * @param program Parsed command line arguments.
+ * @throw std::runtime_error If the target rate is not given or it is not positive.
+ */
+static double getTargetRate(const argparse::ArgumentParser& program)
+{
+	const auto targetRate = program.present<int>("--target-rate");
+	if (!targetRate || *targetRate <= 0) {
+		throw std::runtime_error("Target rate must be specified and higher than zero");
+	}
+	return static_cast<double>(*targetRate);
+}
+
+/**
+ * @brief Returns the rate measurement window given by the command line arguments.
+ * @param program Parsed command line arguments.
+ * @throw std::runtime_error If the window is not positive.
+ */
+static std::chrono::milliseconds getWindow(const argparse::ArgumentParser& program)
+{
+	const int windowDuration = program.get<int>("--window");
+	if (windowDuration <= 0) {
+		throw std::runtime_error("Window must be higher than zero");
+	}
+	return std::chrono::milliseconds(windowDuration);
+}
+
+/**
+ * @brief Returns the reservoir size given by the command line arguments.
+ * @param program Parsed command line arguments.
+ * @throw std::runtime_error If the reservoir size is not given or it is not positive.
+ */
+static std::size_t getReservoirSize(const argparse::ArgumentParser& program)
+{
+	const auto reservoirSize = program.present<int>("--reservoir-size");
+	if (!reservoirSize || *reservoirSize <= 0) {
+		throw std::runtime_error("Reservoir size must be specified and higher than zero");
+	}
+	return static_cast<std::size_t>(*reservoirSize);
+}
+
+/**
+ * @brief Returns the seed given by the command line arguments or a random seed.
+ * @param program Parsed command line arguments.
+ */
+static uint64_t getSeedOrRandom(const argparse::ArgumentParser& program)
+{
+	const auto seed = program.present<uint64_t>("--seed");
+	return seed ? *seed : std::random_device()();
+}
+
+/**
+ * @brief Returns the exponent of the flow cache size given by the command line arguments.
+ * @param program Parsed command line arguments.
+ * @throw std::runtime_error If the cache size is less than 2^3 flows.
+ */
+static uint32_t getHoldSize(const argparse::ArgumentParser& program)
+{
+	const auto holdSize = program.get<uint32_t>("--hold-size");
+	if (holdSize < 3) {
+		throw std::runtime_error("Flow cache size must be at least 8");
+	}
+	return holdSize;
+}
+
+/**
+ * @brief Returns the timeout of held flows given by the command line arguments.
+ * @param program Parsed command line arguments.
+ * @throw std::runtime_error If the timeout is not positive.
+ */
+static std::chrono::milliseconds getHoldTimeout(const argparse::ArgumentParser& program)
+{
+	const int holdTimeout = program.get<int>("--hold-timeout");
+	if (holdTimeout <= 0) {
+		throw std::runtime_error("Flow timeout must be higher than zero");
+	}
+	return std::chrono::milliseconds(holdTimeout);
+}
+
+/**
+ * @brief Creates the sampling policy of a mode sampling by the 1:r rate.
+ * @param program Parsed command line arguments with other parameters of the mode.
+ * @param mode The sampling mode.
+ * @param samplingRate The 1:r sampling rate.
+ * @return The sampling policy.
+ * @throw std::runtime_error If the mode is not a mode sampling by the rate.
+ */
+static std::unique_ptr<Sampler::SamplingPolicy> createSamplingPolicy(
+	const argparse::ArgumentParser& program,
+	const std::string& mode,
+	std::size_t samplingRate)
+{
+	if (mode == "systematic") {
+		return std::make_unique<Sampler::SystematicSamplingPolicy>(samplingRate);
+	}
+	if (mode == "hash") {
+		return std::make_unique<Sampler::HashSamplingPolicy>(
+			samplingRate,
+			Sampler::HashSamplingPolicy::convertStringToFlowKeyType(
+				program.get<std::string>("--flow-key")),
+			program.present<uint64_t>("--seed").value_or(0));
+	}
+	if (mode == "random") {
+		return std::make_unique<Sampler::RandomSamplingPolicy>(
+			samplingRate,
+			getSeedOrRandom(program));
+	}
+	if (mode == "stratified") {
+		const auto strataFilename = program.present<std::string>("--strata");
+		if (!strataFilename) {
+			throw std::runtime_error("Strata file must be specified in the stratified mode");
+		}
+		return std::make_unique<Sampler::StratifiedSamplingPolicy>(*strataFilename, samplingRate);
+	}
+	if (mode == "hold") {
+		return std::make_unique<Sampler::SampleAndHoldSamplingPolicy>(
+			samplingRate,
+			Sampler::HashSamplingPolicy::convertStringToFlowKeyType(
+				program.get<std::string>("--flow-key")),
+			getHoldSize(program),
+			getHoldTimeout(program),
+			getSeedOrRandom(program));
+	}
+	throw std::runtime_error("Unknown sampling mode '" + mode + "'");
+}
+
+/**
+ * @brief Creates the sampling policy selected by the command line arguments.
+ * @param program Parsed command line arguments.
+ * @return The sampling policy.
+ */
+static std::unique_ptr<Sampler::SamplingPolicy>
+createSamplingPolicy(const argparse::ArgumentParser& program)
+{
+	const auto mode = program.get<std::string>("--mode");
+	if (mode == "adaptive") {
+		return std::make_unique<Sampler::AdaptiveSamplingPolicy>(
+			getTargetRate(program),
+			getWindow(program));
+	}
+	if (mode == "priority") {
+		return std::make_unique<Sampler::PrioritySamplingPolicy>(
+			program.get<std::string>("--weight-field"),
+			getTargetRate(program),
+			getWindow(program),
+			getSeedOrRandom(program));
+	}
+
+	if (mode != "systematic" && mode != "hash" && mode != "random" && mode != "stratified"
+		&& mode != "hold") {
+		throw std::runtime_error(
+			"Unknown sampling mode. Only allowed values are systematic, hash, random, adaptive, "
+			"priority, stratified, reservoir and hold");
+	}
+	return createSamplingPolicy(program, mode, getSamplingRate(program));
+}
+
+/**
+ * @brief Splits the comma separated list.
+ * @param list Comma separated items, e.g. `mode:rate` policies of the fan-out outputs.
+ * @return Non-empty items of the list.
+ */
+static std::vector<std::string> splitList(const std::string& list)
+{
+	std::vector<std::string> items;
+	size_t begin = 0;
+	while (begin <= list.size()) {
+		const size_t end = std::min(list.find(',', begin), list.size());
+		if (end != begin) {
+			items.emplace_back(list.substr(begin, end - begin));
+		}
+		begin = end + 1;
+	}
+	return items;
+}
+
+/**
+ * @brief Returns the number of output interfaces.
+ *
+ * The number of interfaces must be known before the Unirec interfaces are initialized, so the
+ * fan-out option is looked up before the command line arguments are parsed.
+ *
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments.
+ * @return Number of outputs of the fan-out mode, 1 without the fan-out option.
+ */
+static int getOutputInterfacesCount(int argc, char** argv)
+{
+	static const std::string g_FAN_OUT_OPTION = "--fan-out";
+	for (int index = 1; index < argc; index++) {
+		const std::string argument = argv[index];
+		if (argument == g_FAN_OUT_OPTION && index + 1 < argc) {
+			return std::max(static_cast<int>(splitList(argv[index + 1]).size()), 1);
+		}
+		if (argument.rfind(g_FAN_OUT_OPTION + "=", 0) == 0) {
+			const std::string fanOut = argument.substr(g_FAN_OUT_OPTION.size() + 1);
+			return std::max(static_cast<int>(splitList(fanOut).size()), 1);
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief Creates the sampling policy of the output of the fan-out mode.
+ * @param program Parsed command line arguments with other parameters of the mode.
+ * @param outputSpecification The `mode:rate` specification of the output.
+ * @return The sampling policy.
+ * @throw std::runtime_error If the specification is not valid.
+ */
+static std::unique_ptr<Sampler::SamplingPolicy> createFanOutSamplingPolicy(
+	const argparse::ArgumentParser& program,
+	const std::string& outputSpecification)
+{
+	const size_t delimiterPosition = outputSpecification.find(':');
+	if (delimiterPosition == std::string::npos) {
+		throw std::runtime_error(
+			"Invalid fan-out output '" + outputSpecification + "', expected mode:rate");
+	}
+
+	const std::string rate = outputSpecification.substr(delimiterPosition + 1);
+	std::size_t samplingRate = 0;
+	const auto [end, errorCode]
+		= std::from_chars(rate.data(), rate.data() + rate.size(), samplingRate);
+	if (errorCode != std::errc {} || end != rate.data() + rate.size() || samplingRate == 0) {
+		throw std::runtime_error("Invalid sampling rate of fan-out output '" + rate + "'");
+	}
+
+	return createSamplingPolicy(
+		program,
+		outputSpecification.substr(0, delimiterPosition),
+		samplingRate);
+}
+
+/**
+ * @brief Joins template descriptions of fields required by samplers, each field only once.
+ * @param fanOutOutputs Outputs with their samplers.
+ * @return Template description of the required fields.
+ */
+static std::string getRequiredUnirecTemplate(const std::vector<FanOutOutput>& fanOutOutputs)
+{
+	std::string requiredUnirecTemplate;
+	for (const auto& fanOutOutput : fanOutOutputs) {
+		for (const auto& field : splitList(fanOutOutput.sampler.getUnirecTemplateDescription())) {
+			if (("," + requiredUnirecTemplate + ",").find("," + field + ",") == std::string::npos) {
+				requiredUnirecTemplate += (requiredUnirecTemplate.empty() ? "" : ",") + field;
+			}
+		}
+	}
+	return requiredUnirecTemplate;
+}
+
 int main(int argc, char** argv)
 {
 	argparse::ArgumentParser program("Unirec Sampler");
 
-	Unirec unirec({1, 1, "sampler", "Unirec sampling module"});
+	const int outputInterfacesCount = getOutputInterfacesCount(argc, argv);
+	Unirec unirec({1, outputInterfacesCount, "sampler", "Unirec sampling module"});
 
 	Nm::loggerInit();
 	auto logger = Nm::loggerGet("main");
@@ -119,10 +765,73 @@ int main(int argc, char** argv)
 
 	try {
 		program.add_argument("-r", "--rate")
-			.required()
-			.help(
-				"Specify the sampling rate 1:r. Every -rth sample will be forwarded to the output.")
+			.help("Specify the sampling rate 1:r. Every -rth sample will be forwarded to the "
+				  "output. Required in the systematic, hash, random, stratified and hold modes. In "
+				  "the stratified mode it is the rate of records matching no stratum")
+			.scan<'i', int>();
+		program.add_argument("--mode")
+			.help("Specify the sampling mode: systematic (every r-th record), hash (flows with "
+				  "the hash of the flow key below 2^64/r), random (each record with probability "
+				  "1/r), adaptive (records are sampled to keep the target output rate), priority "
+				  "(each record with probability proportional to its weight, keeping the target "
+				  "output rate), stratified (every r-th record of each stratum), reservoir (a "
+				  "fixed number of uniformly sampled records of each window) or hold (flows with "
+				  "probability 1/r per record, with all their following records). Default is "
+				  "systematic")
+			.default_value(std::string("systematic"));
+		program.add_argument("--flow-key")
+			.help("Specify the flow key of the hash and hold modes: 5tuple or biflow (a flow and "
+				  "its reverse flow have the same key). Default is 5tuple")
+			.default_value(std::string("5tuple"));
+		program.add_argument("--seed")
+			.help("Specify the seed of the hash, random, priority, reservoir and hold modes. "
+				  "Sensors with the same rate and seed sample the same flows in the hash mode. "
+				  "Default is 0 in the hash mode and a random seed in the other modes")
+			.scan<'u', uint64_t>();
+		program.add_argument("--target-rate")
+			.help("Specify the target output rate of the adaptive and priority modes in records "
+				  "per second")
+			.scan<'i', int>();
+		program.add_argument("--window")
+			.help("Specify the window of the rate measurement of the adaptive and priority modes "
+				  "and the window of the reservoir mode in milliseconds. Default is 1000")
+			.default_value(1000)
+			.scan<'i', int>();
+		program.add_argument("--weight-field")
+			.help("Specify the uint64 field with the weight of records in the priority mode. "
+				  "Default is BYTES")
+			.default_value(std::string("BYTES"));
+		program.add_argument("--reservoir-size")
+			.help("Specify the number of records sampled from each window in the reservoir mode")
 			.scan<'i', int>();
+		program.add_argument("--hold-size")
+			.help("Specify the exponent N of the flow cache size (2^N flows) in the hold mode. "
+				  "Default is 20")
+			.default_value(
+				Sampler::SampleAndHoldSamplingPolicy::FlowCache::TimeoutHashMapParameters::
+					DEFAULT_HASHMAP_EXPONENT)
+			.scan<'u', uint32_t>();
+		program.add_argument("--hold-timeout")
+			.help("Specify the time in milliseconds after the last record of a held flow when "
+				  "the flow is released in the hold mode. Default is 30000")
+			.default_value(30000)
+			.scan<'i', int>();
+		program.add_argument("--strata")
+			.help("Specify the CSV file with strata of the stratified mode and their sampling "
+				  "rates. Records matching no stratum are sampled by the rate -r")
+			.metavar("csv_file");
+		program.add_argument("--fan-out")
+			.help("Specify comma separated mode:rate policies of output interfaces, e.g. "
+				  "random:10,hash:100. Each record is received once and forwarded to each output "
+				  "whose policy samples it. Allowed modes are systematic, hash, random, "
+				  "stratified and hold, the --mode and --rate are not used")
+			.metavar("policies");
+		program.add_argument("--sampling-rate-field")
+			.help("Write the sampling rate 1:r of each forwarded record, its weight in estimates "
+				  "of counts and volumes, to the SAMPLING_RATE field. Always written in the "
+				  "priority mode")
+			.default_value(false)
+			.implicit_value(true);
 		program.add_argument("-m", "--appfs-mountpoint")
 			.required()
 			.help("path where the appFs directory will be mounted")
@@ -151,6 +860,8 @@ int main(int argc, char** argv)
 
 	std::shared_ptr<telemetry::Directory> telemetryRootDirectory;
 	telemetryRootDirectory = telemetry::Directory::create();
+	const auto latencyFile
+		= Nm::addProcessingLatencyFile(telemetryRootDirectory, g_processingLatency);
 
 	std::unique_ptr<telemetry::appFs::AppFsFuse> appFs;
 
@@ -171,26 +882,157 @@ int main(int argc, char** argv)
 		return EXIT_FAILURE;
 	}
 
-	try {
-		const int samplingRate = program.get<int>("--rate");
-		if (samplingRate <= 0) {
-			std::cerr << "Sampling rate must be higher than zero.\n";
+	const auto fanOut = program.present<std::string>("--fan-out");
+	if (fanOut) {
+		try {
+			const auto outputSpecifications = splitList(*fanOut);
+			if (outputSpecifications.empty()) {
+				throw std::runtime_error("At least one fan-out output must be specified");
+			}
+
+			UnirecInputInterface inputInterface = unirec.buildInputInterface();
+			std::vector<UnirecOutputInterface> outputInterfaces;
+			outputInterfaces.reserve(outputSpecifications.size());
+			std::vector<FanOutOutput> fanOutOutputs;
+			fanOutOutputs.reserve(outputSpecifications.size());
+			for (const auto& outputSpecification : outputSpecifications) {
+				outputInterfaces.emplace_back(unirec.buildOutputInterface());
+				fanOutOutputs.push_back(
+					{{outputInterfaces.back(),
+					  program.get<bool>("--sampling-rate-field"),
+					  std::nullopt,
+					  0},
+					 Sampler::Sampler(createFanOutSamplingPolicy(program, outputSpecification))});
+			}
+
+			const std::string requiredUnirecTemplate = getRequiredUnirecTemplate(fanOutOutputs);
+			if (!requiredUnirecTemplate.empty()) {
+				inputInterface.setRequieredFormat(requiredUnirecTemplate);
+			}
+
+			auto telemetrySamplerDirectory = telemetryRootDirectory->addDir("sampler");
+			std::vector<std::shared_ptr<telemetry::File>> samplerFiles;
+			for (size_t outputIndex = 0; outputIndex < fanOutOutputs.size(); outputIndex++) {
+				auto& sampler = fanOutOutputs[outputIndex].sampler;
+				auto telemetryOutputDirectory
+					= telemetrySamplerDirectory->addDir("output" + std::to_string(outputIndex));
+				const telemetry::FileOps samplerFileOps
+					= {[&sampler]() { return getSamplerTelemetry(sampler); }, nullptr};
+				samplerFiles.emplace_back(
+					telemetryOutputDirectory->addFile("stats", samplerFileOps));
+				sampler.setTelemetryDirectory(telemetryOutputDirectory);
+			}
+
+			auto telemetryInputDirectory = telemetryRootDirectory->addDir("input");
+			const Nm::InterfaceRatesSampler ratesSampler(inputInterface);
+			const telemetry::FileOps inputFileOps
+				= {[&inputInterface, &ratesSampler]() {
+					   return Nm::getInterfaceTelemetry(inputInterface, ratesSampler);
+				   },
+				   nullptr};
+			const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
+
+			processUnirecRecords(inputInterface, fanOutOutputs);
+		} catch (std::exception& ex) {
+			logger->error(ex.what());
 			return EXIT_FAILURE;
 		}
+		return EXIT_SUCCESS;
+	}
 
-		Sampler::Sampler sampler(static_cast<std::size_t>(samplingRate));
+	if (program.get<std::string>("--mode") == "reservoir") {
+		try {
+			UnirecInputInterface inputInterface = unirec.buildInputInterface();
+			UnirecOutputInterface outputInterface = unirec.buildOutputInterface();
 
-		UnirecBidirectionalInterface biInterface = unirec.buildBidirectionalInterface();
+			ForwardingOutput output
+				= {outputInterface, program.get<bool>("--sampling-rate-field"), std::nullopt, 0};
+			Sampler::ReservoirSampler reservoirSampler(
+				getReservoirSize(program),
+				getWindow(program),
+				getSeedOrRandom(program),
+				[&output](UnirecRecordView& unirecRecord, double samplingRate) {
+					const Nm::ScopedTimer sendTimer(g_processingLatency.send);
+					sendRecord(output, unirecRecord, samplingRate);
+				});
 
-		auto telemetryInputDirectory = telemetryRootDirectory->addDir("input");
-		const telemetry::FileOps inputFileOps
-			= {[&biInterface]() { return Nm::getInterfaceTelemetry(biInterface); }, nullptr};
-		const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
+			auto telemetrySamplerDirectory = telemetryRootDirectory->addDir("sampler");
+			const telemetry::FileOps samplerFileOps
+				= {[&reservoirSampler]() { return getReservoirTelemetry(reservoirSampler); },
+				   nullptr};
+			const auto samplerFile = telemetrySamplerDirectory->addFile("stats", samplerFileOps);
+
+			auto telemetryInputDirectory = telemetryRootDirectory->addDir("input");
+			const Nm::InterfaceRatesSampler ratesSampler(inputInterface);
+			const telemetry::FileOps inputFileOps
+				= {[&inputInterface, &ratesSampler]() {
+					   return Nm::getInterfaceTelemetry(inputInterface, ratesSampler);
+				   },
+				   nullptr};
+			const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
+
+			processUnirecRecords(inputInterface, output, reservoirSampler);
+		} catch (std::exception& ex) {
+			logger->error(ex.what());
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	try {
+		Sampler::Sampler sampler(createSamplingPolicy(program));
+		const std::string requiredUnirecTemplate = sampler.getUnirecTemplateDescription();
 
 		auto telemetrySamplerDirectory = telemetryRootDirectory->addDir("sampler");
 		const telemetry::FileOps samplerFileOps
 			= {[&sampler]() { return getSamplerTelemetry(sampler); }, nullptr};
 		const auto samplerFile = telemetrySamplerDirectory->addFile("stats", samplerFileOps);
+		sampler.setTelemetryDirectory(telemetrySamplerDirectory);
+
+		auto telemetryInputDirectory = telemetryRootDirectory->addDir("input");
+
+		// Volume estimates of the priority mode need the rate of each record, so it is always added
+		const bool hasSamplingRateField = program.get<bool>("--sampling-rate-field")
+			|| program.get<std::string>("--mode") == "priority";
+		if (hasSamplingRateField) {
+			UnirecInputInterface inputInterface = unirec.buildInputInterface();
+			UnirecOutputInterface outputInterface = unirec.buildOutputInterface();
+			if (!requiredUnirecTemplate.empty()) {
+				inputInterface.setRequieredFormat(requiredUnirecTemplate);
+			}
+
+			const Nm::InterfaceRatesSampler ratesSampler(inputInterface);
+			const telemetry::FileOps inputFileOps
+				= {[&inputInterface, &ratesSampler]() {
+					   return Nm::getInterfaceTelemetry(inputInterface, ratesSampler);
+				   },
+				   nullptr};
+			const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
+
+			SamplingRateOutput output = {outputInterface, std::nullopt, 0};
+			processUnirecRecords(inputInterface, output, sampler);
+			return EXIT_SUCCESS;
+		}
+
+		UnirecBidirectionalInterface biInterface = unirec.buildBidirectionalInterface();
+		if (!requiredUnirecTemplate.empty()) {
+			biInterface.setRequieredFormat(requiredUnirecTemplate);
+			sampler.updateUnirecIds();
+		}
+
+		const Nm::InterfaceRatesSampler ratesSampler(biInterface, g_sendStats);
+		const telemetry::FileOps inputFileOps
+			= {[&biInterface, &ratesSampler]() {
+				   return Nm::getInterfaceTelemetry(biInterface, ratesSampler);
+			   },
+			   nullptr};
+		const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
+
+		auto telemetryOutputDirectory = telemetryRootDirectory->addDir("output");
+		const telemetry::FileOps outputFileOps
+			= {[&ratesSampler]() { return Nm::getSendTelemetry(g_sendStats, ratesSampler); },
+			   nullptr};
+		const auto outputFile = telemetryOutputDirectory->addFile("stats", outputFileOps);
 
 		processUnirecRecords(biInterface, sampler);
 
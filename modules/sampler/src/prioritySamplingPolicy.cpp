@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @brief Implementation of the PrioritySamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "prioritySamplingPolicy.hpp"
+#include "clockCheckPeriod.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace Sampler {
+
+PrioritySamplingPolicy::PrioritySamplingPolicy(
+	std::string weightField,
+	double targetRate,
+	std::chrono::milliseconds adaptationPeriod,
+	uint64_t seed)
+	: M_WEIGHT_FIELD(std::move(weightField))
+	, M_TARGET_RATE(targetRate)
+	, M_ADAPTATION_PERIOD(std::chrono::duration_cast<Clock::duration>(adaptationPeriod))
+	, M_TARGET_PERIOD_COUNT(
+		  targetRate * std::chrono::duration<double>(adaptationPeriod).count())
+	, m_generator(seed)
+	, m_periodStart(Clock::now())
+{
+}
+
+std::string PrioritySamplingPolicy::getUnirecTemplateDescription() const
+{
+	return "uint64 " + M_WEIGHT_FIELD;
+}
+
+void PrioritySamplingPolicy::updateUnirecIds()
+{
+	const auto unirecId = ur_get_id_by_name(M_WEIGHT_FIELD.c_str());
+	if (unirecId == UR_E_INVALID_NAME) {
+		throw std::runtime_error("Invalid Unirec name:" + M_WEIGHT_FIELD);
+	}
+	m_weightId = static_cast<ur_field_id_t>(unirecId);
+}
+
+void PrioritySamplingPolicy::adaptThreshold(Clock::time_point now) noexcept
+{
+	const std::chrono::duration<double> elapsed = now - m_periodStart;
+	const double targetCount = std::max(M_TARGET_RATE * elapsed.count(), 1.0);
+
+	if (m_periodSelectedCount != 0) {
+		m_samplingRate.store(
+			static_cast<double>(m_periodRecordsCount) / static_cast<double>(m_periodSelectedCount),
+			std::memory_order_relaxed);
+	}
+
+	// Records lighter than the threshold are sampled with probability inversely proportional to
+	// the threshold, so the output count scales approximately with its inverse
+	const double change = std::clamp(
+		static_cast<double>(m_periodSelectedCount) / targetCount,
+		1.0 / MAX_THRESHOLD_CHANGE,
+		MAX_THRESHOLD_CHANGE);
+	m_threshold = std::max(1.0, m_threshold * change);
+
+	m_periodStart = now;
+	m_periodRecordsCount = 0;
+	m_periodSelectedCount = 0;
+}
+
+bool PrioritySamplingPolicy::isSelected(const Nemea::UnirecRecordView& unirecRecordView)
+{
+	// The period is adapted before the record is counted, so the record and its selection
+	// belong to the same period
+	if (m_recordsCount++ % g_CLOCK_CHECK_PERIOD == 0) {
+		// The period ends early when the output exceeds its target, e.g. after an input spike
+		const Clock::time_point now = Clock::now();
+		if (now - m_periodStart >= M_ADAPTATION_PERIOD
+			|| static_cast<double>(m_periodSelectedCount) > M_TARGET_PERIOD_COUNT) {
+			adaptThreshold(now);
+		}
+	}
+	m_periodRecordsCount++;
+
+	const auto weight
+		= static_cast<double>(unirecRecordView.getFieldAsType<uint64_t>(m_weightId));
+	if (weight >= m_threshold) {
+		m_selectedRecordSamplingRate = 1.0;
+	} else if (m_generator.nextUniform() * m_threshold <= weight) {
+		m_selectedRecordSamplingRate = m_threshold / weight;
+	} else {
+		return false;
+	}
+
+	m_periodSelectedCount++;
+	return true;
+}
+
+double PrioritySamplingPolicy::getSamplingRate() const noexcept
+{
+	return m_samplingRate.load(std::memory_order_relaxed);
+}
+
+double PrioritySamplingPolicy::getSelectedRecordSamplingRate() const noexcept
+{
+	return m_selectedRecordSamplingRate;
+}
+
+} // namespace Sampler
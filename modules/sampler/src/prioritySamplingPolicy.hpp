@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @brief Declaration of the PrioritySamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "samplingPolicy.hpp"
+#include "xoshiro256.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Sampler {
+
+/**
+ * @brief Samples records with probability proportional to their weight.
+ *
+ * Threshold sampling of Duffield, Lund and Thorup: a record with weight `w` (e.g. `BYTES`) is
+ * sampled with probability min(1, w/z). Records heavier than the threshold `z` are always
+ * sampled, so the few large flows carrying most of the volume are kept. The sampling rate of
+ * a selected record is max(1, z/w), so the weight multiplied by the rate, max(w, z), is an
+ * unbiased estimate of the volume. Records with zero weight are never sampled.
+ *
+ * The threshold is adapted to the target output rate: after each adaptation period, it is
+ * multiplied by the ratio of the output and the target records count of the period, at most
+ * by `MAX_THRESHOLD_CHANGE`. The period ends early when its output exceeds the target count.
+ */
+class PrioritySamplingPolicy : public SamplingPolicy {
+public:
+	/**
+	 * @brief Maximal change of the threshold in one adaptation period.
+	 */
+	static inline const double MAX_THRESHOLD_CHANGE = 8.0;
+
+	/**
+	 * @brief Constructs the policy.
+	 * @param weightField Name of the uint64 field with the weight of the record.
+	 * @param targetRate Target output rate in records per second.
+	 * @param adaptationPeriod Period of the threshold adaptation.
+	 * @param seed Seed of the pseudo random number generator.
+	 */
+	PrioritySamplingPolicy(
+		std::string weightField,
+		double targetRate,
+		std::chrono::milliseconds adaptationPeriod,
+		uint64_t seed);
+
+	/**
+	 * @brief Selects the record with probability min(1, weight/threshold).
+	 * @param unirecRecordView The Unirec record.
+	 * @return True if the record should be sampled, false otherwise.
+	 */
+	bool isSelected(const Nemea::UnirecRecordView& unirecRecordView) override;
+
+	/**
+	 * @brief Returns the ratio of input and output records of the last adaptation period.
+	 */
+	double getSamplingRate() const noexcept override;
+
+	/**
+	 * @brief Returns max(1, threshold/weight) of the last selected record.
+	 */
+	double getSelectedRecordSamplingRate() const noexcept override;
+
+	std::string getUnirecTemplateDescription() const override;
+
+	void updateUnirecIds() override;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void adaptThreshold(Clock::time_point now) noexcept;
+
+	const std::string M_WEIGHT_FIELD;
+	const double M_TARGET_RATE;
+	const Clock::duration M_ADAPTATION_PERIOD;
+	const double M_TARGET_PERIOD_COUNT;
+
+	ur_field_id_t m_weightId = 0;
+	Xoshiro256 m_generator;
+	double m_threshold = 1.0;
+	double m_selectedRecordSamplingRate = 1.0;
+	std::atomic<double> m_samplingRate {1.0};
+
+	uint64_t m_recordsCount = 0;
+	Clock::time_point m_periodStart;
+	uint64_t m_periodRecordsCount = 0;
+	uint64_t m_periodSelectedCount = 0;
+};
+
+} // namespace Sampler
@@ -0,0 +1,55 @@
+/**
+ * @file
+ * @brief Implementation of the RandomSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "randomSamplingPolicy.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace Sampler {
+
+RandomSamplingPolicy::RandomSamplingPolicy(std::size_t samplingRate, uint64_t seed)
+	: M_SAMPLING_RATE(samplingRate)
+	, M_LOG_SKIP_PROBABILITY(std::log1p(-1.0 / static_cast<double>(samplingRate)))
+	, m_generator(seed)
+	, m_remainingSkip(drawSkip())
+{
+}
+
+uint64_t RandomSamplingPolicy::drawSkip() noexcept
+{
+	// Every record is sampled with rate 1:1, the logarithm is minus infinity
+	if (std::isinf(M_LOG_SKIP_PROBABILITY)) {
+		return 0;
+	}
+
+	// Inversion of the geometric distribution: P(skip = k) = (1 - p)^k * p
+	const double skip = std::floor(std::log(m_generator.nextUniform()) / M_LOG_SKIP_PROBABILITY);
+	if (skip >= static_cast<double>(std::numeric_limits<uint64_t>::max())) {
+		return std::numeric_limits<uint64_t>::max();
+	}
+	return static_cast<uint64_t>(skip);
+}
+
+bool RandomSamplingPolicy::isSelected(
+	[[maybe_unused]] const Nemea::UnirecRecordView& unirecRecordView)
+{
+	if (m_remainingSkip != 0) {
+		m_remainingSkip--;
+		return false;
+	}
+
+	m_remainingSkip = drawSkip();
+	return true;
+}
+
+double RandomSamplingPolicy::getSamplingRate() const noexcept
+{
+	return static_cast<double>(M_SAMPLING_RATE);
+}
+
+} // namespace Sampler
@@ -0,0 +1,60 @@
+/**
+ * @file
+ * @brief Declaration of the RandomSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "samplingPolicy.hpp"
+#include "xoshiro256.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Sampler {
+
+/**
+ * @brief Samples each record independently with probability 1/r.
+ *
+ * Instead of drawing a random number for each record, the number of records skipped before
+ * the next sampled record is drawn from the geometric distribution. Most records cost only
+ * a decrement of the skip counter, and the sampled records are exactly the Bernoulli trials
+ * with probability 1/r, so the sampling does not alias with periodic traffic.
+ */
+class RandomSamplingPolicy : public SamplingPolicy {
+public:
+	/**
+	 * @brief Constructs the policy.
+	 * @param samplingRate The 1:r rate at which records should be sampled.
+	 * @param seed Seed of the pseudo random number generator.
+	 */
+	RandomSamplingPolicy(std::size_t samplingRate, uint64_t seed);
+
+	/**
+	 * @brief Selects the record when the skip counter is exhausted.
+	 * @param unirecRecordView The Unirec record, not used.
+	 * @return True if the record should be sampled, false otherwise.
+	 */
+	bool isSelected(const Nemea::UnirecRecordView& unirecRecordView) override;
+
+	/**
+	 * @brief Returns the 1:r sampling rate.
+	 */
+	double getSamplingRate() const noexcept override;
+
+private:
+	uint64_t drawSkip() noexcept;
+
+	const std::size_t M_SAMPLING_RATE;
+
+	/**
+	 * @brief Logarithm of the probability that a record is not sampled.
+	 */
+	const double M_LOG_SKIP_PROBABILITY;
+	Xoshiro256 m_generator;
+	uint64_t m_remainingSkip;
+};
+
+} // namespace Sampler
@@ -0,0 +1,169 @@
+/**
+ * @file
+ * @brief Implementation of the ReservoirSampler class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "reservoirSampler.hpp"
+#include "clockCheckPeriod.hpp"
+
+#include <cmath>
+#include <libtrap/trap.h>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace Sampler {
+
+static ur_template_t* createInputTemplate()
+{
+	uint8_t dataType;
+	const char* templateSpecification = nullptr;
+	if (trap_get_data_fmt(TRAPIFC_INPUT, 0, &dataType, &templateSpecification) != TRAP_E_OK) {
+		throw std::runtime_error("ReservoirSampler: unable to get format of the input interface");
+	}
+
+	ur_template_t* unirecTemplate = ur_create_template_from_ifc_spec(templateSpecification);
+	if (unirecTemplate == nullptr) {
+		throw std::runtime_error("ReservoirSampler: unable to create template of the input");
+	}
+	return unirecTemplate;
+}
+
+ReservoirSampler::ReservoirSampler(
+	std::size_t reservoirSize,
+	std::chrono::milliseconds window,
+	uint64_t seed,
+	SendCallback sendCallback)
+	: M_RESERVOIR_SIZE(reservoirSize)
+	, M_WINDOW(std::chrono::duration_cast<Clock::duration>(window))
+	, m_sendCallback(std::move(sendCallback))
+	, m_generator(seed)
+	, m_reservoir(reservoirSize)
+	, m_windowStart(Clock::now())
+{
+	if (reservoirSize == 0) {
+		throw std::invalid_argument("ReservoirSampler: reservoir size must be > 0");
+	}
+}
+
+ReservoirSampler::~ReservoirSampler()
+{
+	if (m_template != nullptr) {
+		ur_free_template(m_template);
+	}
+}
+
+void ReservoirSampler::updateReplacementThreshold() noexcept
+{
+	m_replacementThreshold *= std::exp(
+		std::log(m_generator.nextUniform()) / static_cast<double>(M_RESERVOIR_SIZE));
+}
+
+uint64_t ReservoirSampler::drawSkip() noexcept
+{
+	// Number of records skipped before a record with the key below the threshold is seen
+	const double skip = std::floor(
+		std::log(m_generator.nextUniform()) / std::log1p(-m_replacementThreshold));
+	if (skip >= static_cast<double>(std::numeric_limits<uint64_t>::max())) {
+		return std::numeric_limits<uint64_t>::max();
+	}
+	return static_cast<uint64_t>(skip);
+}
+
+void ReservoirSampler::store(std::size_t slotIndex, const Nemea::UnirecRecordView& unirecRecordView)
+{
+	if (m_template == nullptr) {
+		m_template = createInputTemplate();
+	}
+
+	// The slot keeps its capacity, so no memory is allocated once records of all sizes were seen
+	const auto* recordData = static_cast<const std::byte*>(unirecRecordView.data());
+	const size_t recordSize = ur_rec_size(m_template, unirecRecordView.data());
+	m_reservoir[slotIndex].assign(recordData, recordData + recordSize);
+}
+
+void ReservoirSampler::process(const Nemea::UnirecRecordView& unirecRecordView)
+{
+	if (m_totalRecords.load() % g_CLOCK_CHECK_PERIOD == 0) {
+		checkWindow();
+	}
+
+	m_totalRecords.add();
+	m_windowRecords.add();
+
+	const uint64_t fill = m_fill.load();
+	if (fill < M_RESERVOIR_SIZE) {
+		store(static_cast<std::size_t>(fill), unirecRecordView);
+		m_fill.add();
+		if (fill + 1 == M_RESERVOIR_SIZE) {
+			updateReplacementThreshold();
+			m_remainingSkip = drawSkip();
+		}
+		return;
+	}
+
+	if (m_remainingSkip != 0) {
+		m_remainingSkip--;
+		return;
+	}
+
+	store(static_cast<std::size_t>(m_generator.next() % M_RESERVOIR_SIZE), unirecRecordView);
+	updateReplacementThreshold();
+	m_remainingSkip = drawSkip();
+}
+
+void ReservoirSampler::checkWindow()
+{
+	const Clock::time_point now = Clock::now();
+	if (now - m_windowStart < M_WINDOW) {
+		return;
+	}
+
+	flush();
+	m_windowStart += (now - m_windowStart) / M_WINDOW * M_WINDOW;
+}
+
+void ReservoirSampler::flush()
+{
+	const uint64_t fill = m_fill.load();
+	double samplingRate = m_samplingRate.load(std::memory_order_relaxed);
+	if (fill != 0) {
+		samplingRate = static_cast<double>(m_windowRecords.load()) / static_cast<double>(fill);
+		m_samplingRate.store(samplingRate, std::memory_order_relaxed);
+	}
+
+	for (size_t slotIndex = 0; slotIndex < fill; slotIndex++) {
+		Nemea::UnirecRecordView unirecRecordView(m_reservoir[slotIndex].data(), m_template);
+		m_sendCallback(unirecRecordView, samplingRate);
+	}
+
+	m_sampledRecords.add(fill);
+	m_fill.store(0);
+	m_windowRecords.store(0);
+	m_replacementThreshold = 1.0;
+}
+
+void ReservoirSampler::changeTemplate()
+{
+	flush();
+
+	if (m_template != nullptr) {
+		ur_free_template(m_template);
+		m_template = nullptr;
+	}
+}
+
+ReservoirStats ReservoirSampler::getStats() const noexcept
+{
+	ReservoirStats stats;
+	stats.totalRecords = m_totalRecords.load();
+	stats.sampledRecords = m_sampledRecords.load();
+	stats.windowRecords = m_windowRecords.load();
+	stats.windowFill = m_fill.load();
+	stats.samplingRate = m_samplingRate.load(std::memory_order_relaxed);
+	return stats;
+}
+
+} // namespace Sampler
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Declaration of the ReservoirSampler class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "counter/counter.hpp"
+#include "xoshiro256.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unirec++/unirecRecordView.hpp>
+#include <vector>
+
+namespace Sampler {
+
+/**
+ * @brief Statistics of the reservoir sampling.
+ */
+struct ReservoirStats {
+	uint64_t totalRecords = 0; ///< Total number of records.
+	uint64_t sampledRecords = 0; ///< Number of flushed records.
+	uint64_t windowRecords = 0; ///< Number of records of the current window.
+	uint64_t windowFill = 0; ///< Number of records in the reservoir.
+	double samplingRate = 0; ///< 1:r sampling rate of the last flushed window.
+};
+
+/**
+ * @brief Samples a fixed number of records uniformly from each time window.
+ *
+ * The reservoir of K records is filled by Algorithm L of Li: once the reservoir is full, the
+ * number of records skipped before the next replacement is drawn from the distribution of the
+ * skips, so most records cost only a decrement of the skip counter. At the end of each window
+ * the reservoir is flushed to the output, so at most K records are forwarded per window and
+ * the memory is bounded by K records.
+ *
+ * Records are copied to the reservoir, so the template of the input interface is read from
+ * libtrap when the first record is processed.
+ */
+class ReservoirSampler {
+public:
+	/**
+	 * @brief Callback forwarding a flushed record with its 1:r sampling rate.
+	 *
+	 * The view is not const, as output interfaces of Unirec send only non-const views.
+	 */
+	using SendCallback = std::function<void(Nemea::UnirecRecordView&, double)>;
+
+	/**
+	 * @brief Constructs the sampler.
+	 * @param reservoirSize Number of records K sampled from each window.
+	 * @param window Duration of the window.
+	 * @param seed Seed of the pseudo random number generator.
+	 * @param sendCallback Callable used to forward flushed records.
+	 * @throw std::invalid_argument If the reservoir size is zero.
+	 */
+	ReservoirSampler(
+		std::size_t reservoirSize,
+		std::chrono::milliseconds window,
+		uint64_t seed,
+		SendCallback sendCallback);
+
+	ReservoirSampler(const ReservoirSampler&) = delete;
+	ReservoirSampler& operator=(const ReservoirSampler&) = delete;
+
+	/**
+	 * @brief Frees the template of the input interface.
+	 */
+	~ReservoirSampler();
+
+	/**
+	 * @brief Offers the record to the reservoir and flushes it if the window has ended.
+	 * @param unirecRecordView Received Unirec record.
+	 */
+	void process(const Nemea::UnirecRecordView& unirecRecordView);
+
+	/**
+	 * @brief Flushes the reservoir if the window has ended, e.g. when no record is received.
+	 */
+	void checkWindow();
+
+	/**
+	 * @brief Forwards records of the reservoir and starts filling it again.
+	 */
+	void flush();
+
+	/**
+	 * @brief Flushes the reservoir and drops the template of the input interface.
+	 *
+	 * Must be called before the template of the Unirec interface is changed. The new template is
+	 * loaded with the next processed record.
+	 */
+	void changeTemplate();
+
+	/**
+	 * @brief Returns the current statistics of the reservoir sampling.
+	 */
+	ReservoirStats getStats() const noexcept;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void store(std::size_t slotIndex, const Nemea::UnirecRecordView& unirecRecordView);
+	void updateReplacementThreshold() noexcept;
+	uint64_t drawSkip() noexcept;
+
+	const std::size_t M_RESERVOIR_SIZE;
+	const Clock::duration M_WINDOW;
+	SendCallback m_sendCallback;
+	Xoshiro256 m_generator;
+
+	ur_template_t* m_template = nullptr;
+	std::vector<std::vector<std::byte>> m_reservoir;
+	Nm::Counter m_fill;
+	double m_replacementThreshold = 1.0;
+	uint64_t m_remainingSkip = 0;
+
+	Clock::time_point m_windowStart;
+	Nm::Counter m_windowRecords;
+	Nm::Counter m_totalRecords;
+	Nm::Counter m_sampledRecords;
+	std::atomic<double> m_samplingRate {1.0};
+};
+
+} // namespace Sampler
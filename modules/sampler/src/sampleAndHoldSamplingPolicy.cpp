@@ -0,0 +1,107 @@
+/**
+ * @file
+ * @brief Implementation of the SampleAndHoldSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "sampleAndHoldSamplingPolicy.hpp"
+#include "clockCheckPeriod.hpp"
+
+#include <limits>
+
+namespace Sampler {
+
+static uint64_t getFlowHash(const uint64_t& flowHash)
+{
+	return flowHash;
+}
+
+static SampleAndHoldSamplingPolicy::Timestamp
+timeSum(const SampleAndHoldSamplingPolicy::Timestamp& value, uint64_t timeout)
+{
+	return value + std::chrono::milliseconds(timeout);
+}
+
+SampleAndHoldSamplingPolicy::SampleAndHoldSamplingPolicy(
+	std::size_t samplingRate,
+	FlowKeyType flowKeyType,
+	uint32_t cacheSizeExponent,
+	std::chrono::milliseconds timeout,
+	uint64_t seed)
+	: M_SAMPLING_RATE(samplingRate)
+	, M_THRESHOLD(std::numeric_limits<uint64_t>::max() / samplingRate)
+	, m_flowKeyHasher(flowKeyType, seed)
+	, m_flowCache(
+		  {cacheSizeExponent, static_cast<uint64_t>(timeout.count())},
+		  getFlowHash,
+		  std::less<Timestamp>(),
+		  timeSum)
+	, m_generator(seed)
+	, m_currentTime(std::chrono::steady_clock::now())
+{
+}
+
+std::string SampleAndHoldSamplingPolicy::getUnirecTemplateDescription() const
+{
+	return FlowKeyHasher::getUnirecTemplateDescription();
+}
+
+void SampleAndHoldSamplingPolicy::updateUnirecIds()
+{
+	m_flowKeyHasher.updateUnirecIds();
+}
+
+bool SampleAndHoldSamplingPolicy::isSelected(const Nemea::UnirecRecordView& unirecRecordView)
+{
+	if (m_recordsCount++ % g_CLOCK_CHECK_PERIOD == 0) {
+		m_currentTime = std::chrono::steady_clock::now();
+	}
+
+	const uint64_t flowHash = m_flowKeyHasher.hash(unirecRecordView);
+	if (m_flowCache.refresh(flowHash, m_currentTime)) {
+		m_heldRecords.add();
+		m_selectedRecordSamplingRate = 1.0;
+		return true;
+	}
+
+	if (m_generator.next() > M_THRESHOLD) {
+		return false;
+	}
+
+	const auto insertResult = m_flowCache.insert({flowHash, true}, m_currentTime).second;
+	if (insertResult == FlowCache::HashMapTimeoutBucket::InsertResult::REPLACED) {
+		m_replacedFlows.add();
+	}
+	m_insertedFlows.add();
+	m_selectedRecordSamplingRate = static_cast<double>(M_SAMPLING_RATE);
+	return true;
+}
+
+double SampleAndHoldSamplingPolicy::getSamplingRate() const noexcept
+{
+	return static_cast<double>(M_SAMPLING_RATE);
+}
+
+double SampleAndHoldSamplingPolicy::getSelectedRecordSamplingRate() const noexcept
+{
+	return m_selectedRecordSamplingRate;
+}
+
+telemetry::Content SampleAndHoldSamplingPolicy::createTelemetryContent() const
+{
+	telemetry::Dict dict;
+	dict["heldRecords"] = m_heldRecords.load();
+	dict["insertedFlows"] = m_insertedFlows.load();
+	dict["replacedFlows"] = m_replacedFlows.load();
+	return dict;
+}
+
+void SampleAndHoldSamplingPolicy::setTelemetryDirectory(
+	const std::shared_ptr<telemetry::Directory>& directory)
+{
+	const telemetry::FileOps fileOps = {[this]() { return createTelemetryContent(); }, nullptr};
+	m_holder.add(directory->addFile("flows", fileOps));
+}
+
+} // namespace Sampler
@@ -0,0 +1,117 @@
+/**
+ * @file
+ * @brief Declaration of the SampleAndHoldSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "counter/counter.hpp"
+#include "flowKeyHasher.hpp"
+#include "samplingPolicy.hpp"
+#include "timeoutHashMap/timeoutHashMap.hpp"
+#include "xoshiro256.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <telemetry.hpp>
+
+namespace Sampler {
+
+/**
+ * @brief Samples flows at random and keeps all their subsequent records.
+ *
+ * Records of flows which are not held are sampled with probability 1/r. The flow of a sampled
+ * record is inserted to the bounded flow cache and all its following records are sampled until
+ * the flow expires or it is replaced in the cache. Large and long-lived flows are thus sampled
+ * almost completely, while only a small fraction of the records is forwarded.
+ *
+ * The first sampled record of a flow has the sampling rate r, which is the expected number of
+ * records of the flow up to it, the following records have the rate 1. The sum of the rates
+ * of a held flow is an unbiased estimate of its records count.
+ */
+class SampleAndHoldSamplingPolicy : public SamplingPolicy {
+public:
+	/**
+	 * @brief Time of the last record of the flow.
+	 */
+	using Timestamp = std::chrono::steady_clock::time_point;
+
+	/**
+	 * @brief Hash map of the held flows, keyed by the flow hash itself.
+	 */
+	using FlowCache = Nm::TimeoutHashMap<
+		uint64_t,
+		bool,
+		Timestamp,
+		uint64_t (*)(const uint64_t&),
+		std::less<Timestamp>,
+		Timestamp (*)(const Timestamp&, uint64_t)>;
+
+	/**
+	 * @brief Constructs the policy.
+	 * @param samplingRate The 1:r rate at which records of flows which are not held are sampled.
+	 * @param flowKeyType Fields of the flow key.
+	 * @param cacheSizeExponent Exponent N of the flow cache size, 2^N flows.
+	 * @param timeout Time after the last record of the flow when the flow is expired.
+	 * @param seed Seed of the pseudo random number generator and of the flow hash.
+	 */
+	SampleAndHoldSamplingPolicy(
+		std::size_t samplingRate,
+		FlowKeyType flowKeyType,
+		uint32_t cacheSizeExponent,
+		std::chrono::milliseconds timeout,
+		uint64_t seed);
+
+	/**
+	 * @brief Selects the record if its flow is held or with probability 1/r.
+	 * @param unirecRecordView The Unirec record.
+	 * @return True if the record should be sampled, false otherwise.
+	 */
+	bool isSelected(const Nemea::UnirecRecordView& unirecRecordView) override;
+
+	/**
+	 * @brief Returns the 1:r rate at which records of flows which are not held are sampled.
+	 */
+	double getSamplingRate() const noexcept override;
+
+	/**
+	 * @brief Returns r for the first sampled record of the flow, 1 for held records.
+	 */
+	double getSelectedRecordSamplingRate() const noexcept override;
+
+	std::string getUnirecTemplateDescription() const override;
+
+	void updateUnirecIds() override;
+
+	/**
+	 * @brief Adds the `flows` file with counters of the flow cache to the directory.
+	 * @param directory Telemetry directory of the sampler.
+	 */
+	void setTelemetryDirectory(const std::shared_ptr<telemetry::Directory>& directory) override;
+
+private:
+	telemetry::Content createTelemetryContent() const;
+
+	const std::size_t M_SAMPLING_RATE;
+	const uint64_t M_THRESHOLD;
+	FlowKeyHasher m_flowKeyHasher;
+	FlowCache m_flowCache;
+	Xoshiro256 m_generator;
+
+	Timestamp m_currentTime;
+	uint64_t m_recordsCount = 0;
+	double m_selectedRecordSamplingRate = 1.0;
+
+	Nm::Counter m_heldRecords;
+	Nm::Counter m_insertedFlows;
+	Nm::Counter m_replacedFlows;
+
+	telemetry::Holder m_holder;
+};
+
+} // namespace Sampler
@@ -7,31 +7,65 @@
  */
 
 #include "sampler.hpp"
+#include "systematicSamplingPolicy.hpp"
+
+#include <utility>
 
 namespace Sampler {
 
 Sampler::Sampler(std::size_t samplingRate)
-	: M_SAMPLING_RATE(samplingRate)
+	: m_samplingPolicy(std::make_unique<SystematicSamplingPolicy>(samplingRate))
 {
 }
 
-bool Sampler::shouldBeSampled() noexcept
+Sampler::Sampler(std::unique_ptr<SamplingPolicy> samplingPolicy)
+	: m_samplingPolicy(std::move(samplingPolicy))
 {
-	m_totalRecords++;
+}
 
-	if ((m_totalRecords % M_SAMPLING_RATE) == 0) {
-		m_sampledRecords++;
+bool Sampler::shouldBeSampled(const Nemea::UnirecRecordView& unirecRecordView)
+{
+	m_totalRecords.add();
+
+	if (m_samplingPolicy->isSelected(unirecRecordView)) {
+		m_sampledRecords.add();
 		return true;
 	}
 
 	return false;
 }
 
+std::string Sampler::getUnirecTemplateDescription() const
+{
+	return m_samplingPolicy->getUnirecTemplateDescription();
+}
+
+void Sampler::updateUnirecIds()
+{
+	m_samplingPolicy->updateUnirecIds();
+}
+
+void Sampler::setTelemetryDirectory(const std::shared_ptr<telemetry::Directory>& directory)
+{
+	m_samplingPolicy->setTelemetryDirectory(directory);
+}
+
+double Sampler::getSamplingRate() const noexcept
+{
+	return m_samplingPolicy->getSamplingRate();
+}
+
+double Sampler::getSelectedRecordSamplingRate() const noexcept
+{
+	return m_samplingPolicy->getSelectedRecordSamplingRate();
+}
+
 SamplerStats Sampler::getStats() const noexcept
 {
 	SamplerStats stats;
-	stats.totalRecords = m_totalRecords;
-	stats.sampledRecords = m_sampledRecords;
+	stats.samplingRate = m_samplingPolicy->getSamplingRate();
+	stats.totalRecords = m_totalRecords.load();
+	stats.sampledRecords = m_sampledRecords.load();
 	return stats;
 }
 
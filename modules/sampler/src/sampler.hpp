@@ -8,7 +8,14 @@
 
 #pragma once
 
+#include "counter/counter.hpp"
+#include "samplingPolicy.hpp"
+
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <telemetry.hpp>
+#include <unirec++/unirecRecordView.hpp>
 
 namespace Sampler {
 
@@ -18,30 +25,63 @@ namespace Sampler {
 struct SamplerStats {
 	uint64_t sampledRecords = 0; ///< Number of sampled records.
 	uint64_t totalRecords = 0; ///< Total number of records.
+	double samplingRate = 0; ///< Current 1:r sampling rate.
 };
 
 /**
- * @brief A class for sampling records at a given 1:r rate.
+ * @brief A class for sampling records by a sampling policy.
  */
 class Sampler {
 public:
 	/**
-	 * @brief Constructs a Sampler object with the given sampling rate.
+	 * @brief Constructs a Sampler object sampling every r-th record.
 	 * @param samplingRate The 1:r rate at which records should be sampled.
 	 */
 	explicit Sampler(std::size_t samplingRate);
 
+	/**
+	 * @brief Constructs a Sampler object with the given sampling policy.
+	 * @param samplingPolicy Policy deciding which records are sampled.
+	 */
+	explicit Sampler(std::unique_ptr<SamplingPolicy> samplingPolicy);
+
 	/**
 	 * @brief Determines whether the current record should be sampled.
 	 *
 	 * This function increments the total records counter and checks if the current record
-	 * should be sampled based on the sampling rate.
-	 *
-	 * Every -rth record will be sampled.
+	 * should be sampled based on the sampling policy.
 	 *
+	 * @param unirecRecordView The Unirec record.
 	 * @return True if the current record should be sampled, false otherwise.
 	 */
-	bool shouldBeSampled() noexcept;
+	bool shouldBeSampled(const Nemea::UnirecRecordView& unirecRecordView);
+
+	/**
+	 * @brief Get the Unirec template description of fields required by the sampling policy.
+	 * @return Template description, empty if the policy does not use any field.
+	 */
+	std::string getUnirecTemplateDescription() const;
+
+	/**
+	 * @brief Update Unirec Id of required fields after template format change.
+	 */
+	void updateUnirecIds();
+
+	/**
+	 * @brief Sets the telemetry directory for telemetry data of the sampling policy.
+	 * @param directory Telemetry directory of the sampler.
+	 */
+	void setTelemetryDirectory(const std::shared_ptr<telemetry::Directory>& directory);
+
+	/**
+	 * @brief Returns the current 1:r sampling rate of the sampling policy.
+	 */
+	double getSamplingRate() const noexcept;
+
+	/**
+	 * @brief Returns the 1:r sampling rate of the last sampled record.
+	 */
+	double getSelectedRecordSamplingRate() const noexcept;
 
 	/**
 	 * @brief Returns the current sampling statistics.
@@ -50,9 +90,9 @@ public:
 	SamplerStats getStats() const noexcept;
 
 private:
-	const std::size_t M_SAMPLING_RATE;
-	uint64_t m_totalRecords = 0;
-	uint64_t m_sampledRecords = 0;
+	std::unique_ptr<SamplingPolicy> m_samplingPolicy;
+	Nm::Counter m_totalRecords;
+	Nm::Counter m_sampledRecords;
 };
 
 } // namespace Sampler
@@ -0,0 +1,65 @@
+/**
+ * @file
+ * @brief Declaration of the SamplingPolicy interface.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <telemetry.hpp>
+#include <unirec++/unirecRecordView.hpp>
+
+namespace Sampler {
+
+/**
+ * @brief Interface of a policy deciding which records are sampled.
+ */
+class SamplingPolicy {
+public:
+	virtual ~SamplingPolicy() = default;
+
+	/**
+	 * @brief Decides whether the record is sampled.
+	 * @param unirecRecordView The Unirec record.
+	 * @return True if the record should be sampled, false otherwise.
+	 */
+	virtual bool isSelected(const Nemea::UnirecRecordView& unirecRecordView) = 0;
+
+	/**
+	 * @brief Returns the current 1:r sampling rate, the inverse of the sampling probability.
+	 */
+	virtual double getSamplingRate() const noexcept = 0;
+
+	/**
+	 * @brief Returns the 1:r sampling rate of the last selected record.
+	 *
+	 * The rate is the inverse of the probability the record was selected with, so it is the
+	 * weight of the record in unbiased estimates of counts and volumes.
+	 */
+	virtual double getSelectedRecordSamplingRate() const noexcept { return getSamplingRate(); }
+
+	/**
+	 * @brief Get the Unirec template description of fields used by the policy.
+	 * @return Template description, empty if the policy does not use any field.
+	 */
+	virtual std::string getUnirecTemplateDescription() const { return {}; }
+
+	/**
+	 * @brief Update Unirec Id of used fields after template format change.
+	 */
+	virtual void updateUnirecIds() {}
+
+	/**
+	 * @brief Sets the telemetry directory for telemetry data of the policy.
+	 * @param directory Telemetry directory of the sampler.
+	 */
+	virtual void setTelemetryDirectory(
+		[[maybe_unused]] const std::shared_ptr<telemetry::Directory>& directory)
+	{
+	}
+};
+
+} // namespace Sampler
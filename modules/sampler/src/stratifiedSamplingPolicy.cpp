@@ -0,0 +1,311 @@
+/**
+ * @file
+ * @brief Implementation of the StratifiedSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "stratifiedSamplingPolicy.hpp"
+#include "csv/csvLine.hpp"
+#include "ip/ipAddressPrefix.hpp"
+#include "unirec/unirecFieldId.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <xxhash.h>
+
+namespace Sampler {
+
+static const char g_COMMENT_PREFIX = '#';
+static const std::string g_HEADER = "name,type,value,rate";
+
+template<typename Number>
+static Number convertCellToNumber(const std::string& cell)
+{
+	Number number;
+	const char* cellEnd = cell.data() + cell.size();
+	const auto [end, errorCode] = std::from_chars(cell.data(), cellEnd, number);
+	if (errorCode != std::errc {} || end != cellEnd) {
+		throw std::invalid_argument("Invalid number '" + cell + "'");
+	}
+	return number;
+}
+
+std::size_t
+StratifiedSamplingPolicy::NetworkKeyHash::operator()(const NetworkKey& key) const noexcept
+{
+	return static_cast<std::size_t>(XXH3_64bits(key.data(), sizeof(NetworkKey)));
+}
+
+StratifiedSamplingPolicy::StratifiedSamplingPolicy(
+	const std::string& strataFilename,
+	std::size_t defaultSamplingRate)
+	: m_portStrata(std::numeric_limits<uint16_t>::max() + 1, NO_STRATUM)
+{
+	m_protocolStrata.fill(NO_STRATUM);
+
+	std::ifstream file(strataFilename);
+	if (!file) {
+		throw std::runtime_error("Unable to open strata file " + strataFilename);
+	}
+
+	bool isHeaderParsed = false;
+	size_t lineNumber = 0;
+	std::string line;
+	try {
+		while (std::getline(file, line)) {
+			lineNumber++;
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (line.empty() || line.front() == g_COMMENT_PREFIX) {
+				continue;
+			}
+
+			if (isHeaderParsed) {
+				parseRow(line);
+			} else if (Nm::splitLine(line) != Nm::splitLine(g_HEADER)) {
+				throw std::invalid_argument("The header must be '" + g_HEADER + "'");
+			} else {
+				isHeaderParsed = true;
+			}
+		}
+	} catch (const std::exception& ex) {
+		throw std::runtime_error(
+			"Invalid line " + std::to_string(lineNumber) + " of " + strataFilename + ": "
+			+ ex.what());
+	}
+
+	if (!isHeaderParsed) {
+		throw std::runtime_error("Strata file " + strataFilename + " has no header");
+	}
+
+	// The default stratum is the last one, so a record belongs to it only if no other matches
+	const StratumIndex defaultIndex = addStratum(DEFAULT_STRATUM_NAME, defaultSamplingRate);
+	std::replace(m_protocolStrata.begin(), m_protocolStrata.end(), NO_STRATUM, defaultIndex);
+	std::replace(m_portStrata.begin(), m_portStrata.end(), NO_STRATUM, defaultIndex);
+}
+
+void StratifiedSamplingPolicy::parseRow(const std::string& line)
+{
+	const std::vector<std::string> cells = Nm::splitLine(line);
+	if (cells.size() != 4) {
+		throw std::invalid_argument("Expected 4 columns, got " + std::to_string(cells.size()));
+	}
+
+	const std::string& name = cells[0];
+	const std::string& type = cells[1];
+	const std::string& value = cells[2];
+	if (name.empty() || name == DEFAULT_STRATUM_NAME) {
+		throw std::invalid_argument("Invalid stratum name '" + name + "'");
+	}
+
+	const auto samplingRate = convertCellToNumber<std::size_t>(cells[3]);
+	if (samplingRate == 0) {
+		throw std::invalid_argument("Sampling rate must be higher than zero");
+	}
+	const StratumIndex stratumIndex = addStratum(name, samplingRate);
+
+	if (type == "protocol") {
+		const auto protocol = convertCellToNumber<uint8_t>(value);
+		m_protocolStrata[protocol] = std::min(m_protocolStrata[protocol], stratumIndex);
+		m_hasProtocolStrata = true;
+	} else if (type == "port") {
+		addPort(value, stratumIndex);
+		m_hasPortStrata = true;
+	} else if (type == "prefix") {
+		addPrefix(value, stratumIndex);
+		m_hasPrefixStrata = true;
+	} else {
+		throw std::invalid_argument(
+			"Unknown stratum type '" + type + "'. Only allowed values are protocol, port and "
+			"prefix");
+	}
+}
+
+StratifiedSamplingPolicy::StratumIndex
+StratifiedSamplingPolicy::addStratum(const std::string& name, std::size_t samplingRate)
+{
+	auto hasSameName = [&name](const Stratum& stratum) { return stratum.name == name; };
+	const auto stratum = std::find_if(m_strata.begin(), m_strata.end(), hasSameName);
+	if (stratum != m_strata.end()) {
+		if (stratum->samplingRate != samplingRate) {
+			throw std::invalid_argument("Stratum '" + name + "' has different sampling rates");
+		}
+		return static_cast<StratumIndex>(std::distance(m_strata.begin(), stratum));
+	}
+
+	if (m_strata.size() >= NO_STRATUM) {
+		throw std::overflow_error("Too many strata");
+	}
+	m_strata.push_back({name, samplingRate, samplingRate, {}, {}});
+	return static_cast<StratumIndex>(m_strata.size() - 1);
+}
+
+void StratifiedSamplingPolicy::addPort(const std::string& value, StratumIndex stratumIndex)
+{
+	const size_t delimiterPosition = value.find('-');
+	const auto lowPort = convertCellToNumber<uint16_t>(value.substr(0, delimiterPosition));
+	const auto highPort = delimiterPosition == std::string::npos
+		? lowPort
+		: convertCellToNumber<uint16_t>(value.substr(delimiterPosition + 1));
+	if (lowPort > highPort) {
+		throw std::invalid_argument("Invalid port range '" + value + "'");
+	}
+
+	for (size_t port = lowPort; port <= highPort; port++) {
+		m_portStrata[port] = std::min(m_portStrata[port], stratumIndex);
+	}
+}
+
+void StratifiedSamplingPolicy::addPrefix(const std::string& value, StratumIndex stratumIndex)
+{
+	const size_t delimiterPosition = value.find('/');
+	const Nemea::IpAddress address(value.substr(0, delimiterPosition));
+	const size_t length = delimiterPosition == std::string::npos
+		? (address.isIpv4() ? Nm::IpAddressPrefix::IPV4_MAX_PREFIX
+							: Nm::IpAddressPrefix::IPV6_MAX_PREFIX)
+		: convertCellToNumber<size_t>(value.substr(delimiterPosition + 1));
+	const Nm::IpAddressPrefix prefix(address, length);
+
+	auto& tables = address.isIpv4() ? m_ipv4Tables : m_ipv6Tables;
+	auto hasSameLength = [length](const PrefixTable& table) { return table.length == length; };
+	auto table = std::find_if(tables.begin(), tables.end(), hasSameLength);
+	if (table == tables.end()) {
+		tables.push_back({length, prefix.getMask(), {}});
+		table = std::prev(tables.end());
+	}
+
+	NetworkKey key;
+	std::memcpy(key.data(), &prefix.getAddress().ip, sizeof(NetworkKey));
+	table->networks.emplace(key, stratumIndex);
+}
+
+std::string StratifiedSamplingPolicy::getUnirecTemplateDescription() const
+{
+	std::string description;
+	auto append = [&description](const std::string& fields) {
+		description += (description.empty() ? "" : ",") + fields;
+	};
+	if (m_hasPrefixStrata) {
+		append("ipaddr SRC_IP,ipaddr DST_IP");
+	}
+	if (m_hasPortStrata) {
+		append("uint16 SRC_PORT,uint16 DST_PORT");
+	}
+	if (m_hasProtocolStrata) {
+		append("uint8 PROTOCOL");
+	}
+	return description;
+}
+
+void StratifiedSamplingPolicy::updateUnirecIds()
+{
+	if (m_hasPrefixStrata) {
+		m_ids.srcIpId = Nm::getUnirecIdByName("SRC_IP");
+		m_ids.dstIpId = Nm::getUnirecIdByName("DST_IP");
+	}
+	if (m_hasPortStrata) {
+		m_ids.srcPortId = Nm::getUnirecIdByName("SRC_PORT");
+		m_ids.dstPortId = Nm::getUnirecIdByName("DST_PORT");
+	}
+	if (m_hasProtocolStrata) {
+		m_ids.protocolId = Nm::getUnirecIdByName("PROTOCOL");
+	}
+}
+
+StratifiedSamplingPolicy::StratumIndex
+StratifiedSamplingPolicy::findPrefixStratum(const Nemea::IpAddress& address) const
+{
+	// All prefix lengths are probed, the first stratum of the file has the lowest index
+	StratumIndex stratumIndex = NO_STRATUM;
+	for (const auto& table : address.isIpv4() ? m_ipv4Tables : m_ipv6Tables) {
+		const Nemea::IpAddress network = address & table.mask;
+		NetworkKey key;
+		std::memcpy(key.data(), &network.ip, sizeof(NetworkKey));
+		const auto iter = table.networks.find(key);
+		if (iter != table.networks.end()) {
+			stratumIndex = std::min(stratumIndex, iter->second);
+		}
+	}
+	return stratumIndex;
+}
+
+StratifiedSamplingPolicy::StratumIndex
+StratifiedSamplingPolicy::findStratum(const Nemea::UnirecRecordView& unirecRecordView) const
+{
+	auto stratumIndex = static_cast<StratumIndex>(m_strata.size() - 1);
+	if (m_hasProtocolStrata) {
+		const auto protocol = unirecRecordView.getFieldAsType<uint8_t>(m_ids.protocolId);
+		stratumIndex = std::min(stratumIndex, m_protocolStrata[protocol]);
+	}
+	if (m_hasPortStrata) {
+		const auto srcPort = unirecRecordView.getFieldAsType<uint16_t>(m_ids.srcPortId);
+		const auto dstPort = unirecRecordView.getFieldAsType<uint16_t>(m_ids.dstPortId);
+		stratumIndex = std::min({stratumIndex, m_portStrata[srcPort], m_portStrata[dstPort]});
+	}
+	if (m_hasPrefixStrata) {
+		const auto srcIp = unirecRecordView.getFieldAsType<Nemea::IpAddress>(m_ids.srcIpId);
+		const auto dstIp = unirecRecordView.getFieldAsType<Nemea::IpAddress>(m_ids.dstIpId);
+		stratumIndex
+			= std::min({stratumIndex, findPrefixStratum(srcIp), findPrefixStratum(dstIp)});
+	}
+	return stratumIndex;
+}
+
+bool StratifiedSamplingPolicy::isSelected(const Nemea::UnirecRecordView& unirecRecordView)
+{
+	Stratum& stratum = m_strata[findStratum(unirecRecordView)];
+	stratum.totalRecords.add();
+	if (--stratum.recordsToSample != 0) {
+		return false;
+	}
+
+	stratum.recordsToSample = stratum.samplingRate;
+	stratum.sampledRecords.add();
+	m_selectedRecordSamplingRate = static_cast<double>(stratum.samplingRate);
+	return true;
+}
+
+double StratifiedSamplingPolicy::getSamplingRate() const noexcept
+{
+	uint64_t totalRecords = 0;
+	uint64_t sampledRecords = 0;
+	for (const auto& stratum : m_strata) {
+		totalRecords += stratum.totalRecords.load();
+		sampledRecords += stratum.sampledRecords.load();
+	}
+	if (sampledRecords == 0) {
+		return static_cast<double>(m_strata.back().samplingRate);
+	}
+	return static_cast<double>(totalRecords) / static_cast<double>(sampledRecords);
+}
+
+double StratifiedSamplingPolicy::getSelectedRecordSamplingRate() const noexcept
+{
+	return m_selectedRecordSamplingRate;
+}
+
+telemetry::Content StratifiedSamplingPolicy::createTelemetryContent() const
+{
+	telemetry::Dict dict;
+	for (const auto& stratum : m_strata) {
+		dict[stratum.name + ".totalRecords"] = stratum.totalRecords.load();
+		dict[stratum.name + ".sampledRecords"] = stratum.sampledRecords.load();
+		dict[stratum.name + ".samplingRate"] = static_cast<double>(stratum.samplingRate);
+	}
+	return dict;
+}
+
+void StratifiedSamplingPolicy::setTelemetryDirectory(
+	const std::shared_ptr<telemetry::Directory>& directory)
+{
+	const telemetry::FileOps fileOps = {[this]() { return createTelemetryContent(); }, nullptr};
+	m_holder.add(directory->addFile("strata", fileOps));
+}
+
+} // namespace Sampler
@@ -0,0 +1,141 @@
+/**
+ * @file
+ * @brief Declaration of the StratifiedSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "counter/counter.hpp"
+#include "samplingPolicy.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <telemetry.hpp>
+#include <unirec++/ipAddress.hpp>
+#include <unirec++/unirecRecordView.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace Sampler {
+
+/**
+ * @brief Samples records of each traffic class, a stratum, by its own 1:r rate.
+ *
+ * Strata are loaded from a CSV file with the header `name,type,value,rate`. The type is
+ * `protocol` with a `PROTOCOL` value, `port` with a `SRC_PORT` or `DST_PORT` value or range
+ * `low-high`, or `prefix` with a `SRC_IP` or `DST_IP` prefix `address[/length]`. Rows with the
+ * same name add keys to one stratum. A record belongs to the first stratum of the file it
+ * matches, records matching no stratum belong to the `default` stratum.
+ *
+ * Every stratum samples every r-th of its records and has its own counters. Protocols and ports
+ * are looked up in arrays indexed by the field value and prefixes in a hash table for each
+ * prefix length, so the lookup cost does not depend on the number of strata.
+ */
+class StratifiedSamplingPolicy : public SamplingPolicy {
+public:
+	/**
+	 * @brief Name of the stratum of records matching no stratum of the file.
+	 */
+	static inline const std::string DEFAULT_STRATUM_NAME = "default";
+
+	/**
+	 * @brief Loads the strata from the CSV file.
+	 * @param strataFilename Path to the strata file.
+	 * @param defaultSamplingRate The 1:r rate of the default stratum.
+	 * @throw std::runtime_error If the file can not be read or it is not valid.
+	 */
+	StratifiedSamplingPolicy(const std::string& strataFilename, std::size_t defaultSamplingRate);
+
+	/**
+	 * @brief Selects every r-th record of the stratum the record belongs to.
+	 * @param unirecRecordView The Unirec record.
+	 * @return True if the record should be sampled, false otherwise.
+	 */
+	bool isSelected(const Nemea::UnirecRecordView& unirecRecordView) override;
+
+	/**
+	 * @brief Returns the ratio of input and output records of all strata.
+	 */
+	double getSamplingRate() const noexcept override;
+
+	/**
+	 * @brief Returns the 1:r rate of the stratum of the last selected record.
+	 */
+	double getSelectedRecordSamplingRate() const noexcept override;
+
+	std::string getUnirecTemplateDescription() const override;
+
+	void updateUnirecIds() override;
+
+	/**
+	 * @brief Adds the `strata` file with counters of each stratum to the directory.
+	 * @param directory Telemetry directory of the sampler.
+	 */
+	void setTelemetryDirectory(const std::shared_ptr<telemetry::Directory>& directory) override;
+
+private:
+	using StratumIndex = uint16_t;
+	using NetworkKey = std::array<uint64_t, 2>;
+
+	static inline const StratumIndex NO_STRATUM = std::numeric_limits<StratumIndex>::max();
+
+	struct Stratum {
+		std::string name;
+		std::size_t samplingRate;
+		std::size_t recordsToSample;
+		Nm::Counter totalRecords;
+		Nm::Counter sampledRecords;
+	};
+
+	struct NetworkKeyHash {
+		std::size_t operator()(const NetworkKey& key) const noexcept;
+	};
+
+	/**
+	 * @brief Networks of strata with prefixes of one length and address family.
+	 */
+	struct PrefixTable {
+		std::size_t length;
+		Nemea::IpAddress mask;
+		std::unordered_map<NetworkKey, StratumIndex, NetworkKeyHash> networks;
+	};
+
+	struct UnirecIds {
+		ur_field_id_t srcIpId;
+		ur_field_id_t dstIpId;
+		ur_field_id_t srcPortId;
+		ur_field_id_t dstPortId;
+		ur_field_id_t protocolId;
+	};
+
+	void parseRow(const std::string& line);
+	StratumIndex addStratum(const std::string& name, std::size_t samplingRate);
+	void addPort(const std::string& value, StratumIndex stratumIndex);
+	void addPrefix(const std::string& value, StratumIndex stratumIndex);
+
+	StratumIndex findStratum(const Nemea::UnirecRecordView& unirecRecordView) const;
+	StratumIndex findPrefixStratum(const Nemea::IpAddress& address) const;
+	telemetry::Content createTelemetryContent() const;
+
+	std::vector<Stratum> m_strata;
+	std::array<StratumIndex, std::numeric_limits<uint8_t>::max() + 1> m_protocolStrata;
+	std::vector<StratumIndex> m_portStrata;
+	std::vector<PrefixTable> m_ipv4Tables;
+	std::vector<PrefixTable> m_ipv6Tables;
+
+	bool m_hasProtocolStrata = false;
+	bool m_hasPortStrata = false;
+	bool m_hasPrefixStrata = false;
+	UnirecIds m_ids {};
+	double m_selectedRecordSamplingRate = 1.0;
+
+	telemetry::Holder m_holder;
+};
+
+} // namespace Sampler
@@ -0,0 +1,29 @@
+/**
+ * @file
+ * @brief Implementation of the SystematicSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "systematicSamplingPolicy.hpp"
+
+namespace Sampler {
+
+SystematicSamplingPolicy::SystematicSamplingPolicy(std::size_t samplingRate)
+	: M_SAMPLING_RATE(samplingRate)
+{
+}
+
+bool SystematicSamplingPolicy::isSelected(
+	[[maybe_unused]] const Nemea::UnirecRecordView& unirecRecordView)
+{
+	m_recordsCount++;
+	return (m_recordsCount % M_SAMPLING_RATE) == 0;
+}
+
+double SystematicSamplingPolicy::getSamplingRate() const noexcept
+{
+	return static_cast<double>(M_SAMPLING_RATE);
+}
+
+} // namespace Sampler
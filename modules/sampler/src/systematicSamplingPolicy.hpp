@@ -0,0 +1,45 @@
+/**
+ * @file
+ * @brief Declaration of the SystematicSamplingPolicy class.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "samplingPolicy.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Sampler {
+
+/**
+ * @brief Samples every r-th record.
+ */
+class SystematicSamplingPolicy : public SamplingPolicy {
+public:
+	/**
+	 * @brief Constructs the policy with the given sampling rate.
+	 * @param samplingRate The 1:r rate at which records should be sampled.
+	 */
+	explicit SystematicSamplingPolicy(std::size_t samplingRate);
+
+	/**
+	 * @brief Selects every -rth record.
+	 * @param unirecRecordView The Unirec record, not used.
+	 * @return True if the record should be sampled, false otherwise.
+	 */
+	bool isSelected(const Nemea::UnirecRecordView& unirecRecordView) override;
+
+	/**
+	 * @brief Returns the 1:r sampling rate.
+	 */
+	double getSamplingRate() const noexcept override;
+
+private:
+	const std::size_t M_SAMPLING_RATE;
+	uint64_t m_recordsCount = 0;
+};
+
+} // namespace Sampler
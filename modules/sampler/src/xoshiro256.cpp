@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @brief Implementation of the Xoshiro256 pseudo random number generator.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "xoshiro256.hpp"
+
+namespace Sampler {
+
+static uint64_t rotateLeft(uint64_t value, int shift) noexcept
+{
+	return (value << shift) | (value >> (64 - shift));
+}
+
+static uint64_t splitMix64(uint64_t& state) noexcept
+{
+	uint64_t value = (state += 0x9e3779b97f4a7c15ULL);
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+	return value ^ (value >> 31);
+}
+
+Xoshiro256::Xoshiro256(uint64_t seed) noexcept
+{
+	for (auto& word : m_state) {
+		word = splitMix64(seed);
+	}
+}
+
+uint64_t Xoshiro256::next() noexcept
+{
+	const uint64_t result = rotateLeft(m_state[1] * 5, 7) * 9;
+	const uint64_t shifted = m_state[1] << 17;
+
+	m_state[2] ^= m_state[0];
+	m_state[3] ^= m_state[1];
+	m_state[1] ^= m_state[2];
+	m_state[0] ^= m_state[3];
+	m_state[2] ^= shifted;
+	m_state[3] = rotateLeft(m_state[3], 45);
+
+	return result;
+}
+
+double Xoshiro256::nextUniform() noexcept
+{
+	// Upper 53 bits fill the mantissa, adding one excludes zero
+	constexpr double mantissaUnit = 1.0 / static_cast<double>(1ULL << 53);
+	return static_cast<double>((next() >> 11) + 1) * mantissaUnit;
+}
+
+} // namespace Sampler
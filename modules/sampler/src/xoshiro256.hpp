@@ -0,0 +1,43 @@
+/**
+ * @file
+ * @brief Declaration of the Xoshiro256 pseudo random number generator.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace Sampler {
+
+/**
+ * @brief The xoshiro256** generator of 64-bit pseudo random numbers.
+ *
+ * The state is initialized from the seed by the splitmix64 generator, as recommended by the
+ * authors of xoshiro.
+ */
+class Xoshiro256 {
+public:
+	/**
+	 * @brief Constructs the generator.
+	 * @param seed Seed of the generator.
+	 */
+	explicit Xoshiro256(uint64_t seed) noexcept;
+
+	/**
+	 * @brief Returns the next pseudo random number.
+	 */
+	uint64_t next() noexcept;
+
+	/**
+	 * @brief Returns the next pseudo random number uniformly distributed in the (0, 1] interval.
+	 */
+	double nextUniform() noexcept;
+
+private:
+	std::array<uint64_t, 4> m_state;
+};
+
+} // namespace Sampler
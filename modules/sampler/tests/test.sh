@@ -0,0 +1,271 @@
+#!/bin/bash
+
+function exit_with_error {
+  pkill logger
+  pkill logreplay
+  pkill sampler
+  exit 1
+}
+
+function process_started {
+  pid=$1
+  if ! ps -p $pid > /dev/null
+    then
+      echo "Failed to start process"
+      exit_with_error
+  fi
+}
+
+function fail {
+  echo "$1"
+  exit_with_error
+}
+
+# Replays the input file through the sampler with one logger per output interface. Output of the
+# i-th interface is written to /tmp/res<i>.
+# Arguments: input file, number of outputs, arguments of the sampler
+function run_sampler {
+  input_file=$1
+  outputs_count=$2
+  shift 2
+
+  interfaces="u:lr"
+  logger_pids=()
+  for output in $(seq 1 "$outputs_count"); do
+    rm -f "/tmp/res$output"
+    logger -i "u:sampler$output" -w "/tmp/res$output" &
+    logger_pids+=($!)
+    interfaces="$interfaces,u:sampler$output"
+  done
+  sleep 0.1
+  for logger_pid in "${logger_pids[@]}"; do
+    process_started $logger_pid
+  done
+
+  $sampler -i "$interfaces" "$@" &
+  sampler_pid=$!
+  sleep 0.1
+  process_started $sampler_pid
+
+  logreplay -i "u:lr" -f "$input_file" 2>/dev/null &
+  sleep 0.1
+  process_started $!
+
+  for logger_pid in "${logger_pids[@]}"; do
+    wait $logger_pid
+  done
+  wait $sampler_pid
+}
+
+# Writes records with increasing ID from 1: every 20th record is ICMP, every other 5th record is
+# DNS and the others are HTTPS. The logger prints them as
+# DST_IP,SRC_IP,[SAMPLING_RATE,]ID,DST_PORT,SRC_PORT,PROTOCOL.
+# Arguments: number of records, output file
+function generate_records {
+  awk -v count="$1" 'BEGIN {
+    print "ipaddr SRC_IP,ipaddr DST_IP,uint16 SRC_PORT,uint16 DST_PORT,uint8 PROTOCOL,uint32 ID"
+    for (id = 1; id <= count; id++) {
+      source = "10.0." int(id / 250) "." (id % 250)
+      if (id % 20 == 0) {
+        print source ",192.0.2.1,0,0,1," id
+      } else if (id % 5 == 0) {
+        print source ",192.0.2.53," (1024 + id % 1000) ",53,17," id
+      } else {
+        print source ",192.0.2.80," (1024 + id % 1000) ",443,6," id
+      }
+    }
+  }' > "$2"
+}
+
+# Writes each of the flows in both directions, so the record and the reverse record have the same
+# ID. Arguments: number of flows, output file
+function generate_biflows {
+  awk -v count="$1" 'BEGIN {
+    print "ipaddr SRC_IP,ipaddr DST_IP,uint16 SRC_PORT,uint16 DST_PORT,uint8 PROTOCOL,uint32 ID"
+    for (id = 1; id <= count; id++) {
+      client = "10.1." int(id / 250) "." (id % 250)
+      port = 1024 + id % 60000
+      print client ",192.0.2.80," port ",443,6," id
+      print "192.0.2.80," client ",443," port ",6," id
+    }
+  }' > "$2"
+}
+
+# Writes records with increasing ID from 1 and BYTES weight: every 100th record has 10^9 bytes,
+# every other 7th record has no bytes and the others have 64 to 1463 bytes. The logger prints
+# them as DST_IP,SRC_IP,BYTES,SAMPLING_RATE,ID,DST_PORT,SRC_PORT,PROTOCOL.
+# Arguments: number of records, output file
+function generate_weighted_records {
+  awk -v count="$1" 'BEGIN {
+    print "ipaddr SRC_IP,ipaddr DST_IP,uint16 SRC_PORT,uint16 DST_PORT,uint8 PROTOCOL," \
+      "uint32 ID,uint64 BYTES"
+    for (id = 1; id <= count; id++) {
+      if (id % 100 == 0) {
+        bytes = 1000000000
+      } else if (id % 7 == 0) {
+        bytes = 0
+      } else {
+        bytes = 64 + (id * 37) % 1400
+      }
+      print "10.0." int(id / 250) "." (id % 250) ",192.0.2.80," (1024 + id % 1000) ",443,6," \
+        id "," bytes
+    }
+  }' > "$2"
+}
+
+# Writes the given number of records of each of the flows, the flows are interleaved, so the j-th
+# record of the f-th flow has ID j * flows + f. Arguments: number of flows, number of records of
+# each flow, output file
+function generate_flows {
+  awk -v flows="$1" -v records="$2" 'BEGIN {
+    print "ipaddr SRC_IP,ipaddr DST_IP,uint16 SRC_PORT,uint16 DST_PORT,uint8 PROTOCOL,uint32 ID"
+    for (record = 0; record < records; record++) {
+      for (flow = 1; flow <= flows; flow++) {
+        print "10.2." int(flow / 250) "." (flow % 250) ",192.0.2.80," (1024 + flow) ",443,6," \
+          record * flows + flow
+      }
+    }
+  }' > "$3"
+}
+
+function count_lines {
+  wc -l < "$1" | tr -d ' '
+}
+
+data_path="$(dirname "$0")/testsData"
+sampler=$1
+input_file="/tmp/samplerInput.csv"
+
+set -e
+trap 'echo "Command \"$BASH_COMMAND\" failed!"; exit_with_error' ERR
+
+echo "Running test random"
+generate_records 10000 "$input_file"
+run_sampler "$input_file" 1 --mode random -r 10 --seed 1 --sampling-rate-field
+cp /tmp/res1 /tmp/resRandom
+# 1000 expected records, the bounds are 3 standard deviations
+selected=$(count_lines /tmp/resRandom)
+if [ "$selected" -lt 910 ] || [ "$selected" -gt 1090 ]; then
+  fail "Random mode forwarded $selected of 10000 records with rate 10"
+fi
+if awk -F, '$3 != 10 { exit 1 }' /tmp/resRandom; then :; else
+  fail "Random mode forwarded records with sampling rate other than 10"
+fi
+run_sampler "$input_file" 1 --mode random -r 10 --seed 1 --sampling-rate-field
+if ! cmp -s /tmp/resRandom /tmp/res1; then
+  fail "Random mode forwarded different records with the same seed"
+fi
+
+echo "Running test hash biflow"
+generate_biflows 2000 "$input_file"
+run_sampler "$input_file" 1 --mode hash -r 4 --flow-key biflow --seed 7
+selected=$(count_lines /tmp/res1)
+if [ "$selected" -eq 0 ] || [ "$selected" -eq 4000 ]; then
+  fail "Hash mode forwarded $selected of 4000 records with rate 4"
+fi
+# Both directions of a flow have the same ID, so each forwarded ID must be present twice
+if ! awk -F, '{ count[$3]++ } END { for (id in count) if (count[id] != 2) exit 1 }' /tmp/res1; then
+  fail "Hash mode with the biflow key sampled a flow and its reverse flow differently"
+fi
+
+echo "Running test adaptive"
+generate_records 50000 "$input_file"
+run_sampler "$input_file" 1 --mode adaptive --target-rate 1000 --sampling-rate-field
+# The replay is much faster than the target rate, so after the first clock check the sampling
+# rate must rise and only a small part of the records is forwarded
+selected=$(count_lines /tmp/res1)
+if [ "$selected" -le 64 ] || [ "$selected" -gt 10000 ]; then
+  fail "Adaptive mode forwarded $selected of 50000 records with target rate 1000"
+fi
+if ! tail -n 1 /tmp/res1 | awk -F, '$3 <= 10 { exit 1 }'; then
+  fail "Adaptive mode did not raise the sampling rate above 10 for the fast input"
+fi
+
+echo "Running test priority"
+generate_weighted_records 50000 "$input_file"
+run_sampler "$input_file" 1 --mode priority --target-rate 100000 --window 1 --seed 1
+# The threshold is adapted every millisecond to 100 records. The heavy records are far below the
+# target rate, so the threshold stays below their bytes and they are forwarded with rate 1.
+# Records without bytes are never forwarded.
+# BYTES * SAMPLING_RATE is an unbiased estimate of the bytes, it must be within 5 standard
+# deviations estimated by the sum of (rate^2 - rate) * bytes^2
+total=$(awk -F, 'NR > 1 { total += $7 } END { printf "%.0f", total }' "$input_file")
+if ! awk -F, -v total="$total" '
+  $3 == 0 || $4 < 1 || ($3 >= 1000000000 && $4 != 1) { exit 1 }
+  {
+    heavy += ($3 >= 1000000000)
+    estimate += $3 * $4
+    variance += ($4 * $4 - $4) * $3 * $3
+  }
+  END {
+    if (heavy != 500 || (estimate - total) ^ 2 > 25 * variance + 1) exit 1
+  }' /tmp/res1; then
+  fail "Priority mode forwarded records with wrong sampling rates"
+fi
+
+echo "Running test stratified"
+generate_records 10000 "$input_file"
+run_sampler "$input_file" 1 --mode stratified --strata "$data_path/strata.csv" -r 100
+# 500 ICMP records with rate 1, 1500 DNS records with rate 10, 8000 other records with rate 100
+counts=$(awk -F, '{ count[$6]++ } END { print count[1] + 0, count[17] + 0, count[6] + 0 }' \
+  /tmp/res1)
+if [ "$counts" != "500 150 80" ]; then
+  fail "Stratified mode forwarded ICMP, DNS and other records: $counts, expected 500 150 80"
+fi
+
+echo "Running test reservoir"
+generate_records 10000 "$input_file"
+run_sampler "$input_file" 1 --mode reservoir --reservoir-size 100 --window 60000 --seed 1
+selected=$(count_lines /tmp/res1)
+if [ "$selected" -ne 100 ]; then
+  fail "Reservoir mode forwarded $selected records from the window, expected 100"
+fi
+generate_records 50 "$input_file"
+run_sampler "$input_file" 1 --mode reservoir --reservoir-size 100 --window 60000 --seed 1
+selected=$(count_lines /tmp/res1)
+if [ "$selected" -ne 50 ]; then
+  fail "Reservoir mode forwarded $selected of 50 records, expected all of them"
+fi
+
+echo "Running test fan-out"
+generate_records 1000 "$input_file"
+run_sampler "$input_file" 2 --fan-out systematic:2,systematic:5
+for output_rate in 1:2 2:5; do
+  output=${output_rate%:*}
+  rate=${output_rate#*:}
+  if ! awk -F, -v rate=$rate '$3 % rate != 0 { exit 1 } END { if (NR != 1000 / rate) exit 1 }' \
+    "/tmp/res$output"; then
+    fail "Fan-out output $output did not forward exactly every ${rate}th record"
+  fi
+done
+
+echo "Running test hold"
+generate_flows 2000 10 "$input_file"
+run_sampler "$input_file" 1 --mode hold -r 10 --seed 3 --sampling-rate-field
+# The first forwarded record of a flow has rate 10 and all following records of the flow must be
+# forwarded with rate 1. About 65 % of the flows have some of their 10 records sampled.
+if ! awk -F, '
+  {
+    flow = ($4 - 1) % 2000
+    record = int(($4 - 1) / 2000)
+    if (!(flow in first)) {
+      first[flow] = record
+      if ($3 != 10) exit 1
+    } else if ($3 != 1) {
+      exit 1
+    }
+    count[flow]++
+  }
+  END {
+    for (flow in first) {
+      if (count[flow] != 10 - first[flow]) exit 1
+      held++
+    }
+    if (held < 1000 || held > 1600) exit 1
+  }' /tmp/res1; then
+  fail "Hold mode did not forward all records of sampled flows after the first one"
+fi
+
+rm -f "$input_file" /tmp/resRandom
+echo "All tests passed"
+exit 0
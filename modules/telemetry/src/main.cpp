@@ -10,6 +10,7 @@
  */
 
 #include "factory/pluginFactory.hpp"
+#include "instrumentation/processingLatency.hpp"
 #include "logger/logger.hpp"
 #include "outputPlugin.hpp"
 #include "unirec/unirec-telemetry.hpp"
@@ -29,6 +30,8 @@
 using namespace Nemea;
 
 static std::atomic<bool> g_stopFlag(false);
+static Nm::ProcessingLatency g_processingLatency;
+static Nm::SendStats g_sendStats;
 
 static void signalHandler(int signum)
 {
@@ -56,11 +59,16 @@ static void handleFormatChange(UnirecBidirectionalInterface& biInterface)
  */
 static void processNextRecord(UnirecBidirectionalInterface& biInterface)
 {
+	Nm::PhaseTimer phaseTimer;
 	std::optional<UnirecRecordView> unirecRecord = biInterface.receive();
 	if (!unirecRecord) {
 		return;
 	}
-	biInterface.send(*unirecRecord);
+	phaseTimer.lap(g_processingLatency.receive);
+
+	// Records are only forwarded, so there is no process phase
+	g_sendStats.send(biInterface, *unirecRecord);
+	phaseTimer.lap(g_processingLatency.send);
 }
 
 /**
@@ -154,14 +162,26 @@ int main(int argc, char** argv)
 	try {
 		std::shared_ptr<telemetry::Directory> telemetryRootDirectory;
 		telemetryRootDirectory = telemetry::Directory::create();
+		const auto latencyFile
+			= Nm::addProcessingLatencyFile(telemetryRootDirectory, g_processingLatency);
 
 		UnirecBidirectionalInterface biInterface = unirec.buildBidirectionalInterface();
 
 		auto telemetryInputDirectory = telemetryRootDirectory->addDir("input");
+		const Nm::InterfaceRatesSampler ratesSampler(biInterface, g_sendStats);
 		const telemetry::FileOps inputFileOps
-			= {[&biInterface]() { return Nm::getInterfaceTelemetry(biInterface); }, nullptr};
+			= {[&biInterface, &ratesSampler]() {
+				   return Nm::getInterfaceTelemetry(biInterface, ratesSampler);
+			   },
+			   nullptr};
 		const auto inputFile = telemetryInputDirectory->addFile("stats", inputFileOps);
 
+		auto telemetryOutputDirectory = telemetryRootDirectory->addDir("output");
+		const telemetry::FileOps outputFileOps
+			= {[&ratesSampler]() { return Nm::getSendTelemetry(g_sendStats, ratesSampler); },
+			   nullptr};
+		const auto outputFile = telemetryOutputDirectory->addFile("stats", outputFileOps);
+
 		std::unique_ptr<TelemetryStats::OutputPlugin> outputPlugin;
 
 		auto& outputPluginFactory = Nm::PluginFactory<